@@ -0,0 +1,250 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**Deterministic generated JSON documents used by the benchmarks.
+ * The same seed always produces the same bytes, so results are comparable across commits.
+ */
+namespace bench
+{
+    /**xorshift64*, used rather than <random> so output is identical on every platform.*/
+    class Random
+    {
+    public:
+        explicit Random(uint64_t seed) : state(seed) {}
+
+        uint64_t next()
+        {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return state * 2685821657736338717ULL;
+        }
+        /**Integer in [0, n).*/
+        unsigned below(unsigned n) { return (unsigned)(next() % n); }
+        /**Double in [lo, hi).*/
+        double uniform(double lo, double hi)
+        {
+            return lo + (hi - lo) * ((double)(next() >> 11) / (double)(1ULL << 53));
+        }
+    private:
+        uint64_t state;
+    };
+
+    struct Corpus
+    {
+        std::string name;
+        /**Each document is a complete JSON value. A benchmark "op" processes one document.*/
+        std::vector<std::string> docs;
+
+        size_t bytes()const
+        {
+            size_t n = 0;
+            for (auto &doc : docs) n += doc.size();
+            return n;
+        }
+    };
+
+    namespace detail
+    {
+        inline void append_word(Random &rnd, std::string *out)
+        {
+            static const char *const words[] = {
+                "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "json",
+                "parser", "stream", "token", "value", "hello", "world", "benchmark"
+            };
+            *out += words[rnd.below(sizeof(words) / sizeof(words[0]))];
+        }
+        inline void append_sentence(Random &rnd, unsigned words, std::string *out)
+        {
+            for (unsigned i = 0; i < words; ++i)
+            {
+                if (i) *out += ' ';
+                append_word(rnd, out);
+            }
+        }
+        inline void append_time(Random &rnd, std::string *out)
+        {
+            char buffer[40];
+            snprintf(buffer, sizeof(buffer), "%04u-%02u-%02uT%02u:%02u:%02u.%03uZ",
+                2000 + rnd.below(30), 1 + rnd.below(12), 1 + rnd.below(28),
+                rnd.below(24), rnd.below(60), rnd.below(60), rnd.below(1000));
+            *out += buffer;
+        }
+        inline void append_double(double x, std::string *out)
+        {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%.6f", x);
+            *out += buffer;
+        }
+    }
+
+    /**An array of social media style objects, with nested objects, arrays, maps and text.*/
+    inline Corpus make_tweets(unsigned count = 2000)
+    {
+        Random rnd(1);
+        std::string json = "[";
+        for (unsigned i = 0; i < count; ++i)
+        {
+            if (i) json += ',';
+            json += "\n  {\"id\": " + std::to_string(1000000000000ULL + rnd.below(1000000000));
+            json += ", \"user\": {\"name\": \"";
+            detail::append_sentence(rnd, 2, &json);
+            json += "\", \"screen_name\": \"";
+            detail::append_word(rnd, &json);
+            json += std::to_string(rnd.below(10000));
+            json += "\", \"followers\": " + std::to_string(rnd.below(1000000)) + "}";
+            json += ", \"text\": \"";
+            detail::append_sentence(rnd, 5 + rnd.below(20), &json);
+            json += "\", \"retweets\": " + std::to_string(rnd.below(5000));
+            json += ", \"favorited\": ";
+            json += rnd.below(2) ? "true" : "false";
+            json += ", \"tags\": [";
+            for (unsigned j = 0, n = rnd.below(4); j < n; ++j)
+            {
+                if (j) json += ", ";
+                json += '"';
+                detail::append_word(rnd, &json);
+                json += '"';
+            }
+            json += "], \"counts\": {";
+            for (unsigned j = 0, n = 1 + rnd.below(3); j < n; ++j)
+            {
+                if (j) json += ", ";
+                json += "\"k" + std::to_string(j) + "\": " + std::to_string(rnd.below(100));
+            }
+            json += "}}";
+        }
+        json += "\n]";
+        return { "tweets", { json } };
+    }
+
+    /**A GeoJSON style polygon, almost entirely made up of floating point numbers.*/
+    inline Corpus make_geojson(unsigned rings = 20, unsigned points = 2000)
+    {
+        Random rnd(2);
+        std::string json = "{\"type\": \"Polygon\", \"coordinates\": [";
+        for (unsigned i = 0; i < rings; ++i)
+        {
+            if (i) json += ',';
+            json += "\n  [";
+            for (unsigned j = 0; j < points; ++j)
+            {
+                if (j) json += ',';
+                json += '[';
+                detail::append_double(rnd.uniform(-180, 180), &json);
+                json += ',';
+                detail::append_double(rnd.uniform(-90, 90), &json);
+                json += ']';
+            }
+            json += ']';
+        }
+        json += "\n]}";
+        return { "geojson", { json } };
+    }
+
+    /**Many small documents, each alternating arrays and objects nested depth levels deep.*/
+    inline Corpus make_deep(unsigned count = 200, unsigned depth = 200)
+    {
+        Corpus corpus = { "deep", {} };
+        for (unsigned i = 0; i < count; ++i)
+        {
+            std::string json;
+            for (unsigned j = 0; j < depth; ++j) json += (j % 2) ? "{\"a\":" : "[";
+            json += std::to_string(i);
+            for (unsigned j = depth; j > 0; --j) json += ((j - 1) % 2) ? "}" : "]";
+            corpus.docs.push_back(std::move(json));
+        }
+        return corpus;
+    }
+
+    /**An array of strings full of escape sequences, including unicode surrogate pairs.*/
+    inline Corpus make_escapes(unsigned count = 5000)
+    {
+        static const char *const escapes[] = {
+            "\\n", "\\t", "\\\"", "\\\\", "\\/", "\\u00e9", "\\u20ac", "\\ud83d\\ude00"
+        };
+        Random rnd(3);
+        std::string json = "[";
+        for (unsigned i = 0; i < count; ++i)
+        {
+            if (i) json += ',';
+            json += "\n  \"";
+            for (unsigned j = 0, n = 4 + rnd.below(12); j < n; ++j)
+            {
+                detail::append_word(rnd, &json);
+                json += escapes[rnd.below(sizeof(escapes) / sizeof(escapes[0]))];
+            }
+            json += '"';
+        }
+        json += "\n]";
+        return { "escapes", { json } };
+    }
+
+    /**Many independent small messages, as seen by a request handler.*/
+    inline Corpus make_messages(unsigned count = 20000)
+    {
+        static const char *const ops[] = { "get", "set", "delete", "increment" };
+        Random rnd(4);
+        Corpus corpus = { "messages", {} };
+        for (unsigned i = 0; i < count; ++i)
+        {
+            std::string json = "{\"id\": " + std::to_string(i);
+            json += ", \"op\": \"";
+            json += ops[rnd.below(4)];
+            json += "\", \"key\": \"";
+            detail::append_word(rnd, &json);
+            json += std::to_string(rnd.below(1000));
+            json += "\", \"value\": ";
+            detail::append_double(rnd.uniform(0, 1000), &json);
+            json += "}";
+            corpus.docs.push_back(std::move(json));
+        }
+        return corpus;
+    }
+
+    /**Documents each with a large text body, as in content or file APIs.*/
+    inline Corpus make_documents(unsigned count = 100, unsigned body_size = 64 * 1024)
+    {
+        Random rnd(6);
+        Corpus corpus = { "documents", {} };
+        for (unsigned i = 0; i < count; ++i)
+        {
+            std::string json = "{\"id\": " + std::to_string(i) + ", \"title\": \"";
+            detail::append_sentence(rnd, 4, &json);
+            json += "\", \"body\": \"";
+            auto body_start = json.size();
+            while (json.size() - body_start < body_size)
+            {
+                detail::append_sentence(rnd, 10 + rnd.below(20), &json);
+                json += ".\\n";
+            }
+            json += "\"}";
+            corpus.docs.push_back(std::move(json));
+        }
+        return corpus;
+    }
+
+    /**An array of timestamped events, as found in logs and event streams.*/
+    inline Corpus make_events(unsigned count = 10000)
+    {
+        static const char *const types[] = { "click", "view", "purchase", "login" };
+        Random rnd(5);
+        std::string json = "[";
+        for (unsigned i = 0; i < count; ++i)
+        {
+            if (i) json += ',';
+            json += "\n  {\"type\": \"";
+            json += types[rnd.below(4)];
+            json += "\", \"start\": \"";
+            detail::append_time(rnd, &json);
+            json += "\", \"end\": \"";
+            detail::append_time(rnd, &json);
+            json += "\"}";
+        }
+        json += "\n]";
+        return { "events", { json } };
+    }
+}
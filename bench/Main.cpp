@@ -0,0 +1,627 @@
+/**Throughput benchmarks.
+ *
+ * Usage: bench [--time=SECONDS] [FILTER]
+ *
+ * Each benchmark/corpus pair runs for at least the given time (default 0.5s), and a single line
+ * of JSON is written to stdout with the results, so output can be collected and compared across
+ * commits. Only benchmarks whose "benchmark/corpus" name contains FILTER are run.
+ */
+#include "Canonical.hpp"
+#include "Cbor.hpp"
+#include "ColumnarReader.hpp"
+#include "Copy.hpp"
+#include "Enum.hpp"
+#include "FragmentCache.hpp"
+#include "IovecWriter.hpp"
+#include "MergePatch.hpp"
+#include "Parallel.hpp"
+#include "Reader.hpp"
+#include "Validate.hpp"
+#include "Writer.hpp"
+#include "Corpus.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace json;
+
+namespace
+{
+    struct User
+    {
+        std::string name;
+        std::string screen_name;
+        unsigned followers;
+    };
+    struct Tweet
+    {
+        unsigned long long id;
+        User user;
+        std::string text;
+        unsigned retweets;
+        bool favorited;
+        std::vector<std::string> tags;
+        std::map<std::string, int> counts;
+    };
+    struct Geometry
+    {
+        std::string type;
+        std::vector<std::vector<std::vector<double>>> coordinates;
+    };
+    struct Message
+    {
+        unsigned id;
+        std::string op;
+        std::string key;
+        double value;
+    };
+    struct Event
+    {
+        std::string type;
+        std::chrono::system_clock::time_point start;
+        time_t end;
+    };
+    enum class EventType { CLICK, VIEW, PURCHASE, LOGIN };
+    const EnumTable<EventType> event_types = {
+        { "click", EventType::CLICK },
+        { "view", EventType::VIEW },
+        { "purchase", EventType::PURCHASE },
+        { "login", EventType::LOGIN }
+    };
+    /**Event with the type as an enum, see run_enum.*/
+    struct EnumEvent
+    {
+        EventType type;
+        std::chrono::system_clock::time_point start;
+        time_t end;
+    };
+    /**Event with the type interned, see run_interned.*/
+    struct InternedEvent
+    {
+        InternedString type;
+        std::chrono::system_clock::time_point start;
+        time_t end;
+    };
+
+    /**Events as columns, see run_columnar.*/
+    struct EventColumns
+    {
+        StringColumn type;
+        Column<time_t> start;
+        Column<time_t> end;
+    };
+
+    struct Document
+    {
+        unsigned id;
+        std::string title;
+        std::string body;
+    };
+
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, Document *val)
+    {
+        static const auto reader = ObjectFieldReader<Document, ErrorUnknown, ParserT>().
+            template add<decltype(Document::id), &Document::id>("id").
+            template add<decltype(Document::title), &Document::title>("title").
+            template add<decltype(Document::body), &Document::body>("body");
+        reader.read(parser, val);
+    }
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, Event *val)
+    {
+        static const auto reader = ObjectFieldReader<Event, ErrorUnknown, ParserT>().
+            template add<decltype(Event::type), &Event::type>("type").
+            template add<decltype(Event::start), &Event::start>("start").
+            template add<time_t, &Event::end, read_json_time>("end");
+        reader.read(parser, val);
+    }
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, EventType *val)
+    {
+        read_json_enum(parser, val, event_types);
+    }
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, EnumEvent *val)
+    {
+        static const auto reader = ObjectFieldReader<EnumEvent, ErrorUnknown, ParserT>().
+            template add<decltype(EnumEvent::type), &EnumEvent::type>("type").
+            template add<decltype(EnumEvent::start), &EnumEvent::start>("start").
+            template add<time_t, &EnumEvent::end, read_json_time>("end");
+        reader.read(parser, val);
+    }
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, InternedEvent *val)
+    {
+        static const auto reader = ObjectFieldReader<InternedEvent, ErrorUnknown, ParserT>().
+            template add<decltype(InternedEvent::type), &InternedEvent::type>("type").
+            template add<decltype(InternedEvent::start), &InternedEvent::start>("start").
+            template add<time_t, &InternedEvent::end, read_json_time>("end");
+        reader.read(parser, val);
+    }
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, User *val)
+    {
+        static const auto reader = ObjectFieldReader<User, ErrorUnknown, ParserT>().
+            template add<decltype(User::name), &User::name>("name").
+            template add<decltype(User::screen_name), &User::screen_name>("screen_name").
+            template add<decltype(User::followers), &User::followers>("followers");
+        reader.read(parser, val);
+    }
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, Tweet *val)
+    {
+        static const auto reader = ObjectFieldReader<Tweet, ErrorUnknown, ParserT>().
+            template add<decltype(Tweet::id), &Tweet::id>("id").
+            template add<decltype(Tweet::user), &Tweet::user>("user").
+            template add<decltype(Tweet::text), &Tweet::text>("text").
+            template add<decltype(Tweet::retweets), &Tweet::retweets>("retweets").
+            template add<decltype(Tweet::favorited), &Tweet::favorited>("favorited").
+            template add<decltype(Tweet::tags), &Tweet::tags>("tags").
+            template add<decltype(Tweet::counts), &Tweet::counts>("counts");
+        reader.read(parser, val);
+    }
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, Geometry *val)
+    {
+        static const auto reader = ObjectFieldReader<Geometry, ErrorUnknown, ParserT>().
+            template add<decltype(Geometry::type), &Geometry::type>("type").
+            template add<decltype(Geometry::coordinates), &Geometry::coordinates>("coordinates");
+        reader.read(parser, val);
+    }
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, Message *val)
+    {
+        static const auto reader = ObjectFieldReader<Message, ErrorUnknown, ParserT>().
+            template add<decltype(Message::id), &Message::id>("id").
+            template add<decltype(Message::op), &Message::op>("op").
+            template add<decltype(Message::key), &Message::key>("key").
+            template add<decltype(Message::value), &Message::value>("value");
+        reader.read(parser, val);
+    }
+
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const Document &val)
+    {
+        writer.start_obj();
+        writer.prop("id", val.id);
+        writer.prop("title", val.title);
+        writer.prop("body", val.body);
+        writer.end_obj();
+    }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const Event &val)
+    {
+        writer.start_obj();
+        writer.prop("type", val.type);
+        writer.prop("start", val.start);
+        writer.key("end");
+        write_json_time(writer, val.end);
+        writer.end_obj();
+    }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, EventType val)
+    {
+        write_json_enum(writer, val, event_types);
+    }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const EnumEvent &val)
+    {
+        writer.start_obj();
+        writer.prop("type", val.type);
+        writer.prop("start", val.start);
+        writer.key("end");
+        write_json_time(writer, val.end);
+        writer.end_obj();
+    }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const User &val)
+    {
+        writer.start_obj();
+        writer.prop("name", val.name);
+        writer.prop("screen_name", val.screen_name);
+        writer.prop("followers", val.followers);
+        writer.end_obj();
+    }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const Tweet &val)
+    {
+        writer.start_obj();
+        writer.prop("id", val.id);
+        writer.prop("user", val.user);
+        writer.prop("text", val.text);
+        writer.prop("retweets", val.retweets);
+        writer.prop("favorited", val.favorited);
+        writer.prop("tags", val.tags);
+        writer.key("counts");
+        writer.start_obj();
+        for (auto &i : val.counts) writer.prop(i.first, i.second);
+        writer.end_obj();
+        writer.end_obj();
+    }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const Geometry &val)
+    {
+        writer.start_obj();
+        writer.prop("type", val.type);
+        writer.prop("coordinates", val.coordinates);
+        writer.end_obj();
+    }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const Message &val)
+    {
+        writer.start_obj();
+        writer.prop("id", val.id);
+        writer.prop("op", val.op);
+        writer.prop("key", val.key);
+        writer.prop("value", val.value);
+        writer.end_obj();
+    }
+
+    Parser make_parser(const std::string &doc)
+    {
+        return Parser(doc.data(), doc.data() + doc.size());
+    }
+
+    struct Options
+    {
+        double min_time = 0.5;
+        std::string filter;
+    };
+
+    /**Prevents the optimiser from removing unused results.*/
+    volatile size_t sink;
+
+    /**Run func on every document in corpus repeatedly for at least options.min_time, then
+     * print the result as a line of JSON.
+     */
+    template<typename F>
+    void run(const Options &options, const char *benchmark, const bench::Corpus &corpus, F func)
+    {
+        auto name = std::string(benchmark) + "/" + corpus.name;
+        if (name.find(options.filter) == std::string::npos) return;
+
+        typedef std::chrono::steady_clock clock;
+        size_t result = 0;
+        for (auto &doc : corpus.docs) result += func(doc); //warm up
+        size_t iterations = 0;
+        auto start = clock::now();
+        std::chrono::duration<double> elapsed;
+        do
+        {
+            for (auto &doc : corpus.docs) result += func(doc);
+            ++iterations;
+            elapsed = clock::now() - start;
+        }
+        while (elapsed.count() < options.min_time);
+        sink = result;
+
+        double ops = (double)iterations * (double)corpus.docs.size();
+        double bytes = (double)iterations * (double)corpus.bytes();
+        Writer writer;
+        writer.start_obj();
+        writer.prop("benchmark", benchmark);
+        writer.prop("corpus", corpus.name);
+        writer.prop("bytes", corpus.bytes());
+        writer.prop("docs", corpus.docs.size());
+        writer.prop("iterations", iterations);
+        writer.prop("ns_per_op", elapsed.count() * 1e9 / ops);
+        writer.prop("mb_per_s", bytes / elapsed.count() / (1024 * 1024));
+        writer.end_obj();
+        std::cout << writer.str() << std::endl;
+    }
+
+    size_t tokenize(const std::string &doc)
+    {
+        auto parser = make_parser(doc);
+        size_t count = 0;
+        while (parser.next().type != Token::END) ++count;
+        return count;
+    }
+    /**tokenize with CountStats, to measure the cost of instrumentation.*/
+    size_t tokenize_stats(const std::string &doc)
+    {
+        StatsData data;
+        {
+            BasicParser<CountStats> parser(doc.data(), doc.data() + doc.size(),
+                std::pmr::get_default_resource(), CountStats(&data));
+            while (parser.next().type != Token::END);
+        }
+        return data.tokens;
+    }
+    /**tokenize with UTF-8 validation of strings.*/
+    size_t tokenize_utf8(const std::string &doc)
+    {
+        auto parser = make_parser(doc);
+        parser.validate_utf8(true);
+        size_t count = 0;
+        while (parser.next().type != Token::END) ++count;
+        return count;
+    }
+    size_t validate_doc(const std::string &doc)
+    {
+        return json::validate(doc.data(), doc.data() + doc.size());
+    }
+    size_t skip(const std::string &doc)
+    {
+        auto parser = make_parser(doc);
+        skip_value(parser);
+        return 1;
+    }
+    size_t copy_doc(const std::string &doc)
+    {
+        auto parser = make_parser(doc);
+        Writer writer;
+        json::copy(writer, parser);
+        return writer.str().size();
+    }
+
+    size_t hash_doc(const std::string &doc)
+    {
+        return (size_t)canonical_hash(doc);
+    }
+    /**Compare each document with a copy of itself, so every value is compared.*/
+    size_t equal_doc(const std::string &doc)
+    {
+        static std::string other;
+        other = doc;
+        return equal(doc, other) ? 1 : 0;
+    }
+
+    /**Benchmarks for a corpus that can be read into T.*/
+    template<typename T>
+    void run_typed(const Options &options, const bench::Corpus &corpus)
+    {
+        run(options, "read", corpus, [](const std::string &doc)
+        {
+            auto val = json::read_json<T>(doc);
+            return sizeof(val);
+        });
+
+        std::vector<T> values;
+        for (auto &doc : corpus.docs) values.push_back(json::read_json<T>(doc));
+        bench::Corpus written = { corpus.name, {} };
+        for (auto &val : values) written.docs.push_back(to_json(val));
+        size_t i = 0;
+        // the written corpus is used for the byte count, as whitespace differs from the input
+        run(options, "write", written, [&](const std::string &)
+        {
+            auto str = to_json(values[i]);
+            if (++i == values.size()) i = 0;
+            return str.size();
+        });
+        i = 0;
+        run(options, "write_exact", written, [&](const std::string &)
+        {
+            auto str = to_json_exact(values[i]);
+            if (++i == values.size()) i = 0;
+            return str.size();
+        });
+
+        // every document cut off half way, for the cost of rejecting malformed input
+        bench::Corpus truncated = { corpus.name, {} };
+        for (auto &doc : corpus.docs) truncated.docs.push_back(doc.substr(0, doc.size() / 2));
+        run(options, "read_invalid", truncated, [](const std::string &doc) -> size_t
+        {
+            try
+            {
+                json::read_json<T>(doc);
+            }
+            catch (const ParseError &e)
+            {
+                return e.offset();
+            }
+            return 0;
+        });
+        run(options, "try_read_invalid", truncated, [](const std::string &doc)
+        {
+            T val;
+            return try_read_json(doc, &val).offset;
+        });
+
+        bench::Corpus encoded = { corpus.name, {} };
+        for (auto &val : values) encoded.docs.push_back(to_cbor(val));
+        run(options, "read_cbor", encoded, [](const std::string &doc)
+        {
+            auto val = read_cbor<T>(doc);
+            return sizeof(val);
+        });
+        i = 0;
+        run(options, "write_cbor", encoded, [&](const std::string &)
+        {
+            auto str = to_cbor(values[i]);
+            if (++i == values.size()) i = 0;
+            return str.size();
+        });
+    }
+
+    /**Writing documents to a file descriptor, either with to_json and write, or referencing the
+     * bodies in place with an IovecWriter and writev.
+     */
+    void run_fd(const Options &options, const bench::Corpus &corpus)
+    {
+        std::vector<Document> values;
+        for (auto &doc : corpus.docs) values.push_back(json::read_json<Document>(doc));
+        bench::Corpus written = { corpus.name, {} };
+        for (auto &val : values) written.docs.push_back(to_json(val));
+        int fd = open("/dev/null", O_WRONLY);
+        if (fd < 0) return;
+        size_t i = 0;
+        run(options, "write_fd", written, [&](const std::string &)
+        {
+            auto str = to_json(values[i]);
+            if (++i == values.size()) i = 0;
+            return (size_t)::write(fd, str.data(), str.size());
+        });
+        i = 0;
+        run(options, "writev_fd", written, [&](const std::string &)
+        {
+            auto &val = values[i];
+            if (++i == values.size()) i = 0;
+            IovecWriter writer;
+            writer.start_obj();
+            writer.prop("id", val.id);
+            writer.prop("title", val.title);
+            writer.key("body");
+            writer.str_value_ref(val.body);
+            writer.end_obj();
+            writer.str().write_to(fd);
+            return writer.str().size();
+        });
+        close(fd);
+    }
+
+    /**Writing arrays of tweets where every tweet is in a FragmentCache, so after the warm up
+     * each is copied instead of serialised.
+     */
+    void run_cached(const Options &options, const bench::Corpus &corpus)
+    {
+        std::vector<std::vector<Tweet>> values;
+        for (auto &doc : corpus.docs) values.push_back(json::read_json<std::vector<Tweet>>(doc));
+        bench::Corpus written = { corpus.name, {} };
+        for (auto &val : values) written.docs.push_back(to_json(val));
+        FragmentCache cache;
+        size_t i = 0;
+        run(options, "write_cached", written, [&](const std::string &)
+        {
+            auto &val = values[i];
+            if (++i == values.size()) i = 0;
+            Writer writer;
+            writer.start_arr();
+            for (auto &tweet : val) cache.write(writer, tweet, 0);
+            writer.end_arr();
+            return writer.str().size();
+        });
+    }
+
+    /**to_json_parallel for a corpus of arrays, using every hardware thread.*/
+    template<typename T>
+    void run_parallel(const Options &options, const bench::Corpus &corpus)
+    {
+        std::vector<std::vector<T>> values;
+        for (auto &doc : corpus.docs) values.push_back(json::read_json<std::vector<T>>(doc));
+        bench::Corpus written = { corpus.name, {} };
+        for (auto &val : values) written.docs.push_back(to_json(val));
+        size_t i = 0;
+        run(options, "write_parallel", written, [&](const std::string &)
+        {
+            auto str = to_json_parallel(values[i]);
+            if (++i == values.size()) i = 0;
+            return str.size();
+        });
+    }
+
+    /**Reading events with the type strings in an InternTable.*/
+    void run_interned(const Options &options, const bench::Corpus &corpus)
+    {
+        InternTable table;
+        run(options, "read_interned", corpus, [&](const std::string &doc)
+        {
+            auto parser = make_parser(doc);
+            parser.intern_table(&table);
+            auto val = json::read_json<std::vector<InternedEvent>>(parser);
+            return val.size();
+        });
+    }
+
+    /**Reading events into columns, compare with read/events.*/
+    void run_columnar(const Options &options, const bench::Corpus &corpus)
+    {
+        static const auto reader = ColumnarReader<EventColumns>().
+            add<decltype(EventColumns::type), &EventColumns::type>("type").
+            add<decltype(EventColumns::start), &EventColumns::start, read_json_time>("start").
+            add<decltype(EventColumns::end), &EventColumns::end, read_json_time>("end");
+        run(options, "read_columnar", corpus, [&](const std::string &doc)
+        {
+            EventColumns columns;
+            auto parser = make_parser(doc);
+            reader.read(parser, &columns);
+            return columns.type.size();
+        });
+    }
+
+    /**Base64 blobs, against reading the same strings and decoding them in a second pass.*/
+    void run_base64(const Options &options)
+    {
+        std::vector<Blob> blobs(256);
+        unsigned x = 1;
+        for (auto &blob : blobs)
+        {
+            for (int i = 0; i < 3000; ++i)
+            {
+                x = x * 1103515245 + 12345;
+                blob.bytes.push_back((unsigned char)(x >> 16));
+            }
+        }
+        bench::Corpus corpus = { "blobs", { to_json(blobs) } };
+        run(options, "read_base64", corpus, [](const std::string &doc)
+        {
+            return json::read_json<std::vector<Blob>>(doc).size();
+        });
+        run(options, "read_base64_two_pass", corpus, [](const std::string &doc)
+        {
+            auto strs = json::read_json<std::vector<std::string>>(doc);
+            std::vector<Blob> out(strs.size());
+            for (size_t i = 0; i < strs.size(); ++i)
+            {
+                out[i].bytes.resize(base64::max_decoded_size(strs[i].size()));
+                out[i].bytes.resize((size_t)base64::decode(strs[i], out[i].bytes.data()));
+            }
+            return out.size();
+        });
+        run(options, "write_base64", corpus, [&](const std::string &)
+        {
+            return to_json(blobs).size();
+        });
+    }
+
+    /**Applying a small merge patch to each document, against reading and writing it.*/
+    void run_patch(const Options &options, const bench::Corpus &corpus)
+    {
+        MergePatch patch("{\"title\": \"Patched\", \"tags\": [\"new\"]}");
+        run(options, "merge_patch", corpus, [&](const std::string &doc)
+        {
+            return apply_merge_patch(doc, patch).size();
+        });
+    }
+
+    Options parse_options(int argc, char *argv[])
+    {
+        Options options;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg.compare(0, 7, "--time=") == 0) options.min_time = std::atof(arg.c_str() + 7);
+            else options.filter = arg;
+        }
+        return options;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    auto options = parse_options(argc, argv);
+    const bench::Corpus corpora[] = {
+        bench::make_tweets(),
+        bench::make_geojson(),
+        bench::make_deep(),
+        bench::make_escapes(),
+        bench::make_messages(),
+        bench::make_events(),
+        bench::make_documents()
+    };
+
+    for (auto &corpus : corpora)
+    {
+        run(options, "tokenize", corpus, tokenize);
+        run(options, "tokenize_stats", corpus, tokenize_stats);
+        run(options, "tokenize_utf8", corpus, tokenize_utf8);
+        run(options, "validate", corpus, validate_doc);
+        run(options, "skip", corpus, skip);
+        run(options, "copy", corpus, copy_doc);
+        run(options, "canonical_hash", corpus, hash_doc);
+        run(options, "equal", corpus, equal_doc);
+    }
+    run_typed<std::vector<Tweet>>(options, corpora[0]);
+    run_typed<Geometry>(options, corpora[1]);
+    run_typed<std::vector<std::string>>(options, corpora[3]);
+    run_typed<Message>(options, corpora[4]);
+    run_typed<std::vector<Event>>(options, corpora[5]);
+    run_typed<Document>(options, corpora[6]);
+    run_fd(options, corpora[6]);
+    run_patch(options, corpora[6]);
+    run_cached(options, corpora[0]);
+    run_parallel<Tweet>(options, corpora[0]);
+    run_parallel<Event>(options, corpora[5]);
+    run_interned(options, corpora[5]);
+    run_columnar(options, corpora[5]);
+    run_base64(options);
+    run_typed<std::vector<EnumEvent>>(options, bench::Corpus{ "events_enum", corpora[5].docs });
+    return 0;
+}
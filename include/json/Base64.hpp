@@ -0,0 +1,149 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+namespace json
+{
+    /**Binary data, read from and written to JSON as a base64 string without an intermediate
+     * copy of the text. See read_json_base64 and write_json_base64 for other byte vectors.
+     */
+    struct Blob
+    {
+        std::vector<unsigned char> bytes;
+
+        bool operator == (const Blob &other)const { return bytes == other.bytes; }
+        bool operator != (const Blob &other)const { return bytes != other.bytes; }
+    };
+
+    /**Base64 (RFC 4648) encoding and decoding with the standard alphabet, as used for binary
+     * values in JSON strings.
+     */
+    namespace base64
+    {
+        /**Length of the padded encoding of len bytes.*/
+        inline size_t encoded_size(size_t len)
+        {
+            return (len + 2) / 3 * 4;
+        }
+        /**Upper bound of the decoded length of len characters.*/
+        inline size_t max_decoded_size(size_t len)
+        {
+            return (len + 3) / 4 * 3;
+        }
+
+        namespace detail
+        {
+            /**Pairs of characters for every 12 bit value, so 3 bytes are encoded with 2 lookups.*/
+            inline const uint16_t *encode_table()
+            {
+                static const struct Table
+                {
+                    uint16_t pairs[4096];
+                    Table()
+                    {
+                        const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+                        for (unsigned i = 0; i < 4096; ++i)
+                        {
+                            // stored in memory order, independent of endianness
+                            auto bytes = (unsigned char*)&pairs[i];
+                            bytes[0] = (unsigned char)alphabet[i >> 6];
+                            bytes[1] = (unsigned char)alphabet[i & 63];
+                        }
+                    }
+                } table;
+                return table.pairs;
+            }
+            /**6 bit value of each character, or 0xFF for characters outside the alphabet.*/
+            inline const uint8_t *decode_table()
+            {
+                static const struct Table
+                {
+                    uint8_t values[256];
+                    Table()
+                    {
+                        const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+                        for (auto &x : values) x = 0xFF;
+                        for (unsigned i = 0; i < 64; ++i) values[(unsigned char)alphabet[i]] = (uint8_t)i;
+                    }
+                } table;
+                return table.values;
+            }
+        }
+
+        /**Encode len bytes from data into out, which must have space for encoded_size(len).
+         * Returns the number of characters written.
+         */
+        inline size_t encode(const void *data, size_t len, char *out)
+        {
+            auto pairs = detail::encode_table();
+            auto in = (const unsigned char*)data;
+            auto start = out;
+            size_t i = 0;
+            for (; i + 3 <= len; i += 3)
+            {
+                uint32_t x = ((uint32_t)in[i] << 16) | ((uint32_t)in[i + 1] << 8) | in[i + 2];
+                auto a = pairs[x >> 12], b = pairs[x & 0xFFF];
+                auto p = (const char*)&a, q = (const char*)&b;
+                out[0] = p[0];
+                out[1] = p[1];
+                out[2] = q[0];
+                out[3] = q[1];
+                out += 4;
+            }
+            if (i < len)
+            {
+                uint32_t x = (uint32_t)in[i] << 16;
+                if (i + 1 < len) x |= (uint32_t)in[i + 1] << 8;
+                auto a = pairs[x >> 12], b = pairs[x & 0xFFF];
+                auto p = (const char*)&a, q = (const char*)&b;
+                out[0] = p[0];
+                out[1] = p[1];
+                out[2] = i + 1 < len ? q[0] : '=';
+                out[3] = '=';
+                out += 4;
+            }
+            return (size_t)(out - start);
+        }
+
+        /**Decode str into out, which must have space for max_decoded_size(str.size()).
+         * Padding is optional. Returns the number of bytes written, or -1 if str has characters
+         * outside the alphabet or an impossible length.
+         */
+        inline ptrdiff_t decode(std::string_view str, unsigned char *out)
+        {
+            auto values = detail::decode_table();
+            auto in = (const unsigned char*)str.data();
+            size_t len = str.size();
+            if (len % 4 == 0 && len >= 4)
+            {
+                if (in[len - 1] == '=') --len;
+                if (in[len - 1] == '=') --len;
+            }
+            if (len % 4 == 1) return -1;
+            auto start = out;
+            size_t i = 0;
+            for (; i + 4 <= len; i += 4)
+            {
+                uint32_t a = values[in[i]], b = values[in[i + 1]], c = values[in[i + 2]], d = values[in[i + 3]];
+                if ((a | b | c | d) & 0x80) return -1;
+                uint32_t x = (a << 18) | (b << 12) | (c << 6) | d;
+                out[0] = (unsigned char)(x >> 16);
+                out[1] = (unsigned char)(x >> 8);
+                out[2] = (unsigned char)x;
+                out += 3;
+            }
+            if (i < len)
+            {
+                // 2 or 3 characters for 1 or 2 bytes
+                uint32_t a = values[in[i]], b = values[in[i + 1]];
+                uint32_t c = i + 2 < len ? values[in[i + 2]] : 0;
+                if ((a | b | c) & 0x80) return -1;
+                uint32_t x = (a << 18) | (b << 12) | (c << 6);
+                *out++ = (unsigned char)(x >> 16);
+                if (i + 2 < len) *out++ = (unsigned char)(x >> 8);
+            }
+            return out - start;
+        }
+    }
+}
@@ -0,0 +1,299 @@
+#pragma once
+#include "Reader.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+namespace json
+{
+    /**@file Comparing JSON values by meaning rather than text, without building a document tree.
+     *
+     * Values are the same if they only differ in whitespace, object key order, string escapes
+     * (e.g. "\u0041" and "A") or the spelling of numbers. Numbers that are integers fitting a
+     * 64 bit int (including 1.0 and 1e2) are compared exactly, others as doubles.
+     */
+
+    namespace detail
+    {
+        /**A number reduced to an exact integer where possible, else a double.*/
+        struct CanonicalNumber
+        {
+            bool is_int;
+            long long i;
+            double d;
+
+            bool operator == (const CanonicalNumber &other)const
+            {
+                return is_int == other.is_int && (is_int ? i == other.i : d == other.d);
+            }
+        };
+        inline CanonicalNumber canonical_number(double d)
+        {
+            if (d == std::floor(d) && d >= -9223372036854775808.0 && d < 9223372036854775808.0)
+            {
+                return { true, (long long)d, 0.0 };
+            }
+            return { false, 0, d };
+        }
+        inline CanonicalNumber canonical_number(const Token &tok)
+        {
+            if (tok.type == Token::INTEGER) return { true, tok.val_int, 0.0 };
+            if (tok.type == Token::NUMBER) return canonical_number(tok.val_num);
+            long long i;
+            if (tok.val_raw.to_int(&i)) return { true, i, 0.0 };
+            double d;
+            tok.val_raw.to_double(&d);
+            return canonical_number(d);
+        }
+        inline bool is_number(const Token &tok)
+        {
+            return tok.type == Token::INTEGER || tok.type == Token::NUMBER || tok.type == Token::RAW_NUMBER;
+        }
+
+        /**Final mix of a 64 bit hash (from splitmix64).*/
+        inline uint64_t hash_mix(uint64_t x)
+        {
+            x ^= x >> 30;
+            x *= 0xBF58476D1CE4E5B9ull;
+            x ^= x >> 27;
+            x *= 0x94D049BB133111EBull;
+            x ^= x >> 31;
+            return x;
+        }
+        /**FNV-1a of a string, starting from seed.*/
+        inline uint64_t hash_bytes(const std::string &str, uint64_t seed)
+        {
+            uint64_t h = 0xCBF29CE484222325ull ^ seed;
+            for (char c : str) h = (h ^ (unsigned char)c) * 0x100000001B3ull;
+            return hash_mix(h);
+        }
+
+        enum : uint64_t
+        {
+            HASH_NULL = 1, HASH_TRUE, HASH_FALSE, HASH_STRING, HASH_INT, HASH_DOUBLE, HASH_ARRAY, HASH_OBJECT
+        };
+
+        /**Hash the value starting with tok, which is nested in depth arrays and objects.*/
+        template<typename ParserT>
+        uint64_t hash_value(ParserT &parser, const Token &tok, size_t depth)
+        {
+            switch (tok.type)
+            {
+            case Token::NULL_VAL: return hash_mix(HASH_NULL);
+            case Token::TRUE_VAL: return hash_mix(HASH_TRUE);
+            case Token::FALSE_VAL: return hash_mix(HASH_FALSE);
+            case Token::STRING: return hash_bytes(tok.str, HASH_STRING);
+            case Token::INTEGER:
+            case Token::NUMBER:
+            case Token::RAW_NUMBER:
+            {
+                auto x = canonical_number(tok);
+                if (x.is_int) return hash_mix(hash_mix(HASH_INT) ^ (uint64_t)x.i);
+                uint64_t bits;
+                std::memcpy(&bits, &x.d, sizeof(bits));
+                return hash_mix(hash_mix(HASH_DOUBLE) ^ bits);
+            }
+            case Token::ARR_START:
+            {
+                // elements are combined in order
+                if (depth >= parser.max_depth()) return parser.fail(ParseErrorCode::DEPTH_EXCEEDED), 0;
+                uint64_t h = hash_mix(HASH_ARRAY);
+                if (parser.try_next_arr_end()) return h;
+                Token next;
+                do
+                {
+                    h = hash_mix(h * 31 + hash_value(parser, parser.next(), depth + 1));
+                    next = parser.next();
+                }
+                while (next.type == Token::ELEMENT_SEP);
+                if (next.type != Token::ARR_END) parser.fail(ParseErrorCode::EXPECTED_ARRAY_END);
+                return h;
+            }
+            case Token::OBJ_START:
+            {
+                // members are summed, so the order does not matter
+                if (depth >= parser.max_depth()) return parser.fail(ParseErrorCode::DEPTH_EXCEEDED), 0;
+                uint64_t sum = 0, count = 0;
+                if (!parser.try_next_obj_end())
+                {
+                    Token next;
+                    do
+                    {
+                        auto key = parser.next();
+                        if (key.type != Token::STRING) return parser.fail(ParseErrorCode::EXPECTED_STRING), 0;
+                        auto key_hash = hash_bytes(key.str, HASH_STRING);
+                        if (parser.next().type != Token::KEY_SEP) return parser.fail(ParseErrorCode::EXPECTED_KEY_SEP), 0;
+                        sum += hash_mix(key_hash * 31 + hash_value(parser, parser.next(), depth + 1));
+                        ++count;
+                        next = parser.next();
+                    }
+                    while (next.type == Token::ELEMENT_SEP);
+                    if (next.type != Token::OBJ_END) parser.fail(ParseErrorCode::EXPECTED_OBJECT_END);
+                }
+                return hash_mix(hash_mix(HASH_OBJECT) ^ sum ^ (count << 32));
+            }
+            default: return parser.fail(ParseErrorCode::EXPECTED_VALUE), 0;
+            }
+        }
+    }
+
+    /**Hash the next value in parser, so that values that are the same by the rules above have
+     * the same hash. Works with any parser type, e.g. JSON and CBOR of the same value hash the
+     * same.
+     */
+    template<typename ParserT>
+    if_parser<ParserT, uint64_t> canonical_hash(ParserT &parser)
+    {
+        detail::RawNumberScope<ParserT> raw_numbers(parser);
+        return detail::hash_value(parser, parser.next(), 0);
+    }
+    /**Hash a complete JSON document, see canonical_hash(ParserT&).*/
+    inline uint64_t canonical_hash(const std::string &json)
+    {
+        Parser parser(json.data(), json.data() + json.size());
+        auto h = canonical_hash(parser);
+        if (parser.next().type != Token::END) parser.fail(ParseErrorCode::EXPECTED_END);
+        return h;
+    }
+
+    namespace detail
+    {
+        template<typename StatsA, typename StatsB>
+        bool equal_value(BasicParser<StatsA> &a, BasicParser<StatsB> &b, size_t depth);
+
+        /**Compare the rest of two objects once their keys are in a different order. The
+         * remaining members of b are indexed by key to the input text of their values, which
+         * are then parsed again to compare with the values from a.
+         *
+         * A key repeated in the rest of either object makes them different, since the members
+         * can then not be matched one to one. canonical_hash sums every member, so values this
+         * finds equal always hash the same.
+         */
+        template<typename StatsA, typename StatsB>
+        bool equal_obj_unordered(BasicParser<StatsA> &a, BasicParser<StatsB> &b,
+            std::string a_key, std::string b_key, size_t depth)
+        {
+            struct Range
+            {
+                const char *begin, *end;
+                bool used;
+            };
+            std::unordered_map<std::string, Range> members;
+            size_t b_count = 0;
+            while (true)
+            {
+                auto start = b.position();
+                skip_value(b);
+                members[std::move(b_key)] = { start, b.position(), false };
+                ++b_count;
+                auto next = b.next();
+                if (next.type == Token::OBJ_END) break;
+                if (next.type != Token::ELEMENT_SEP) return b.fail(ParseErrorCode::EXPECTED_OBJECT_END), false;
+                b_key = b.next_str();
+                b.next_key_sep();
+            }
+            size_t matched = 0;
+            while (true)
+            {
+                auto it = members.find(a_key);
+                if (it == members.end() || it->second.used) return false;
+                it->second.used = true;
+                ++matched;
+                Parser value(it->second.begin, it->second.end);
+                if (!equal_value(a, value, depth)) return false;
+                auto next = a.next();
+                if (next.type == Token::OBJ_END) break;
+                if (next.type != Token::ELEMENT_SEP) return a.fail(ParseErrorCode::EXPECTED_OBJECT_END), false;
+                a_key = a.next_str();
+                a.next_key_sep();
+            }
+            return matched == b_count;
+        }
+
+        /**Compare two objects after their OBJ_START, with members at depth. Members are compared in step while the
+         * keys match, which is the common case for documents from the same source.
+         */
+        template<typename StatsA, typename StatsB>
+        bool equal_obj(BasicParser<StatsA> &a, BasicParser<StatsB> &b, size_t depth)
+        {
+            bool a_end = a.try_next_obj_end(), b_end = b.try_next_obj_end();
+            while (!a_end && !b_end)
+            {
+                auto a_key = a.next_str();
+                a.next_key_sep();
+                auto b_key = b.next_str();
+                b.next_key_sep();
+                if (a_key != b_key) return equal_obj_unordered(a, b, std::move(a_key), std::move(b_key), depth);
+                if (!equal_value(a, b, depth)) return false;
+                auto a_next = a.next(), b_next = b.next();
+                if (a_next.type != Token::ELEMENT_SEP && a_next.type != Token::OBJ_END) return a.fail(ParseErrorCode::EXPECTED_OBJECT_END), false;
+                if (b_next.type != Token::ELEMENT_SEP && b_next.type != Token::OBJ_END) return b.fail(ParseErrorCode::EXPECTED_OBJECT_END), false;
+                a_end = a_next.type == Token::OBJ_END;
+                b_end = b_next.type == Token::OBJ_END;
+            }
+            return a_end && b_end;
+        }
+
+        template<typename StatsA, typename StatsB>
+        bool equal_arr(BasicParser<StatsA> &a, BasicParser<StatsB> &b, size_t depth)
+        {
+            bool a_end = a.try_next_arr_end(), b_end = b.try_next_arr_end();
+            while (!a_end && !b_end)
+            {
+                if (!equal_value(a, b, depth)) return false;
+                auto a_next = a.next(), b_next = b.next();
+                if (a_next.type != Token::ELEMENT_SEP && a_next.type != Token::ARR_END) return a.fail(ParseErrorCode::EXPECTED_ARRAY_END), false;
+                if (b_next.type != Token::ELEMENT_SEP && b_next.type != Token::ARR_END) return b.fail(ParseErrorCode::EXPECTED_ARRAY_END), false;
+                a_end = a_next.type == Token::ARR_END;
+                b_end = b_next.type == Token::ARR_END;
+            }
+            return a_end && b_end;
+        }
+
+        /**Compare the next values, which are nested in depth arrays and objects.*/
+        template<typename StatsA, typename StatsB>
+        bool equal_value(BasicParser<StatsA> &a, BasicParser<StatsB> &b, size_t depth)
+        {
+            RawNumberScope<BasicParser<StatsA>> a_raw(a);
+            RawNumberScope<BasicParser<StatsB>> b_raw(b);
+            auto ta = a.next(), tb = b.next();
+            if (is_number(ta)) return is_number(tb) && canonical_number(ta) == canonical_number(tb);
+            switch (ta.type)
+            {
+            case Token::NULL_VAL:
+            case Token::TRUE_VAL:
+            case Token::FALSE_VAL:
+                return ta.type == tb.type;
+            case Token::STRING: return tb.type == Token::STRING && ta.str == tb.str;
+            case Token::ARR_START:
+            case Token::OBJ_START:
+                if (tb.type != ta.type) return false;
+                if (depth >= a.max_depth()) return a.fail(ParseErrorCode::DEPTH_EXCEEDED), false;
+                return ta.type == Token::ARR_START ? equal_arr(a, b, depth + 1) : equal_obj(a, b, depth + 1);
+            default: return a.fail(ParseErrorCode::EXPECTED_VALUE), false;
+            }
+        }
+    }
+
+    /**Compare the next values of two JSON parsers by meaning, see canonical_hash.
+     * Returns as soon as a difference is found, leaving both parsers part way through the value.
+     * Objects with keys in the same order are compared in a single pass. Otherwise the rest of
+     * the object in b is indexed and its member values parsed again as needed.
+     */
+    template<typename StatsA, typename StatsB>
+    bool equal(BasicParser<StatsA> &a, BasicParser<StatsB> &b)
+    {
+        return detail::equal_value(a, b, 0);
+    }
+    /**Compare two complete JSON documents by meaning.*/
+    inline bool equal(const std::string &a, const std::string &b)
+    {
+        Parser pa(a.data(), a.data() + a.size()), pb(b.data(), b.data() + b.size());
+        if (!equal(pa, pb)) return false;
+        if (pa.next().type != Token::END) pa.fail(ParseErrorCode::EXPECTED_END);
+        if (pb.next().type != Token::END) pb.fail(ParseErrorCode::EXPECTED_END);
+        return true;
+    }
+}
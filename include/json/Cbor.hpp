@@ -0,0 +1,1055 @@
+#pragma once
+#include "Base64.hpp"
+#include "Reader.hpp"
+#include "Writer.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+namespace json
+{
+    /**@file CBOR (RFC 8949) encoding with the same token level API as BasicParser and BasicWriter.
+     *
+     * Types with read_json and write_json overloads that are templates over the parser and writer
+     * type (see if_parser and if_writer) can be read and written as CBOR without any changes,
+     * and ObjectFieldReader can be used with a CborParser as its ParserT.
+     *
+     * Numbers are stored in binary, and strings as a length and raw bytes, so there is no text
+     * formatting or escaping. Arrays and objects are written with indefinite lengths, so the
+     * writer does not need to know the number of elements up front. The parser accepts both
+     * definite and indefinite lengths.
+     *
+     * Blob and other base64 byte vectors are written as native byte strings. Where a byte
+     * string is read as a token by next(), such as in copy, it becomes a base64 STRING.
+     */
+    namespace cbor
+    {
+        enum MajorType : unsigned
+        {
+            UNSIGNED = 0,
+            NEGATIVE = 1,
+            BYTES = 2,
+            TEXT = 3,
+            ARRAY = 4,
+            MAP = 5,
+            TAG = 6,
+            SIMPLE = 7
+        };
+        static const unsigned char FALSE_BYTE = 0xF4;
+        static const unsigned char TRUE_BYTE = 0xF5;
+        static const unsigned char NULL_BYTE = 0xF6;
+        static const unsigned char UNDEFINED_BYTE = 0xF7;
+        static const unsigned char FLOAT32_BYTE = 0xFA;
+        static const unsigned char FLOAT64_BYTE = 0xFB;
+        static const unsigned char BREAK_BYTE = 0xFF;
+        /**Additional information value for indefinite length items.*/
+        static const unsigned INDEFINITE_INFO = 31;
+    }
+
+    /**Writes CBOR to a byte buffer.
+     * Provides the same methods as BasicWriter, so write_json overloads that are templates over
+     * the writer type work with either.
+     */
+    template<typename Stats = NoStats>
+    class CborWriter : private Stats
+    {
+    public:
+        typedef Stats StatsType;
+
+        explicit CborWriter(Stats stats = Stats()) : Stats(stats), buf() {}
+        CborWriter(const CborWriter&) = delete;
+        CborWriter& operator = (const CborWriter&) = delete;
+
+        /**The encoded bytes.*/
+        std::string& str() { return buf; }
+        /**The instrumentation policy.*/
+        Stats &stats() { return *this; }
+
+        void start_arr()
+        {
+            stats().token();
+            put((char)((cbor::ARRAY << 5) | cbor::INDEFINITE_INFO));
+        }
+        void end_arr()
+        {
+            put((char)cbor::BREAK_BYTE);
+        }
+        void start_obj()
+        {
+            stats().token();
+            put((char)((cbor::MAP << 5) | cbor::INDEFINITE_INFO));
+        }
+        void end_obj()
+        {
+            put((char)cbor::BREAK_BYTE);
+        }
+
+        void null()
+        {
+            stats().token();
+            put((char)cbor::NULL_BYTE);
+        }
+        void do_value(bool b)
+        {
+            stats().token();
+            put((char)(b ? cbor::TRUE_BYTE : cbor::FALSE_BYTE));
+        }
+        /**Written as a 32bit float if that is exact, else a 64bit float.*/
+        void do_value(double x)
+        {
+            stats().token();
+            stats().number(true);
+            // narrowing a finite double outside the float range is undefined, so check it first
+            bool as_float = !std::isfinite(x) ||
+                (std::fabs(x) <= (double)std::numeric_limits<float>::max() && (double)(float)x == x);
+            if (as_float)
+            {
+                float f = (float)x;
+                uint32_t bits;
+                memcpy(&bits, &f, sizeof(bits));
+                put((char)cbor::FLOAT32_BYTE);
+                put_be(bits, 4);
+            }
+            else
+            {
+                uint64_t bits;
+                memcpy(&bits, &x, sizeof(bits));
+                put((char)cbor::FLOAT64_BYTE);
+                put_be(bits, 8);
+            }
+        }
+        void do_value(long long x)
+        {
+            stats().token();
+            stats().number(false);
+            if (x >= 0) head(cbor::UNSIGNED, (uint64_t)x);
+            else head(cbor::NEGATIVE, ~(uint64_t)x); // -1 - x
+        }
+        void do_value(unsigned long long x)
+        {
+            stats().token();
+            stats().number(false);
+            head(cbor::UNSIGNED, x);
+        }
+        /**Write a number from JSON text as an integer if it fits, else as a float.*/
+        void do_value(const RawNumber &x)
+        {
+            long long i;
+            unsigned long long u;
+            double d;
+            if (x.to_int(&i)) do_value(i);
+            else if (x.to_uint(&u)) do_value(u);
+            else
+            {
+                x.to_double(&d);
+                do_value(d);
+            }
+        }
+        void do_value(const char *str)
+        {
+            do_value(str, strlen(str));
+        }
+        void do_value(const char *str, size_t len)
+        {
+            stats().token();
+            stats().string(false);
+            head(cbor::TEXT, len);
+            append(str, len);
+        }
+
+        void plain_str_value(const char *str, size_t len)
+        {
+            do_value(str, len);
+        }
+        /**Write len bytes from data as a byte string, see write_json_base64.*/
+        void bytes_value(const void *data, size_t len)
+        {
+            stats().token();
+            stats().string(false);
+            head(cbor::BYTES, len);
+            append((const char*)data, len);
+        }
+
+        void key(const char *str)
+        {
+            do_value(str);
+        }
+        void key(const std::string &str)
+        {
+            do_value(str.data(), str.size());
+        }
+
+        /**Writes an object key, then using write_json to write the value.*/
+        template<class T> void prop(const char *str, T &&val)
+        {
+            key(str);
+            value(std::forward<T>(val));
+        }
+        template<class T> void prop(const std::string &str, T &&val)
+        {
+            key(str);
+            value(std::forward<T>(val));
+        }
+
+        /**Writes a value by forwarding to a write_json overload.*/
+        template<typename T> void value(const T &v)
+        {
+            write_json(*this, v);
+        }
+    private:
+        std::string buf;
+
+        void head(unsigned major, uint64_t arg)
+        {
+            char type = (char)(major << 5);
+            if (arg < 24) put((char)(type | arg));
+            else if (arg <= 0xFF)
+            {
+                put((char)(type | 24));
+                put_be(arg, 1);
+            }
+            else if (arg <= 0xFFFF)
+            {
+                put((char)(type | 25));
+                put_be(arg, 2);
+            }
+            else if (arg <= 0xFFFFFFFF)
+            {
+                put((char)(type | 26));
+                put_be(arg, 4);
+            }
+            else
+            {
+                put((char)(type | 27));
+                put_be(arg, 8);
+            }
+        }
+        /**Write the low len bytes of x, most significant first.*/
+        void put_be(uint64_t x, size_t len)
+        {
+            char bytes[8];
+            for (size_t i = 0; i < len; ++i) bytes[i] = (char)(x >> (8 * (len - 1 - i)));
+            append(bytes, len);
+        }
+        void put(char c)
+        {
+            if (Stats::enabled) record_append(1);
+            buf += c;
+        }
+        void append(const char *str, size_t len)
+        {
+            if (Stats::enabled) record_append(len);
+            buf.append(str, len);
+        }
+        void record_append(size_t len)
+        {
+            stats().bytes(len);
+            if (buf.size() + len > buf.capacity()) stats().allocation();
+        }
+    };
+
+    template<typename Stats> struct is_writer<CborWriter<Stats>> : public std::true_type {};
+
+    /**Parses CBOR input as the same sequence of tokens that BasicParser produces for the
+     * equivalent JSON, so generic read_json overloads, ObjectFieldReader and copy work unchanged.
+     *
+     * CBOR has no separators, so ',' and ':' tokens are generated from the position within
+     * each array and object. Text and byte strings are both read as strings, tags are ignored,
+     * and undefined is read as null.
+     */
+    template<typename Stats = NoStats>
+    class CborParser : private Stats
+    {
+    public:
+        typedef Stats StatsType;
+
+        CborParser(const char *begin, const char *end,
+            std::pmr::memory_resource *resource = std::pmr::get_default_resource(),
+            Stats stats = Stats())
+            : Stats(stats)
+            , begin(begin), p(begin), end(end)
+            , levels(), sep_pending(false), done(false)
+            , mem_resource(resource), interns(nullptr), check_utf8(false), raw_nums(false)
+            , depth_limit(DEFAULT_MAX_DEPTH), nesting(0)
+        {}
+        ~CborParser()
+        {
+            if (Stats::enabled) stats().bytes((size_t)(p - begin));
+        }
+
+        /**The memory resource for allocator-aware values read from this parser.*/
+        std::pmr::memory_resource *resource()const { return mem_resource; }
+        /**The table for InternedString values read from this parser, which is not owned.*/
+        void intern_table(InternTable *table) { interns = table; }
+        InternTable *intern_table()const { return interns; }
+        /**The instrumentation policy.*/
+        Stats &stats() { return *this; }
+
+        /**Enable or disable rejecting text strings that are not valid UTF-8.*/
+        void validate_utf8(bool enable) { check_utf8 = enable; }
+        bool validate_utf8()const { return check_utf8; }
+
+        /**Enable or disable returning integers outside the range of long long from next() as
+         * RAW_NUMBER tokens, see BasicParser::raw_numbers. The text is held by the parser and
+         * is only valid until the next call to next(). When disabled they are read as doubles.
+         */
+        void raw_numbers(bool enable) { raw_nums = enable; }
+        bool raw_numbers()const { return raw_nums; }
+
+        /**The deepest nesting of arrays and maps, see BasicParser::max_depth. Unlike
+         * BasicParser this is also checked by the parser itself, as it tracks every level.
+         */
+        void max_depth(size_t depth) { depth_limit = depth; }
+        size_t max_depth()const { return depth_limit; }
+        /**See BasicParser::enter_nested.*/
+        bool enter_nested()
+        {
+            if (nesting >= depth_limit) fail(ParseErrorCode::DEPTH_EXCEEDED);
+            ++nesting;
+            return true;
+        }
+        void exit_nested() { --nesting; }
+
+        /**Report an error at the current byte, see BasicParser::fail. Always throws ParseError,
+         * the CBOR parser has no non-throwing mode.
+         */
+        [[noreturn]] void fail(ParseErrorCode code, const std::string &detail = std::string())
+        {
+            throw ParseError(code, 0, 0, (size_t)(p - begin), detail);
+        }
+
+        /**Parse the next token in the input.*/
+        Token next()
+        {
+            stats().token();
+            if (sep_pending)
+            {
+                if (levels.empty())
+                {
+                    if (done) fail(ParseErrorCode::UNEXPECTED_END);
+                    done = true;
+                    if (p != end) fail(ParseErrorCode::EXPECTED_END);
+                    return Token::END;
+                }
+                auto &level = levels.back();
+                if (level.obj && !level.key_next)
+                {
+                    sep_pending = false;
+                    return Token::KEY_SEP;
+                }
+                if (at_container_end()) return end_container() ? Token::OBJ_END : Token::ARR_END;
+                sep_pending = false;
+                return Token::ELEMENT_SEP;
+            }
+            if (!levels.empty() && at_container_end())
+            {
+                return end_container() ? Token::OBJ_END : Token::ARR_END;
+            }
+            if (levels.empty() && p == end)
+            {
+                if (done) fail(ParseErrorCode::UNEXPECTED_END);
+                done = true;
+                return Token::END;
+            }
+
+            begin_item();
+            auto head = next_head();
+            switch (head.major)
+            {
+            case cbor::UNSIGNED:
+            case cbor::NEGATIVE:
+                stats().number(false);
+                end_item();
+                if (head.arg <= (uint64_t)std::numeric_limits<long long>::max())
+                {
+                    return Token(head.major == cbor::UNSIGNED ? (long long)head.arg : -1 - (long long)head.arg);
+                }
+                return wide_int_token(head);
+            case cbor::BYTES:
+            {
+                // as base64 text, so copying to JSON gives a string read_json_base64 accepts
+                std::vector<unsigned char> bytes;
+                read_str(head, &bytes);
+                Token tok = Token::STRING;
+                tok.str.resize(base64::encoded_size(bytes.size()));
+                tok.str.resize(base64::encode(bytes.data(), bytes.size(), &tok.str[0]));
+                return tok;
+            }
+            case cbor::TEXT:
+            {
+                Token tok = Token::STRING;
+                read_str(head, &tok.str);
+                return tok;
+            }
+            case cbor::ARRAY:
+                push_container(head, false);
+                return Token::ARR_START;
+            case cbor::MAP:
+                push_container(head, true);
+                return Token::OBJ_START;
+            default:
+                assert(head.major == cbor::SIMPLE);
+                switch (head.info)
+                {
+                case 20: end_item(); return Token::FALSE_VAL;
+                case 21: end_item(); return Token::TRUE_VAL;
+                case 22:
+                case 23: end_item(); return Token::NULL_VAL;
+                case 25:
+                case 26:
+                case 27:
+                {
+                    stats().number(true);
+                    double x = simple_to_double(head);
+                    end_item();
+                    return Token(x);
+                }
+                default: fail(ParseErrorCode::UNEXPECTED_CONTENT, "(unsupported simple value)");
+                }
+            }
+        }
+
+        /**If the next token would be ARR_END, consume it and return true.*/
+        bool try_next_arr_end()
+        {
+            return try_next_end(false);
+        }
+        /**If the next value is null or undefined, consume it and return true.*/
+        bool try_next_null()
+        {
+            if (sep_pending || done || p == end) return false;
+            if (!levels.empty() && (levels.back().remaining == 0 || (levels.back().obj && levels.back().key_next))) return false;
+            auto b = (unsigned char)*p;
+            if (b != cbor::NULL_BYTE && b != cbor::UNDEFINED_BYTE) return false;
+            ++p;
+            stats().token();
+            end_item();
+            return true;
+        }
+
+        /**Read the next byte string, appending it to out, see read_json_base64.
+         * A text string is decoded as base64, as written when JSON is copied to CBOR.
+         */
+        template<typename Alloc> void next_bytes(std::vector<unsigned char, Alloc> *out)
+        {
+            begin_item();
+            auto start = p;
+            auto head = next_head();
+            if (head.major != cbor::BYTES && head.major != cbor::TEXT) fail(ParseErrorCode::EXPECTED_STRING, "(byte string)");
+            stats().token();
+            if (head.major == cbor::BYTES) return read_str(head, out);
+
+            std::string text;
+            read_str(head, &text);
+            auto size = out->size();
+            out->resize(size + base64::max_decoded_size(text.size()));
+            auto len = base64::decode(text, out->data() + size);
+            if (len < 0)
+            {
+                out->resize(size);
+                p = start;
+                fail(ParseErrorCode::INVALID_BASE64);
+            }
+            out->resize(size + (size_t)len);
+        }
+
+        /**Read the next string, but discard the contents. */
+        void skip_next_str()
+        {
+            begin_item();
+            auto head = next_head();
+            if (head.major != cbor::TEXT) fail(ParseErrorCode::EXPECTED_STRING);
+            stats().token();
+            if (head.arg == INDEFINITE)
+            {
+                std::string tmp;
+                read_str(head, &tmp);
+            }
+            else
+            {
+                auto len = check_len(head.arg);
+                check_str_utf8(p, p + len);
+                p += len;
+                stats().string(false);
+                end_item();
+            }
+        }
+        /**Read the next string. */
+        std::string next_str()
+        {
+            std::string tmp;
+            next_str(&tmp);
+            return tmp;
+        }
+        /**Read the next string, appending it to out.*/
+        template<typename Str> void next_str(Str *out)
+        {
+            begin_item();
+            auto head = next_head();
+            if (head.major != cbor::TEXT) fail(ParseErrorCode::EXPECTED_STRING);
+            stats().token();
+            read_str(head, out);
+        }
+
+        /**Read the next string without copying it where possible, see BasicParser::next_str_view.
+         * Definite length strings are returned from the input bytes, and indefinite length ones
+         * are joined in buffer.
+         */
+        std::string_view next_str_view(std::string *buffer)
+        {
+            begin_item();
+            auto head = next_head();
+            if (head.major != cbor::TEXT) fail(ParseErrorCode::EXPECTED_STRING);
+            stats().token();
+            if (head.arg == INDEFINITE)
+            {
+                buffer->clear();
+                read_str(head, buffer);
+                return *buffer;
+            }
+            auto len = check_len(head.arg);
+            check_str_utf8(p, p + len);
+            auto str = p;
+            p += len;
+            stats().string(false);
+            end_item();
+            return std::string_view(str, len);
+        }
+        /**Read the next string and get its handle from table.
+         * Definite length strings are looked up directly from the input bytes.
+         */
+        InternedString next_interned_str(InternTable &table)
+        {
+            std::string tmp;
+            return table.intern(next_str_view(&tmp));
+        }
+
+        /**If the next object key is key, consume it and return true, else consume nothing.
+         * Keys are compared directly against the input bytes.
+         */
+        bool try_next_key(const char *key, size_t len)
+        {
+            auto start = p;
+            begin_key();
+            auto head = next_head();
+            if (head.major != cbor::TEXT) fail(ParseErrorCode::EXPECTED_STRING);
+            if (head.arg == INDEFINITE)
+            {
+                std::string tmp;
+                read_str(head, &tmp);
+                if (tmp.size() == len && memcmp(tmp.data(), key, len) == 0) return next_key_sep(), true;
+                unread_key(start);
+                return false;
+            }
+            auto str_len = check_len(head.arg);
+            if (str_len != len || memcmp(p, key, len) != 0)
+            {
+                p = start;
+                return false;
+            }
+            stats().token();
+            p += len;
+            stats().string(false);
+            end_item();
+            next_key_sep();
+            return true;
+        }
+        template<size_t N>
+        bool try_next_key(const char (&key)[N])
+        {
+            return try_next_key(key, N - 1);
+        }
+        /**Read the next object key and return its index in table, or KeyTable::npos, in which case
+         * the key is stored in unknown if not null.
+         */
+        size_t next_key(const KeyTable &table, std::string *unknown = nullptr)
+        {
+            begin_key();
+            auto head = next_head();
+            if (head.major != cbor::TEXT) fail(ParseErrorCode::EXPECTED_STRING);
+            stats().token();
+            size_t index;
+            if (head.arg == INDEFINITE)
+            {
+                std::string tmp;
+                read_str(head, &tmp);
+                index = table.find(tmp);
+                if (index == KeyTable::npos && unknown) *unknown = std::move(tmp);
+            }
+            else
+            {
+                auto len = check_len(head.arg);
+                index = table.find(p, len);
+                if (index == KeyTable::npos)
+                {
+                    check_str_utf8(p, p + len);
+                    if (unknown) unknown->assign(p, len);
+                }
+                p += len;
+                stats().string(false);
+                end_item();
+            }
+            next_key_sep();
+            return index;
+        }
+
+        /**Read the next string as an ISO 8601 time, see try_parse_iso_time.*/
+        time_t next_time()
+        {
+            long long secs;
+            unsigned nanos;
+            next_iso_time<std::chrono::seconds>(&secs, &nanos);
+            return (time_t)secs;
+        }
+        /**Read the next string as an ISO 8601 time, truncated to the precision of Duration.*/
+        template<typename Duration = std::chrono::system_clock::duration>
+        std::chrono::time_point<std::chrono::system_clock, Duration> next_time_point()
+        {
+            long long secs;
+            unsigned nanos;
+            next_iso_time<Duration>(&secs, &nanos);
+            return detail::make_time_point<Duration>(secs, nanos);
+        }
+
+        template<typename T> T next_int()
+        {
+            typedef std::numeric_limits<T> limits;
+            begin_item();
+            auto head = next_head();
+            stats().token();
+            typename Stats::Timer timer(*this, StatsCategory::NUMBER);
+            stats().number(false);
+            T x;
+            if (head.major == cbor::UNSIGNED)
+            {
+                if (head.arg > (uint64_t)limits::max()) fail(ParseErrorCode::NUMBER_OVERFLOW);
+                x = (T)head.arg;
+            }
+            else if (head.major == cbor::NEGATIVE)
+            {
+                if (!limits::is_signed || head.arg > (uint64_t)limits::max()) fail(ParseErrorCode::NUMBER_OVERFLOW);
+                x = (T)(-1 - (T)head.arg);
+            }
+            else fail(ParseErrorCode::EXPECTED_INT);
+            end_item();
+            return x;
+        }
+        template<typename T> T next_uint()
+        {
+            begin_item();
+            auto head = next_head();
+            stats().token();
+            typename Stats::Timer timer(*this, StatsCategory::NUMBER);
+            stats().number(false);
+            if (head.major != cbor::UNSIGNED) fail(ParseErrorCode::EXPECTED_INT);
+            if (head.arg > (uint64_t)std::numeric_limits<T>::max()) fail(ParseErrorCode::NUMBER_OVERFLOW);
+            end_item();
+            return (T)head.arg;
+        }
+        double next_double()
+        {
+            begin_item();
+            auto head = next_head();
+            stats().token();
+            typename Stats::Timer timer(*this, StatsCategory::NUMBER);
+            stats().number(true);
+            double x;
+            if (head.major == cbor::UNSIGNED) x = (double)head.arg;
+            else if (head.major == cbor::NEGATIVE) x = -1.0 - (double)head.arg;
+            else if (head.major == cbor::SIMPLE && head.info >= 25 && head.info <= 27) x = simple_to_double(head);
+            else fail(ParseErrorCode::EXPECTED_NUMBER);
+            end_item();
+            return x;
+        }
+
+        //Objects
+        void next_obj_start()
+        {
+            begin_item();
+            auto head = next_head();
+            if (head.major != cbor::MAP) fail(ParseErrorCode::EXPECTED_OBJECT);
+            stats().token();
+            push_container(head, true);
+        }
+        /**Next ':' key-value seperator, which is implicit in CBOR.*/
+        void next_key_sep()
+        {
+            if (!sep_pending || levels.empty() || !levels.back().obj || levels.back().key_next)
+                fail(ParseErrorCode::EXPECTED_KEY_SEP);
+            stats().token();
+            sep_pending = false;
+        }
+        /**true if there is another key-value pair, false if at the end of the object.*/
+        bool next_obj_el()
+        {
+            if (!sep_pending || levels.empty() || !levels.back().obj || !levels.back().key_next)
+                fail(ParseErrorCode::EXPECTED_OBJECT_END);
+            stats().token();
+            if (at_container_end())
+            {
+                end_container();
+                return false;
+            }
+            sep_pending = false;
+            return true;
+        }
+        /**If the next token would be OBJ_END, consume it and return true.*/
+        bool try_next_obj_end()
+        {
+            return try_next_end(true);
+        }
+    private:
+        static constexpr uint64_t INDEFINITE = ~(uint64_t)0;
+
+        struct Head
+        {
+            unsigned major;
+            unsigned info;
+            /**Value, length, or the raw bits of a float. INDEFINITE for indefinite lengths.*/
+            uint64_t arg;
+        };
+        struct Level
+        {
+            bool obj;
+            /**For objects, the next item is a key rather than a value.*/
+            bool key_next;
+            /**Items (keys and values) left in a definite length container, or INDEFINITE.*/
+            uint64_t remaining;
+        };
+
+        const char *begin, *p, *end;
+        std::vector<Level> levels;
+        /**A complete value or key was read, so the next token is a seperator or container end.*/
+        bool sep_pending;
+        /**END has been returned.*/
+        bool done;
+        std::pmr::memory_resource *mem_resource;
+        InternTable *interns;
+        bool check_utf8;
+        bool raw_nums;
+        /**Text of the last RAW_NUMBER token, "-18446744073709551616" is the longest.*/
+        char raw_num_buf[24];
+        size_t depth_limit;
+        /**Arrays and maps currently open in read_json.*/
+        size_t nesting;
+
+        /**An integer too large for a long long, either a magnitude above 2^63 - 1 or a negative
+         * below -2^63. A RAW_NUMBER token if raw_numbers is enabled, else a NUMBER.
+         */
+        Token wide_int_token(const Head &head)
+        {
+            bool negative = head.major == cbor::NEGATIVE;
+            if (!raw_nums) return Token(negative ? -1.0 - (double)head.arg : (double)head.arg);
+            char *out = raw_num_buf;
+            if (negative) *out++ = '-';
+            if (negative && head.arg == std::numeric_limits<uint64_t>::max())
+            {
+                // -1 - arg is -2^64, one more than fits in a uint64_t
+                static const char min[] = "18446744073709551616";
+                memcpy(out, min, sizeof(min) - 1);
+                out += sizeof(min) - 1;
+            }
+            else out = std::to_chars(out, raw_num_buf + sizeof(raw_num_buf), negative ? head.arg + 1 : head.arg).ptr;
+            return Token(RawNumber{ raw_num_buf, (unsigned)(out - raw_num_buf), negative ? (unsigned)RawNumber::NEGATIVE : 0U });
+        }
+
+        Head next_head()
+        {
+            for (;;)
+            {
+                if (p >= end) fail(ParseErrorCode::UNEXPECTED_END);
+                auto b = (unsigned char)*p++;
+                Head head = { (unsigned)(b >> 5), (unsigned)(b & 0x1F), 0 };
+                if (head.info < 24) head.arg = head.info;
+                else if (head.info <= 27)
+                {
+                    size_t len = (size_t)1 << (head.info - 24);
+                    if ((size_t)(end - p) < len) fail(ParseErrorCode::UNEXPECTED_END);
+                    for (size_t i = 0; i < len; ++i) head.arg = (head.arg << 8) | (unsigned char)p[i];
+                    p += len;
+                }
+                else if (head.info == cbor::INDEFINITE_INFO &&
+                    head.major >= cbor::BYTES && head.major <= cbor::MAP)
+                {
+                    head.arg = INDEFINITE;
+                }
+                else if (head.info == cbor::INDEFINITE_INFO && head.major == cbor::SIMPLE)
+                {
+                    --p;
+                    fail(ParseErrorCode::UNEXPECTED_CONTENT, "(break)");
+                }
+                else fail(ParseErrorCode::UNEXPECTED_CONTENT, "(invalid additional information)");
+
+                if (head.major != cbor::TAG) return head;
+            }
+        }
+        /**Check that a length fits in the remaining input, which also protects against huge
+         * allocations from malicious lengths.
+         */
+        size_t check_len(uint64_t len)
+        {
+            if (len > (uint64_t)(end - p)) fail(ParseErrorCode::UNEXPECTED_END);
+            return (size_t)len;
+        }
+        static double simple_to_double(const Head &head)
+        {
+            if (head.info == 27)
+            {
+                double x;
+                memcpy(&x, &head.arg, sizeof(x));
+                return x;
+            }
+            if (head.info == 26)
+            {
+                auto bits = (uint32_t)head.arg;
+                float x;
+                memcpy(&x, &bits, sizeof(x));
+                return x;
+            }
+            // IEEE 754 half precision
+            unsigned half = (unsigned)head.arg;
+            int exp = (half >> 10) & 0x1F;
+            double mant = half & 0x3FF;
+            double x;
+            if (exp == 0) x = std::ldexp(mant, -24);
+            else if (exp != 31) x = std::ldexp(mant + 1024, exp - 25);
+            else x = mant == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+            return (half & 0x8000) ? -x : x;
+        }
+
+        void check_str_utf8(const char *str, const char *str_end)
+        {
+            if (!check_utf8) return;
+            auto invalid = find_invalid_utf8(str, str_end);
+            if (invalid != str_end)
+            {
+                p = invalid;
+                fail(ParseErrorCode::INVALID_UTF8);
+            }
+        }
+        /**Read a time string, failing with INVALID_TIME if it is not valid or Duration cannot
+         * hold it.
+         */
+        template<typename Duration>
+        void next_iso_time(long long *secs, unsigned *nanos)
+        {
+            begin_item();
+            auto start = p;
+            auto head = next_head();
+            if (head.major != cbor::TEXT) fail(ParseErrorCode::EXPECTED_STRING);
+            stats().token();
+            bool valid;
+            if (head.arg == INDEFINITE)
+            {
+                std::string tmp;
+                read_str(head, &tmp);
+                valid = try_parse_iso_time(tmp.data(), tmp.size(), secs, nanos);
+            }
+            else
+            {
+                auto len = check_len(head.arg);
+                valid = try_parse_iso_time(p, len, secs, nanos);
+                p += len;
+                stats().string(false);
+                end_item();
+            }
+            if (!valid || !detail::time_point_in_range<Duration>(*secs))
+            {
+                *secs = 0;
+                *nanos = 0;
+                p = start;
+                fail(ParseErrorCode::INVALID_TIME);
+            }
+        }
+
+        /**Read the contents of a string after its head, and complete the item.*/
+        template<typename Str>
+        void read_str(const Head &head, Str *out)
+        {
+            typename Stats::Timer timer(*this, StatsCategory::STRING);
+            auto capacity = out->capacity();
+            if (head.arg != INDEFINITE)
+            {
+                auto len = check_len(head.arg);
+                if (head.major == cbor::TEXT) check_str_utf8(p, p + len);
+                append_str(out, p, len);
+                p += len;
+            }
+            else
+            {
+                // chunks of definite length strings of the same type, until a break
+                while (p < end && (unsigned char)*p != cbor::BREAK_BYTE)
+                {
+                    auto chunk = next_head();
+                    if (chunk.major != head.major || chunk.arg == INDEFINITE)
+                        fail(ParseErrorCode::UNEXPECTED_CONTENT, "(invalid string chunk)");
+                    auto len = check_len(chunk.arg);
+                    if (head.major == cbor::TEXT) check_str_utf8(p, p + len);
+                    append_str(out, p, len);
+                    p += len;
+                }
+                if (p == end) fail(ParseErrorCode::UNEXPECTED_END);
+                ++p; // break
+            }
+            stats().string(false);
+            if (out->capacity() != capacity) stats().allocation();
+            end_item();
+        }
+
+        template<typename Str> static void append_str(Str *out, const char *str, size_t len)
+        {
+            out->append(str, len);
+        }
+        template<typename Alloc>
+        static void append_str(std::vector<unsigned char, Alloc> *out, const char *str, size_t len)
+        {
+            out->insert(out->end(), (const unsigned char*)str, (const unsigned char*)str + len);
+        }
+
+        /**Check a value may be read at the current position.*/
+        void begin_item()
+        {
+            if (sep_pending || done) fail(ParseErrorCode::UNEXPECTED_CONTENT);
+            if (!levels.empty() && levels.back().remaining == 0)
+                fail(levels.back().obj ? ParseErrorCode::EXPECTED_OBJECT_END : ParseErrorCode::EXPECTED_ARRAY_END);
+        }
+        void begin_key()
+        {
+            begin_item();
+            if (levels.empty() || !levels.back().obj || !levels.back().key_next) fail(ParseErrorCode::EXPECTED_STRING);
+        }
+        /**Restore the state before a key read by try_next_key.*/
+        void unread_key(const char *start)
+        {
+            auto &level = levels.back();
+            level.key_next = true;
+            if (level.remaining != INDEFINITE) ++level.remaining;
+            sep_pending = false;
+            p = start;
+        }
+        void end_item()
+        {
+            sep_pending = true;
+            if (!levels.empty())
+            {
+                auto &level = levels.back();
+                if (level.obj) level.key_next = !level.key_next;
+                if (level.remaining != INDEFINITE) --level.remaining;
+            }
+        }
+        void push_container(const Head &head, bool obj)
+        {
+            if (levels.size() >= depth_limit) fail(ParseErrorCode::DEPTH_EXCEEDED);
+            uint64_t remaining = INDEFINITE;
+            if (head.arg != INDEFINITE)
+            {
+                // every item is at least one byte
+                remaining = check_len(head.arg);
+                if (obj) remaining *= 2;
+            }
+            levels.push_back({ obj, true, remaining });
+            sep_pending = false;
+        }
+        bool at_container_end()
+        {
+            auto &level = levels.back();
+            if (level.remaining != INDEFINITE) return level.remaining == 0;
+            if (p == end) fail(ParseErrorCode::UNEXPECTED_END);
+            return (unsigned char)*p == cbor::BREAK_BYTE;
+        }
+        /**Consume the end of the current container, returns true if it was an object.*/
+        bool end_container()
+        {
+            auto &level = levels.back();
+            bool obj = level.obj;
+            if (obj && !level.key_next) fail(ParseErrorCode::EXPECTED_VALUE);
+            if (level.remaining == INDEFINITE) ++p; // break
+            levels.pop_back();
+            end_item();
+            return obj;
+        }
+        bool try_next_end(bool obj)
+        {
+            if (levels.empty() || levels.back().obj != obj) return false;
+            if (sep_pending && obj && !levels.back().key_next) return false;
+            if (!at_container_end()) return false;
+            stats().token();
+            end_container();
+            return true;
+        }
+    };
+
+    template<typename Stats> struct is_parser<CborParser<Stats>> : public std::true_type {};
+
+    /**CBOR has native byte strings, so bytes are written without base64.*/
+    template<typename Stats>
+    void write_json_base64(CborWriter<Stats> &writer, const void *data, size_t len)
+    {
+        writer.bytes_value(data, len);
+    }
+    /**Read a byte string, appending it to out. Text strings are decoded as base64.*/
+    template<typename Stats, typename Alloc>
+    void read_json_base64(CborParser<Stats> &parser, std::vector<unsigned char, Alloc> *out)
+    {
+        parser.next_bytes(out);
+    }
+
+    namespace detail
+    {
+        /**Enables CborParser::raw_numbers for a scope, see RawNumberScope for BasicParser.*/
+        template<typename Stats>
+        class RawNumberScope<CborParser<Stats>>
+        {
+        public:
+            explicit RawNumberScope(CborParser<Stats> &parser)
+                : parser(parser), prev(parser.raw_numbers())
+            {
+                parser.raw_numbers(true);
+            }
+            ~RawNumberScope()
+            {
+                parser.raw_numbers(prev);
+            }
+        private:
+            CborParser<Stats> &parser;
+            bool prev;
+        };
+    }
+
+    /**Converts some object to CBOR, by creating a CborWriter then calling CborWriter::value on
+     * it and returning the buffer.
+     */
+    template<typename T> std::string to_cbor(const T &obj)
+    {
+        CborWriter<> writer;
+        writer.value(obj);
+        return std::move(writer.str());
+    }
+    /**Read from CBOR into out.
+     * resource is passed to the CborParser for use by allocator-aware values.
+     */
+    template<typename T>
+    void read_cbor(const std::string &data, T *out,
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+    {
+        CborParser<> parser(data.data(), data.data() + data.size(), resource);
+        read_json(parser, out);
+        auto end = parser.next();
+        if (end.type != Token::END) parser.fail(ParseErrorCode::EXPECTED_END);
+    }
+    /**Read from CBOR into an instance of type T, and return it.*/
+    template<typename T>
+    T read_cbor(const std::string &data,
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+    {
+        CborParser<> parser(data.data(), data.data() + data.size(), resource);
+        T tmp = read_json<T>(parser);
+        auto end = parser.next();
+        if (end.type != Token::END) parser.fail(ParseErrorCode::EXPECTED_END);
+        return tmp;
+    }
+}
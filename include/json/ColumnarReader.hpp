@@ -0,0 +1,364 @@
+#pragma once
+#include "Reader.hpp"
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+namespace json
+{
+    /**One bit per row, as used for the presence of column values.*/
+    class Bitmap
+    {
+    public:
+        Bitmap() : words(), bits(0) {}
+
+        size_t size()const { return bits; }
+        bool operator[](size_t i)const
+        {
+            assert(i < bits);
+            return (words[i / 64] >> (i % 64)) & 1;
+        }
+        void push_back(bool bit)
+        {
+            if (bits % 64 == 0) words.push_back(0);
+            if (bit) words.back() |= (uint64_t)1 << (bits % 64);
+            ++bits;
+        }
+        /**Number of set bits.*/
+        size_t count()const
+        {
+            size_t n = 0;
+            for (auto word : words)
+            {
+                for (; word; word &= word - 1) ++n;
+            }
+            return n;
+        }
+        void reserve(size_t n) { words.reserve((n + 63) / 64); }
+        /**Remove bits after the first n, or add unset bits up to n.*/
+        void resize(size_t n)
+        {
+            words.resize((n + 63) / 64);
+            if (n % 64) words.back() &= ((uint64_t)1 << (n % 64)) - 1;
+            bits = n;
+        }
+        void clear() { words.clear(); bits = 0; }
+        /**The bits packed least significant first into 64 bit words. Unused bits are 0.*/
+        const uint64_t *data()const { return words.data(); }
+    private:
+        std::vector<uint64_t> words;
+        size_t bits;
+    };
+
+    /**The values of one object field across the rows read by a ColumnarReader.
+     * Rows where the field was null or missing hold a default constructed T, and are not
+     * present().
+     */
+    template<typename T>
+    class Column
+    {
+    public:
+        typedef T value_type;
+
+        size_t size()const { return vals.size(); }
+        typename std::vector<T>::const_reference operator[](size_t i)const { return vals[i]; }
+        bool present(size_t i)const { return presence[i]; }
+        /**Number of rows where the field was null or missing.*/
+        size_t null_count()const { return presence.size() - presence.count(); }
+
+        const std::vector<T> &values()const { return vals; }
+        const T *data()const { return vals.data(); }
+        const Bitmap &presence_bitmap()const { return presence; }
+
+        void push_back(T value)
+        {
+            vals.push_back(std::move(value));
+            presence.push_back(true);
+        }
+        void push_null()
+        {
+            vals.emplace_back();
+            presence.push_back(false);
+        }
+        void reserve(size_t n)
+        {
+            vals.reserve(n);
+            presence.reserve(n);
+        }
+        /**Remove rows after the first n, or add null rows up to n.*/
+        void resize(size_t n)
+        {
+            vals.resize(n);
+            presence.resize(n);
+        }
+        void clear()
+        {
+            vals.clear();
+            presence.clear();
+        }
+    private:
+        std::vector<T> vals;
+        Bitmap presence;
+    };
+
+    /**The values of one string field across the rows read by a ColumnarReader.
+     * All strings are stored back to back in a single arena, with offsets()[i] to
+     * offsets()[i + 1] being row i. Null or missing rows are empty and not present().
+     */
+    class StringColumn
+    {
+    public:
+        typedef std::string value_type;
+
+        StringColumn() : chars(), offs(1, 0), presence() {}
+
+        size_t size()const { return offs.size() - 1; }
+        std::string_view operator[](size_t i)const
+        {
+            return std::string_view(chars.data() + offs[i], offs[i + 1] - offs[i]);
+        }
+        bool present(size_t i)const { return presence[i]; }
+        size_t null_count()const { return presence.size() - presence.count(); }
+
+        const std::string &arena()const { return chars; }
+        const std::vector<size_t> &offsets()const { return offs; }
+        const Bitmap &presence_bitmap()const { return presence; }
+
+        void push_back(std::string_view str)
+        {
+            chars.append(str.data(), str.size());
+            offs.push_back(chars.size());
+            presence.push_back(true);
+        }
+        void push_null()
+        {
+            offs.push_back(chars.size());
+            presence.push_back(false);
+        }
+        void reserve(size_t rows, size_t bytes)
+        {
+            offs.reserve(rows + 1);
+            presence.reserve(rows);
+            chars.reserve(bytes);
+        }
+        /**Remove rows after the first n, or add null rows up to n.*/
+        void resize(size_t n)
+        {
+            if (n < size()) chars.resize(offs[n]);
+            offs.resize(n + 1, chars.size());
+            presence.resize(n);
+        }
+        void clear()
+        {
+            chars.clear();
+            offs.assign(1, 0);
+            presence.clear();
+        }
+    private:
+        std::string chars;
+        std::vector<size_t> offs;
+        Bitmap presence;
+    };
+
+    namespace detail
+    {
+        /**Column read functions take a scratch buffer for strings that need decoding.*/
+        template<typename Cols, typename ParserT>
+        struct ColumnFields
+        {
+            typedef void(*ReadColumn)(ParserT &parser, Cols *cols, std::string *buffer);
+            typedef void(*PushNull)(Cols *cols);
+            typedef size_t(*ColumnSize)(const Cols &cols);
+            typedef void(*ResizeColumn)(Cols *cols, size_t n);
+
+            KeyTable keys;
+            std::vector<ReadColumn> reads;
+            std::vector<PushNull> nulls;
+            std::vector<ColumnSize> sizes;
+            std::vector<ResizeColumn> resizes;
+
+            size_t size()const { return keys.size(); }
+        };
+    }
+
+    /**Reads an array of objects into a struct of columns, one Column or StringColumn per field,
+     * rather than a vector of structs. Each field's values end up contiguous, which suits
+     * scanning or aggregating a few fields over many rows.
+     *
+     * Declared like ObjectFieldReader, with Cols members in place of object members:
+     * @code
+     * struct Events { Column<long long> id; Column<double> value; StringColumn name; };
+     * static const auto reader = ColumnarReader<Events>().
+     *      add<decltype(Events::id), &Events::id>("id").
+     *      add<decltype(Events::value), &Events::value>("value").
+     *      add<decltype(Events::name), &Events::name>("name");
+     * @endcode
+     *
+     * Every column gets one entry per row. Fields that are null or missing are recorded in the
+     * column's presence bitmap rather than being an error. Duplicate keys are an error, and
+     * unknown keys are handled by ErrorPolicy. A row that fails part way is removed from every
+     * column again, so the columns stay aligned.
+     */
+    template<typename Cols, typename ErrorPolicy = ErrorUnknown, typename ParserT = Parser, size_t N = 0>
+    class ColumnarReader
+    {
+    public:
+        typedef detail::ColumnFields<Cols, ParserT> Fields;
+        typedef typename Fields::ReadColumn ReadColumn;
+        typedef typename Fields::PushNull PushNull;
+        typedef ColumnarReader<Cols, ErrorPolicy, ParserT, N + 1> Next;
+
+        ColumnarReader() : fields()
+        {
+            assert(N == 0);
+        }
+        explicit ColumnarReader(Fields &&fields) : fields(std::move(fields))
+        {
+            assert(N == this->fields.size());
+        }
+
+        /**Add a Column or StringColumn member, whose values are read with read_json.*/
+        template<typename U, U Cols::*ptr>
+        Next add(const std::string &name)
+        {
+            return add<U, ptr>(name, do_read_column<U, ptr>);
+        }
+        /**Add a Column member with a specified "void (ParserT &parser, T *out)" function to
+         * convert each value, such as one that calls read_json_enum.
+         */
+        template<typename U, U Cols::*ptr, void(*read_func)(ParserT &parser, typename U::value_type *out)>
+        Next add(const std::string &name)
+        {
+            return add<U, ptr>(name, do_read_column<U, ptr, read_func>);
+        }
+        /**Add a Column or StringColumn member with a specified read function.*/
+        template<typename U, U Cols::*ptr>
+        Next add(const std::string &name, ReadColumn read)
+        {
+            fields.keys.add(name);
+            fields.reads.push_back(read);
+            fields.nulls.push_back(do_push_null<U, ptr>);
+            fields.sizes.push_back(do_column_size<U, ptr>);
+            fields.resizes.push_back(do_resize_column<U, ptr>);
+            return Next(std::move(fields));
+        }
+
+        /**Read an array of objects, appending one row to every column of out per object.*/
+        void read(ParserT &parser, Cols *out)const
+        {
+            detail::DepthScope<ParserT> depth(parser);
+            if (!depth) return;
+            std::string buffer;
+            auto tok = parser.next();
+            if (tok.type != Token::ARR_START) return parser.fail(ParseErrorCode::EXPECTED_ARRAY);
+            if (parser.try_next_arr_end()) return;
+            do
+            {
+                read_row(parser, out, &buffer);
+                tok = parser.next();
+            }
+            while (tok.type == Token::ELEMENT_SEP);
+            if (tok.type != Token::ARR_END) parser.fail(ParseErrorCode::EXPECTED_ARRAY_END);
+        }
+    private:
+        void read_row(ParserT &parser, Cols *out, std::string *buffer)const
+        {
+            std::array<size_t, N> sizes;
+            for (size_t i = 0; i < N; ++i) sizes[i] = fields.sizes[i](*out);
+            try
+            {
+                read_row_fields(parser, out, buffer);
+            }
+            catch (...)
+            {
+                truncate(out, sizes);
+                throw;
+            }
+            if (detail::parser_failed(parser)) truncate(out, sizes);
+        }
+        void truncate(Cols *out, const std::array<size_t, N> &sizes)const
+        {
+            for (size_t i = 0; i < N; ++i) fields.resizes[i](out, sizes[i]);
+        }
+        void read_row_fields(ParserT &parser, Cols *out, std::string *buffer)const
+        {
+            std::array<bool, N> visited = {};
+            size_t count = 0;
+            parser.next_obj_start();
+            if (!parser.try_next_obj_end())
+            {
+                std::string key; // only set for unknown keys
+                do
+                {
+                    auto index = parser.next_key(fields.keys, &key);
+                    if (index != KeyTable::npos)
+                    {
+                        if (visited[index]) return parser.fail(ParseErrorCode::DUPLICATE_KEY, fields.keys[index]);
+                        if (parser.try_next_null()) fields.nulls[index](out);
+                        else fields.reads[index](parser, out, buffer);
+                        visited[index] = true;
+                        ++count;
+                    }
+                    else
+                    {
+                        parser.stats().unknown_key();
+                        ErrorPolicy()(parser, key);
+                    }
+                }
+                while (parser.next_obj_el());
+            }
+            if (count != N)
+            {
+                for (size_t i = 0; i < N; ++i)
+                {
+                    if (!visited[i]) fields.nulls[i](out);
+                }
+            }
+        }
+
+        template<typename U, U Cols::*ptr>
+        static void do_read_column(ParserT &parser, Cols *cols, std::string *buffer)
+        {
+            read_column(parser, &(cols->*ptr), buffer);
+        }
+        template<typename U, U Cols::*ptr, void(*read_func)(ParserT &parser, typename U::value_type *out)>
+        static void do_read_column(ParserT &parser, Cols *cols, std::string *)
+        {
+            typename U::value_type value;
+            read_func(parser, &value);
+            (cols->*ptr).push_back(std::move(value));
+        }
+        template<typename U, U Cols::*ptr>
+        static void do_push_null(Cols *cols)
+        {
+            (cols->*ptr).push_null();
+        }
+        template<typename U, U Cols::*ptr>
+        static size_t do_column_size(const Cols &cols)
+        {
+            return (cols.*ptr).size();
+        }
+        template<typename U, U Cols::*ptr>
+        static void do_resize_column(Cols *cols, size_t n)
+        {
+            (cols->*ptr).resize(n);
+        }
+
+        template<typename T>
+        static void read_column(ParserT &parser, Column<T> *col, std::string *)
+        {
+            T value;
+            read_json(parser, &value);
+            col->push_back(std::move(value));
+        }
+        static void read_column(ParserT &parser, StringColumn *col, std::string *buffer)
+        {
+            // the raw input bytes unless there are escapes, so usually only copied into the arena
+            col->push_back(parser.next_str_view(buffer));
+        }
+
+        Fields fields;
+    };
+}
@@ -4,60 +4,105 @@
 
 namespace json
 {
-    /**Copy the next value in parser, including objects and arrays, to writer.*/
-    inline void copy(Writer &writer, Parser &parser);
+    /**Copy the next value in parser, including objects and arrays, to writer.
+     * The parser and writer may be for different formats, e.g. to convert JSON to CBOR.
+     */
+    template<typename WriterT, typename ParserT>
+    void copy(WriterT &writer, ParserT &parser);
 
 
     namespace detail
     {
-        void copy_arr(Writer &writer, Parser &parser)
+        /**Copy an object key and its separator. Returns false if the parser failed.*/
+        template<typename WriterT, typename ParserT>
+        bool copy_key(WriterT &writer, ParserT &parser)
         {
-            writer.start_arr();
-            if (parser.try_next_arr_end()) return writer.end_arr();
-            Token tok;
-            do
-            {
-                copy(writer, parser);
-                tok = parser.next();
-            } while (tok.type == Token::ELEMENT_SEP);
-            if (tok.type != Token::ARR_END) throw ParseError("Expected array end");
-            writer.end_arr();
+            auto tok = parser.next();
+            if (tok.type != Token::STRING) return parser.fail(ParseErrorCode::EXPECTED_STRING), false;
+            writer.key(tok.str);
+
+            tok = parser.next();
+            if (tok.type != Token::KEY_SEP) return parser.fail(ParseErrorCode::EXPECTED_KEY_SEP), false;
+            return true;
         }
-        void copy_obj(Writer &writer, Parser &parser)
+        /**Copy the value that starts with tok, which has already been read from parser.
+         * Nested values are walked with an explicit stack rather than recursion, so deep input
+         * fails with ParseErrorCode::DEPTH_EXCEEDED past parser.max_depth() rather than
+         * overflowing the call stack. Errors are reported with parser.fail, and copying stops at
+         * the first one.
+         */
+        template<typename WriterT, typename ParserT>
+        void copy_value(WriterT &writer, ParserT &parser, Token tok)
         {
-            writer.start_obj();
-            if (parser.try_next_obj_end()) return writer.end_obj();
-            Token tok;
-            do
+            LevelStack open; // true for objects
+            while (true)
             {
+                switch (tok.type)
+                {
+                case Token::ARR_START:
+                case Token::OBJ_START:
+                {
+                    bool obj = tok.type == Token::OBJ_START;
+                    if (open.size() >= parser.max_depth()) return parser.fail(ParseErrorCode::DEPTH_EXCEEDED);
+                    if (obj)
+                    {
+                        writer.start_obj();
+                        if (parser.try_next_obj_end())
+                        {
+                            writer.end_obj();
+                            break;
+                        }
+                        if (!copy_key(writer, parser)) return;
+                    }
+                    else
+                    {
+                        writer.start_arr();
+                        if (parser.try_next_arr_end())
+                        {
+                            writer.end_arr();
+                            break;
+                        }
+                    }
+                    open.push(obj);
+                    tok = parser.next();
+                    continue;
+                }
+                case Token::INTEGER: writer.value(tok.val_int); break;
+                case Token::NUMBER: writer.value(tok.val_num); break;
+                case Token::RAW_NUMBER: writer.value(tok.val_raw); break;
+                case Token::STRING: writer.value(tok.str); break;
+                case Token::TRUE_VAL: writer.value(true); break;
+                case Token::FALSE_VAL: writer.value(false); break;
+                case Token::NULL_VAL: writer.null(); break;
+                default: return parser.fail(ParseErrorCode::EXPECTED_VALUE);
+                }
+                // a value is complete, so close containers until one has another element
+                while (true)
+                {
+                    if (open.empty()) return;
+                    tok = parser.next();
+                    if (tok.type == Token::ELEMENT_SEP) break;
+                    if (open.pop())
+                    {
+                        if (tok.type != Token::OBJ_END) return parser.fail(ParseErrorCode::EXPECTED_OBJECT_END);
+                        writer.end_obj();
+                    }
+                    else
+                    {
+                        if (tok.type != Token::ARR_END) return parser.fail(ParseErrorCode::EXPECTED_ARRAY_END);
+                        writer.end_arr();
+                    }
+                }
+                if (open.top() && !copy_key(writer, parser)) return;
                 tok = parser.next();
-                if (tok.type != Token::STRING) throw ParseError("Expected object key");
-                writer.key(tok.str);
-
-                tok = parser.next();
-                if (tok.type != Token::KEY_SEP) throw ParseError("Expected ':' object key-value seperator");
-
-                copy(writer, parser);
-                tok = parser.next();
-            } while (tok.type == Token::ELEMENT_SEP);
-            if (tok.type != Token::OBJ_END) throw ParseError("Expected object end");
-            writer.end_obj();
+            }
         }
     }
-    inline void copy(Writer &writer, Parser &parser)
+    template<typename WriterT, typename ParserT>
+    void copy(WriterT &writer, ParserT &parser)
     {
-        auto tok = parser.next();
-        switch (tok.type)
-        {
-        case Token::ARR_START: detail::copy_arr(writer, parser); return;
-        case Token::OBJ_START: detail::copy_obj(writer, parser); return;
-        case Token::INTEGER: writer.value(tok.val_int); return;
-        case Token::NUMBER: writer.value(tok.val_num); return;
-        case Token::STRING: writer.value(tok.str); return;
-        case Token::TRUE_VAL: writer.value(true); return;
-        case Token::FALSE_VAL: writer.value(false); return;
-        case Token::NULL_VAL: writer.null(); return;
-        default: throw ParseError("Unexpected token");
-        }
+        // numbers are written from their text where possible, so they are copied exactly
+        detail::RawNumberScope<ParserT> raw_numbers(parser);
+        detail::copy_value(writer, parser, parser.next());
     }
 }
@@ -0,0 +1,207 @@
+#pragma once
+#include "Reader.hpp"
+#include "Writer.hpp"
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+namespace json
+{
+    /**The JSON string names of the values of an enum type E, for read_json_enum and
+     * write_json_enum. Normally a static constant created once per type.
+     *
+     * Names are found with a perfect hash over the length and a few of the bytes, chosen when
+     * the table is created, so reading is one hash and one comparison against the raw input.
+     * Each value also stores its name already quoted, so writing is a single copy.
+     */
+    template<typename E>
+    class EnumTable
+    {
+    public:
+        EnumTable(std::initializer_list<std::pair<const char*, E>> values)
+        {
+            for (auto &i : values)
+            {
+                Writer quoted;
+                quoted.value(i.first);
+                entries.push_back({ i.first, std::move(quoted.str()), i.second });
+            }
+            build_hash();
+            build_values();
+        }
+
+        size_t size()const { return entries.size(); }
+
+        /**Set out to the value called name. Returns false if there is no such value.*/
+        bool find(std::string_view name, E *out)const
+        {
+            size_t i;
+            if (sampled || full) i = slots[hash(name, seed) & mask];
+            else i = linear_find(name);
+            if (i == npos) return false;
+            auto &entry = entries[i];
+            if (entry.name.size() != name.size() || std::memcmp(entry.name.data(), name.data(), name.size()) != 0)
+            {
+                return false;
+            }
+            *out = entry.value;
+            return true;
+        }
+        /**The name of value, or null if it is not in the table.*/
+        const std::string *name(E value)const
+        {
+            auto i = value_index(value);
+            return i == npos ? nullptr : &entries[i].name;
+        }
+        /**The name of value as a JSON string, or null if it is not in the table.*/
+        const std::string *quoted(E value)const
+        {
+            auto i = value_index(value);
+            return i == npos ? nullptr : &entries[i].quoted;
+        }
+    private:
+        static constexpr size_t npos = (size_t)-1;
+        /**Values from 0 up to this are looked up by index, others with a hash map.*/
+        static constexpr long long MAX_DENSE = 1024;
+
+        struct Entry
+        {
+            std::string name;
+            std::string quoted;
+            E value;
+        };
+        std::vector<Entry> entries;
+        /**Entry index for each hash slot.*/
+        std::vector<size_t> slots;
+        size_t mask = 0;
+        uint32_t seed = 0;
+        /**The hash uses only the length and first, middle and last bytes.*/
+        bool sampled = false;
+        /**The hash uses every byte, if no sampled hash was perfect.*/
+        bool full = false;
+        /**Entry index by value for values in [0, MAX_DENSE).*/
+        std::vector<size_t> dense;
+        std::unordered_map<long long, size_t> sparse;
+
+        uint32_t hash(std::string_view str, uint32_t h)const
+        {
+            h ^= (uint32_t)str.size() * 0x9E3779B1u;
+            if (full)
+            {
+                for (char c : str) h = (h ^ (unsigned char)c) * 0x01000193u;
+            }
+            else if (!str.empty())
+            {
+                h = (h ^ (unsigned char)str[0]) * 0x85EBCA6Bu;
+                h = (h ^ (unsigned char)str[str.size() / 2]) * 0xC2B2AE35u;
+                h = (h ^ (unsigned char)str[str.size() - 1]) * 0x27D4EB2Fu;
+            }
+            return h ^ (h >> 15);
+        }
+        /**Search for a seed and table size with no collisions, first with the sampled hash and
+         * then the full one. If neither is found names are searched linearly.
+         */
+        void build_hash()
+        {
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                for (size_t j = 0; j < i; ++j)
+                {
+                    if (entries[i].name == entries[j].name) throw std::invalid_argument("Duplicate enum name " + entries[i].name);
+                }
+            }
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                sampled = pass == 0;
+                full = pass == 1;
+                size_t size = 1;
+                while (size < entries.size() * 2) size *= 2;
+                for (; size <= entries.size() * 16 + 16; size *= 2)
+                {
+                    for (seed = 0; seed < 64; ++seed)
+                    {
+                        if (try_build(size)) return;
+                    }
+                }
+            }
+            sampled = full = false;
+            slots.clear();
+        }
+        bool try_build(size_t size)
+        {
+            mask = size - 1;
+            slots.assign(size, npos);
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                auto &slot = slots[hash(entries[i].name, seed) & mask];
+                if (slot != npos) return false;
+                slot = i;
+            }
+            return true;
+        }
+        size_t linear_find(std::string_view name)const
+        {
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                if (entries[i].name == name) return i;
+            }
+            return npos;
+        }
+
+        void build_values()
+        {
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                auto x = (long long)entries[i].value;
+                if (x >= 0 && x < MAX_DENSE)
+                {
+                    if (dense.size() <= (size_t)x) dense.resize((size_t)x + 1, npos);
+                    // the first name for a value is used for writing
+                    if (dense[(size_t)x] == npos) dense[(size_t)x] = i;
+                }
+                else sparse.emplace(x, i);
+            }
+        }
+        size_t value_index(E value)const
+        {
+            auto x = (long long)value;
+            if (x >= 0 && x < MAX_DENSE) return (size_t)x < dense.size() ? dense[(size_t)x] : npos;
+            auto it = sparse.find(x);
+            return it == sparse.end() ? npos : it->second;
+        }
+    };
+
+    /**Read a string as one of the values in table. Other strings fail with
+     * ParseErrorCode::UNKNOWN_ENUM. The input bytes are matched directly unless the string has
+     * escape sequences.
+     */
+    template<typename ParserT, typename E>
+    if_parser<ParserT> read_json_enum(ParserT &parser, E *out, const EnumTable<E> &table)
+    {
+        std::string buffer;
+        auto str = parser.next_str_view(&buffer);
+        if (!table.find(str, out)) parser.fail(ParseErrorCode::UNKNOWN_ENUM, std::string(str));
+    }
+
+    /**Write value as its name from table. Throws std::invalid_argument if it is not in table.*/
+    template<typename WriterT, typename E>
+    if_writer<WriterT> write_json_enum(WriterT &writer, E value, const EnumTable<E> &table)
+    {
+        auto name = table.name(value);
+        if (!name) throw std::invalid_argument("Enum value not in table");
+        writer.plain_str_value(name->data(), name->size());
+    }
+    /**JSON writers copy the pre-quoted name.*/
+    template<typename Stats, typename Buffer, typename E>
+    void write_json_enum(BasicWriter<Stats, Buffer> &writer, E value, const EnumTable<E> &table)
+    {
+        auto quoted = table.quoted(value);
+        if (!quoted) throw std::invalid_argument("Enum value not in table");
+        writer.raw_value(*quoted);
+    }
+}
@@ -0,0 +1,185 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+namespace json
+{
+    /**The kind of a parse failure, see ParseError::code and ParseResult.*/
+    enum class ParseErrorCode
+    {
+        NONE = 0,
+        UNEXPECTED_END,
+        UNEXPECTED_CONTENT,
+        EXPECTED_VALUE,
+        EXPECTED_BOOL,
+        EXPECTED_INT,
+        EXPECTED_NUMBER,
+        EXPECTED_STRING,
+        EXPECTED_ARRAY,
+        EXPECTED_ARRAY_END,
+        EXPECTED_OBJECT,
+        EXPECTED_OBJECT_END,
+        EXPECTED_KEY_SEP,
+        EXPECTED_END,
+        NUMBER_OVERFLOW,
+        INVALID_NUMBER,
+        INVALID_ESCAPE,
+        INVALID_UTF8,
+        INVALID_BASE64,
+        INVALID_TIME,
+        UNKNOWN_KEY,
+        UNKNOWN_ENUM,
+        DUPLICATE_KEY,
+        MISSING_KEYS,
+        /**More elements or characters than a fixed capacity container can hold.*/
+        CAPACITY_EXCEEDED,
+        /**Arrays and objects nested deeper than the parser's max_depth.*/
+        DEPTH_EXCEEDED,
+        /**An error with only a text message, e.g. thrown by a user read_json overload.*/
+        OTHER
+    };
+
+    /**Description of an error code, without any position information.*/
+    inline const char *parse_error_message(ParseErrorCode code)
+    {
+        switch (code)
+        {
+        case ParseErrorCode::NONE: return "No error";
+        case ParseErrorCode::UNEXPECTED_END: return "Unexpected end of input";
+        case ParseErrorCode::UNEXPECTED_CONTENT: return "Unexpected content";
+        case ParseErrorCode::EXPECTED_VALUE: return "Expected value";
+        case ParseErrorCode::EXPECTED_BOOL: return "Expected boolean";
+        case ParseErrorCode::EXPECTED_INT: return "Expected int";
+        case ParseErrorCode::EXPECTED_NUMBER: return "Expected number";
+        case ParseErrorCode::EXPECTED_STRING: return "Expected string";
+        case ParseErrorCode::EXPECTED_ARRAY: return "Expected array";
+        case ParseErrorCode::EXPECTED_ARRAY_END: return "Expected ',' or ']'";
+        case ParseErrorCode::EXPECTED_OBJECT: return "Expected object";
+        case ParseErrorCode::EXPECTED_OBJECT_END: return "Expected ',' or '}' after object value";
+        case ParseErrorCode::EXPECTED_KEY_SEP: return "Expected ':'";
+        case ParseErrorCode::EXPECTED_END: return "Expected end";
+        case ParseErrorCode::NUMBER_OVERFLOW: return "Overflow";
+        case ParseErrorCode::INVALID_NUMBER: return "Invalid number";
+        case ParseErrorCode::INVALID_ESCAPE: return "Invalid escape sequence";
+        case ParseErrorCode::INVALID_UTF8: return "Invalid UTF-8 in string";
+        case ParseErrorCode::INVALID_BASE64: return "Invalid base64";
+        case ParseErrorCode::INVALID_TIME: return "Invalid time";
+        case ParseErrorCode::UNKNOWN_KEY: return "Unknown key";
+        case ParseErrorCode::UNKNOWN_ENUM: return "Unknown enum value";
+        case ParseErrorCode::DUPLICATE_KEY: return "Duplicate key";
+        case ParseErrorCode::MISSING_KEYS: return "Missing keys";
+        case ParseErrorCode::CAPACITY_EXCEEDED: return "Capacity exceeded";
+        case ParseErrorCode::DEPTH_EXCEEDED: return "Maximum nesting depth exceeded";
+        case ParseErrorCode::OTHER: return "Parse error";
+        }
+        return "Unknown error";
+    }
+
+    namespace detail
+    {
+        /**"line:column message", or "At byte offset: message" if line is 0 (binary input).*/
+        inline std::string format_parse_error(
+            ParseErrorCode code, int line, int column, size_t offset, const std::string &detail)
+        {
+            std::string msg;
+            if (line > 0)
+            {
+                msg = std::to_string(line);
+                msg += ':';
+                msg += std::to_string(column);
+                msg += ' ';
+            }
+            else
+            {
+                msg = "At byte ";
+                msg += std::to_string(offset);
+                msg += ": ";
+            }
+            msg += parse_error_message(code);
+            if (!detail.empty())
+            {
+                msg += ' ';
+                msg += detail;
+            }
+            return msg;
+        }
+    }
+
+    /**Thrown by parsers and read_json on invalid input.
+     * Only the error code and position are stored when thrown by a parser. The text returned by
+     * what() is formatted on first use.
+     */
+    class ParseError : public std::runtime_error
+    {
+    public:
+        /**An error at a position in the input, detail is appended to the message if not empty.*/
+        ParseError(ParseErrorCode code, int line, int column, size_t offset, std::string detail_text = std::string())
+            : std::runtime_error("")
+            , error_code(code), line_num(line), column_num(column), byte_offset(offset)
+            , detail_text(std::move(detail_text)), formatted(false)
+        {}
+        /**An error with a preformatted message.*/
+        ParseError(int line, int pos, const std::string &msg)
+            : ParseError(ParseErrorCode::OTHER, line, pos, 0)
+        {
+            formatted_msg = std::to_string(line) + ':' + std::to_string(pos) + ' ' + msg;
+            formatted = true;
+        }
+        ParseError(const std::string &msg)
+            : ParseError(ParseErrorCode::OTHER, 0, 0, 0)
+        {
+            formatted_msg = msg;
+            formatted = true;
+        }
+
+        ParseErrorCode code()const { return error_code; }
+        /**1 based line number, or 0 if not known or the input is binary.*/
+        int line()const { return line_num; }
+        int column()const { return column_num; }
+        /**Byte offset from the start of the input.*/
+        size_t offset()const { return byte_offset; }
+
+        virtual const char *what()const noexcept override
+        {
+            if (!formatted)
+            {
+                try
+                {
+                    formatted_msg = detail::format_parse_error(error_code, line_num, column_num, byte_offset, detail_text);
+                }
+                catch (const std::exception &)
+                {
+                    return parse_error_message(error_code);
+                }
+                formatted = true;
+            }
+            return formatted_msg.c_str();
+        }
+    private:
+        ParseErrorCode error_code;
+        int line_num, column_num;
+        size_t byte_offset;
+        std::string detail_text;
+        mutable std::string formatted_msg;
+        mutable bool formatted;
+    };
+
+    /**The first error from a parser with throwing disabled, see BasicParser::throw_errors and
+     * try_read_json. Converts to true if there was no error.
+     */
+    struct ParseResult
+    {
+        ParseErrorCode code = ParseErrorCode::NONE;
+        int line = 0;
+        int column = 0;
+        size_t offset = 0;
+
+        bool ok()const { return code == ParseErrorCode::NONE; }
+        explicit operator bool()const { return ok(); }
+        /**Format the same message as ParseError::what.*/
+        std::string message()const
+        {
+            return detail::format_parse_error(code, line, column, offset, std::string());
+        }
+    };
+}
@@ -0,0 +1,195 @@
+#pragma once
+#include "Reader.hpp"
+#include "Writer.hpp"
+#include <cassert>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+namespace json
+{
+    /**A string stored inline with a capacity of N bytes, which never allocates.
+     *
+     * Appending past the capacity drops the extra characters and sets overflowed(), so that
+     * read_json can report ParseErrorCode::CAPACITY_EXCEEDED. The contents are always null
+     * terminated.
+     */
+    template<size_t N>
+    class FixedString
+    {
+    public:
+        typedef char value_type;
+        typedef char *iterator;
+        typedef const char *const_iterator;
+
+        FixedString() : len(0), overflow(false) { buf[0] = '\0'; }
+        /**Throws std::length_error if str is longer than N.*/
+        FixedString(std::string_view str) : FixedString()
+        {
+            if (str.size() > N) throw std::length_error("FixedString capacity exceeded");
+            append(str.data(), str.size());
+        }
+        FixedString(const char *str) : FixedString(std::string_view(str)) {}
+
+        size_t size()const { return len; }
+        bool empty()const { return len == 0; }
+        static constexpr size_t capacity() { return N; }
+        static constexpr size_t max_size() { return N; }
+        /**True if characters were dropped because the string was full.*/
+        bool overflowed()const { return overflow; }
+
+        const char *data()const { return buf; }
+        char *data() { return buf; }
+        const char *c_str()const { return buf; }
+        std::string_view str_view()const { return std::string_view(buf, len); }
+        operator std::string_view()const { return str_view(); }
+
+        const char *begin()const { return buf; }
+        const char *end()const { return buf + len; }
+        char *begin() { return buf; }
+        char *end() { return buf + len; }
+        char operator[](size_t i)const { return buf[i]; }
+        char &operator[](size_t i) { return buf[i]; }
+
+        void clear()
+        {
+            len = 0;
+            overflow = false;
+            buf[0] = '\0';
+        }
+        FixedString &operator += (char c)
+        {
+            if (len < N)
+            {
+                buf[len++] = c;
+                buf[len] = '\0';
+            }
+            else overflow = true;
+            return *this;
+        }
+        FixedString &append(const char *str, size_t n)
+        {
+            if (n > N - len)
+            {
+                n = N - len;
+                overflow = true;
+            }
+            std::memcpy(buf + len, str, n);
+            len += n;
+            buf[len] = '\0';
+            return *this;
+        }
+
+        bool operator == (std::string_view other)const { return str_view() == other; }
+        bool operator != (std::string_view other)const { return str_view() != other; }
+    private:
+        char buf[N + 1];
+        size_t len;
+        bool overflow;
+    };
+
+    /**A vector with inline storage for up to N elements, which never allocates.
+     *
+     * Adding to a full vector throws std::length_error. read_json_array checks max_size first,
+     * so reading too many elements instead fails with ParseErrorCode::CAPACITY_EXCEEDED.
+     */
+    template<typename T, size_t N>
+    class FixedVector
+    {
+    public:
+        typedef T value_type;
+        typedef T *iterator;
+        typedef const T *const_iterator;
+
+        FixedVector() : len(0) {}
+        FixedVector(const FixedVector &other) : len(0)
+        {
+            for (auto &x : other) push_back(x);
+        }
+        FixedVector(FixedVector &&other) : len(0)
+        {
+            for (auto &x : other) push_back(std::move(x));
+            other.clear();
+        }
+        FixedVector(std::initializer_list<T> list) : len(0)
+        {
+            for (auto &x : list) push_back(x);
+        }
+        ~FixedVector() { clear(); }
+        FixedVector& operator = (const FixedVector &other)
+        {
+            if (this != &other)
+            {
+                clear();
+                for (auto &x : other) push_back(x);
+            }
+            return *this;
+        }
+        FixedVector& operator = (FixedVector &&other)
+        {
+            if (this != &other)
+            {
+                clear();
+                for (auto &x : other) push_back(std::move(x));
+                other.clear();
+            }
+            return *this;
+        }
+
+        size_t size()const { return len; }
+        bool empty()const { return len == 0; }
+        bool full()const { return len == N; }
+        static constexpr size_t capacity() { return N; }
+        static constexpr size_t max_size() { return N; }
+
+        T *data() { return reinterpret_cast<T*>(storage); }
+        const T *data()const { return reinterpret_cast<const T*>(storage); }
+        T *begin() { return data(); }
+        T *end() { return data() + len; }
+        const T *begin()const { return data(); }
+        const T *end()const { return data() + len; }
+        T &operator[](size_t i) { assert(i < len); return data()[i]; }
+        const T &operator[](size_t i)const { assert(i < len); return data()[i]; }
+        T &back() { assert(len > 0); return data()[len - 1]; }
+        const T &back()const { assert(len > 0); return data()[len - 1]; }
+
+        template<typename... Args> T &emplace_back(Args&&... args)
+        {
+            if (full()) throw std::length_error("FixedVector capacity exceeded");
+            T *x = new (data() + len) T(std::forward<Args>(args)...);
+            ++len;
+            return *x;
+        }
+        void push_back(const T &x) { emplace_back(x); }
+        void push_back(T &&x) { emplace_back(std::move(x)); }
+        void pop_back()
+        {
+            assert(len > 0);
+            data()[--len].~T();
+        }
+        void clear()
+        {
+            while (len > 0) pop_back();
+        }
+    private:
+        alignas(T) unsigned char storage[N > 0 ? N * sizeof(T) : 1];
+        size_t len;
+    };
+
+    /**Read a string, replacing the contents. Strings longer than N fail with
+     * ParseErrorCode::CAPACITY_EXCEEDED.
+     */
+    template<typename ParserT, size_t N>
+    if_parser<ParserT> read_json(ParserT &parser, FixedString<N> *str)
+    {
+        str->clear();
+        parser.next_str(str);
+        if (str->overflowed()) parser.fail(ParseErrorCode::CAPACITY_EXCEEDED);
+    }
+    template<typename WriterT, size_t N>
+    if_writer<WriterT> write_json(WriterT &writer, const FixedString<N> &str)
+    {
+        writer.do_value(str.data(), str.size());
+    }
+}
@@ -0,0 +1,156 @@
+#pragma once
+#include "Writer.hpp"
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+namespace json
+{
+    namespace detail
+    {
+        /**A unique address for each type, so objects of different types at the same address
+         * (such as a struct and its first member) have different cache keys.
+         */
+        template<typename T> const void *type_tag()
+        {
+            static const char tag = 0;
+            return &tag;
+        }
+    }
+
+    /**Caches the JSON of sub-objects that rarely change, such as user profiles or catalog
+     * entries, so that they are serialised once and then copied into each output.
+     *
+     * Entries are keyed by object address and type, plus a version number chosen by the caller,
+     * which should be changed whenever the object is modified. A different version replaces the
+     * cached JSON. Once the cached JSON exceeds max_bytes the least recently used entries are
+     * evicted.
+     *
+     * As entries are keyed by address, call invalidate before a cached object is destroyed.
+     * Otherwise a new object later allocated at the same address with the same version would
+     * be written with the stale JSON.
+     *
+     * Not thread safe, use one cache per thread or external locking.
+     */
+    class FragmentCache
+    {
+    public:
+        explicit FragmentCache(size_t max_bytes = 16 * 1024 * 1024)
+            : lru(), index(), total_bytes(0), limit(max_bytes), hit_count(0), miss_count(0)
+        {}
+        FragmentCache(const FragmentCache&) = delete;
+        FragmentCache& operator = (const FragmentCache&) = delete;
+
+        /**Write obj to writer, from the cache if there is an entry for the same object and
+         * version, else serialising it with write_json and caching the result.
+         * The cached text is JSON, so only JSON writers are supported.
+         */
+        template<typename Stats, typename Buffer, typename T>
+        void write(BasicWriter<Stats, Buffer> &writer, const T &obj, uint64_t version)
+        {
+            writer.raw_value(get(obj, version));
+        }
+        /**The JSON for obj, see write. Only valid until the cache is next modified.*/
+        template<typename T>
+        const std::string &get(const T &obj, uint64_t version)
+        {
+            Key key = { &obj, detail::type_tag<T>() };
+            auto it = index.find(key);
+            if (it != index.end())
+            {
+                auto entry = it->second;
+                if (entry->version == version)
+                {
+                    ++hit_count;
+                    lru.splice(lru.begin(), lru, entry);
+                    return entry->json;
+                }
+                remove(it);
+            }
+            ++miss_count;
+            lru.push_front({ key, version, to_json(obj) });
+            index.emplace(key, lru.begin());
+            total_bytes += lru.front().json.size();
+            evict(lru.front().json.size());
+            return lru.front().json;
+        }
+
+        /**Remove any entry for obj.*/
+        template<typename T> void invalidate(const T &obj)
+        {
+            auto it = index.find(Key{ &obj, detail::type_tag<T>() });
+            if (it != index.end()) remove(it);
+        }
+        void clear()
+        {
+            lru.clear();
+            index.clear();
+            total_bytes = 0;
+        }
+
+        /**Number of entries.*/
+        size_t size()const { return lru.size(); }
+        /**Total size of the cached JSON.*/
+        size_t bytes()const { return total_bytes; }
+        size_t max_bytes()const { return limit; }
+        void max_bytes(size_t max)
+        {
+            limit = max;
+            evict(0);
+        }
+        size_t hits()const { return hit_count; }
+        size_t misses()const { return miss_count; }
+    private:
+        struct Key
+        {
+            const void *obj;
+            const void *type;
+
+            bool operator == (const Key &other)const { return obj == other.obj && type == other.type; }
+        };
+        struct KeyHash
+        {
+            size_t operator()(const Key &key)const
+            {
+                return std::hash<const void*>()(key.obj) ^ (std::hash<const void*>()(key.type) << 1);
+            }
+        };
+        struct Entry
+        {
+            Key key;
+            uint64_t version;
+            std::string json;
+        };
+        typedef std::list<Entry> List;
+        typedef std::unordered_map<Key, List::iterator, KeyHash> Index;
+
+        /**Most recently used first.*/
+        List lru;
+        Index index;
+        size_t total_bytes;
+        size_t limit;
+        size_t hit_count, miss_count;
+
+        void remove(Index::iterator it)
+        {
+            total_bytes -= it->second->json.size();
+            lru.erase(it->second);
+            index.erase(it);
+        }
+        /**Evict least recently used entries until within the limit, but keep the most recent
+         * entry if it is at least keep bytes, as it is about to be used.
+         */
+        void evict(size_t keep)
+        {
+            while (total_bytes > limit && !lru.empty())
+            {
+                auto &last = lru.back();
+                if (lru.size() == 1 && last.json.size() == keep) break;
+                total_bytes -= last.json.size();
+                index.erase(last.key);
+                lru.pop_back();
+            }
+        }
+    };
+}
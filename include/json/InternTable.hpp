@@ -0,0 +1,101 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+namespace json
+{
+    /**A handle to an immutable string owned by an InternTable.
+     *
+     * Handles from the same table are equal exactly when their strings are, so they compare by
+     * address. A default constructed handle is the empty string, which every table also returns
+     * for "".
+     */
+    class InternedString
+    {
+    public:
+        InternedString() : ptr(&empty_str()) {}
+
+        const std::string &str()const { return *ptr; }
+        operator const std::string&()const { return *ptr; }
+        const char *c_str()const { return ptr->c_str(); }
+        size_t size()const { return ptr->size(); }
+        bool empty()const { return ptr->empty(); }
+
+        /**Compares the addresses, so only meaningful for handles from the same table.*/
+        bool operator == (const InternedString &other)const { return ptr == other.ptr; }
+        bool operator != (const InternedString &other)const { return ptr != other.ptr; }
+        bool operator == (std::string_view other)const { return *ptr == other; }
+        bool operator != (std::string_view other)const { return *ptr != other; }
+    private:
+        friend class InternTable;
+        explicit InternedString(const std::string *ptr) : ptr(ptr) {}
+
+        static const std::string &empty_str()
+        {
+            static const std::string empty;
+            return empty;
+        }
+
+        const std::string *ptr;
+    };
+
+    /**Stores one copy of each distinct string, for values that repeat many times across a data
+     * set, such as country codes or status names.
+     *
+     * Set on a parser with intern_table, then read InternedString fields. Strings without escape
+     * sequences are looked up directly from the input bytes, so a repeated value costs a hash
+     * lookup and no allocation.
+     *
+     * Strings are never removed except by clear, so should only be used for values from a
+     * limited set. Handles are valid until the table is cleared or destroyed.
+     */
+    class InternTable
+    {
+    public:
+        InternTable() : strings(), index(), total_bytes(0) {}
+        InternTable(const InternTable&) = delete;
+        InternTable& operator = (const InternTable&) = delete;
+
+        /**Get the handle for str, adding a copy of it if not already present.*/
+        InternedString intern(std::string_view str)
+        {
+            if (str.empty()) return InternedString();
+            auto it = index.find(str);
+            if (it != index.end()) return InternedString(it->second);
+            strings.emplace_back(str);
+            auto stored = &strings.back();
+            index.emplace(std::string_view(*stored), stored);
+            total_bytes += str.size();
+            return InternedString(stored);
+        }
+        InternedString intern(const char *str, size_t len)
+        {
+            return intern(std::string_view(str, len));
+        }
+        /**Get the handle for str if present, without adding it. found is set to false if not.*/
+        InternedString find(std::string_view str, bool *found = nullptr)const
+        {
+            auto it = index.find(str);
+            if (found) *found = str.empty() || it != index.end();
+            return it != index.end() ? InternedString(it->second) : InternedString();
+        }
+
+        /**Number of distinct non-empty strings.*/
+        size_t size()const { return strings.size(); }
+        /**Total length of the distinct strings.*/
+        size_t bytes()const { return total_bytes; }
+        /**Remove every string, invalidating all handles other than the empty string.*/
+        void clear()
+        {
+            index.clear();
+            strings.clear();
+            total_bytes = 0;
+        }
+    private:
+        /**A deque so that strings do not move as more are added.*/
+        std::deque<std::string> strings;
+        std::unordered_map<std::string_view, const std::string*> index;
+        size_t total_bytes;
+    };
+}
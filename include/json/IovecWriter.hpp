@@ -0,0 +1,152 @@
+#pragma once
+#include "Writer.hpp"
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <system_error>
+#include <sys/uio.h>
+#endif
+namespace json
+{
+    /**A BasicWriter Buffer that builds a scatter-gather list, for writing with writev without
+     * copying large payloads.
+     *
+     * Generated output is appended to an internal string. Data given to append_ref, by
+     * BasicWriter::raw_value_ref and str_value_ref, is referenced in place if it is at least
+     * min_ref_size bytes, so it must stay valid until the output has been written.
+     */
+    class IovecBuffer
+    {
+    public:
+        /**A contiguous piece of the output.*/
+        struct Segment
+        {
+            const char *data;
+            size_t size;
+        };
+
+        IovecBuffer() : owned(), refs(), ref_bytes(0), min_ref(1024) {}
+
+        /**The smallest append_ref length that is referenced rather than copied.*/
+        size_t min_ref_size()const { return min_ref; }
+        void min_ref_size(size_t size) { min_ref = size; }
+
+        IovecBuffer &operator += (char c)
+        {
+            owned += c;
+            return *this;
+        }
+        IovecBuffer &append(const char *str, size_t len)
+        {
+            owned.append(str, len);
+            return *this;
+        }
+        /**Reference [str, str + len) in place, or copy it if it is shorter than min_ref_size.*/
+        void append_ref(const char *str, size_t len)
+        {
+            if (len < min_ref)
+            {
+                owned.append(str, len);
+                return;
+            }
+            refs.push_back({ owned.size(), str, len });
+            ref_bytes += len;
+        }
+
+        /**Total output size, including referenced data.*/
+        size_t size()const { return owned.size() + ref_bytes; }
+        size_t capacity()const { return owned.capacity() + ref_bytes; }
+        /**Reserve space for generated output.*/
+        void reserve(size_t size) { owned.reserve(size); }
+
+        /**The output in order, as pieces of the internal string and referenced data.*/
+        std::vector<Segment> segments()const
+        {
+            std::vector<Segment> out;
+            out.reserve(refs.size() * 2 + 1);
+            size_t pos = 0;
+            for (auto &ref : refs)
+            {
+                if (ref.pos > pos) out.push_back({ owned.data() + pos, ref.pos - pos });
+                out.push_back({ ref.data, ref.size });
+                pos = ref.pos;
+            }
+            if (owned.size() > pos) out.push_back({ owned.data() + pos, owned.size() - pos });
+            return out;
+        }
+        /**Copy the complete output into a single string.*/
+        std::string str()const
+        {
+            std::string out;
+            out.reserve(size());
+            for (auto &seg : segments()) out.append(seg.data, seg.size);
+            return out;
+        }
+
+#ifndef _WIN32
+        /**Write the complete output to a file descriptor, such as a pipe or socket, using
+         * writev. Partial writes and EINTR are retried.
+         * Throws std::system_error on failure.
+         */
+        void write_to(int fd)const
+        {
+            auto segs = segments();
+            std::vector<iovec> iov(segs.size());
+            for (size_t i = 0; i < segs.size(); ++i)
+            {
+                iov[i].iov_base = const_cast<char*>(segs[i].data);
+                iov[i].iov_len = segs[i].size;
+            }
+            size_t i = 0;
+            while (i < iov.size())
+            {
+                auto count = (int)std::min<size_t>(iov.size() - i, IOV_MAX);
+                auto written = ::writev(fd, &iov[i], count);
+                if (written < 0)
+                {
+                    if (errno == EINTR) continue;
+                    throw std::system_error(errno, std::generic_category(), "writev");
+                }
+                auto remaining = (size_t)written;
+                while (i < iov.size() && remaining >= iov[i].iov_len)
+                {
+                    remaining -= iov[i].iov_len;
+                    ++i;
+                }
+                if (remaining)
+                {
+                    iov[i].iov_base = (char*)iov[i].iov_base + remaining;
+                    iov[i].iov_len -= remaining;
+                }
+            }
+        }
+#endif
+    private:
+        /**Referenced data, inserted at pos in the owned output.*/
+        struct Ref
+        {
+            size_t pos;
+            const char *data;
+            size_t size;
+        };
+        std::string owned;
+        std::vector<Ref> refs;
+        size_t ref_bytes;
+        size_t min_ref;
+    };
+
+    /**Writer that outputs to an IovecBuffer, see BasicWriter::raw_value_ref and str_value_ref.
+     * e.g: @code
+     * IovecWriter writer;
+     * writer.start_obj();
+     * writer.key("blob");
+     * writer.str_value_ref(blob);
+     * writer.end_obj();
+     * writer.str().write_to(fd);
+     * @endcode
+     */
+    typedef BasicWriter<NoStats, IovecBuffer> IovecWriter;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <vector>
+namespace json
+{
+    /**A set of object keys, for matching against the raw key bytes in the input with
+     * BasicParser::next_key, without decoding the key into a string.
+     *
+     * Lookup is a linear search comparing the length and first byte before the full bytes, which
+     * is faster than hashing for the small key sets of a typical object type.
+     */
+    class KeyTable
+    {
+    public:
+        /**Returned by find when a key is not in the table.*/
+        static constexpr size_t npos = (size_t)-1;
+
+        KeyTable() {}
+        KeyTable(std::initializer_list<const char*> keys)
+        {
+            for (auto key : keys) add(key);
+        }
+
+        /**Add a key, which is given the next index starting at 0.*/
+        size_t add(std::string key)
+        {
+            assert(find(key) == npos);
+            auto index = keys.size();
+            keys.push_back(std::move(key));
+            return index;
+        }
+
+        size_t size()const { return keys.size(); }
+        bool empty()const { return keys.empty(); }
+        const std::string &operator[](size_t index)const { return keys[index]; }
+
+        /**Index of the decoded key [str, str + len), or npos.*/
+        size_t find(const char *str, size_t len)const
+        {
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                auto &key = keys[i];
+                if (key.size() == len && (len == 0 || (key[0] == str[0] && memcmp(key.data(), str, len) == 0)))
+                    return i;
+            }
+            return npos;
+        }
+        size_t find(const std::string &key)const
+        {
+            return find(key.data(), key.size());
+        }
+    private:
+        std::vector<std::string> keys;
+    };
+}
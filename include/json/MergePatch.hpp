@@ -0,0 +1,224 @@
+#pragma once
+#include "Copy.hpp"
+#include "Reader.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+namespace json
+{
+    /**A JSON Merge Patch (RFC 7386), for apply_merge_patch.
+     *
+     * The patch is held as a tree of its objects, with every other value kept as JSON text, so
+     * its size is proportional to the patch rather than any document it is applied to.
+     */
+    class MergePatch
+    {
+    public:
+        /**Parse a patch document. Throws ParseError if it is not valid JSON.*/
+        explicit MergePatch(const std::string &json)
+            : MergePatch(json.data(), json.data() + json.size())
+        {}
+        MergePatch(const char *begin, const char *end)
+        {
+            Parser parser(begin, end);
+            detail::RawNumberScope<Parser> raw_numbers(parser);
+            read_node(parser, parser.next(), &root, 0);
+            if (parser.next().type != Token::END) parser.fail(ParseErrorCode::EXPECTED_END);
+        }
+
+        /**An object, or a value that replaces the target.*/
+        struct Node
+        {
+            bool obj = false;
+            /**JSON text of a value that is not an object.*/
+            std::string value;
+            /**Members of an object, in patch order.*/
+            std::vector<std::string> keys;
+            std::vector<Node> members;
+            std::unordered_map<std::string, size_t> index;
+
+            /**A null member deletes the key from the target.*/
+            bool is_null()const { return !obj && value == "null"; }
+            /**Index of the member named key, or -1.*/
+            size_t find(const std::string &key)const
+            {
+                auto it = index.find(key);
+                return it == index.end() ? (size_t)-1 : it->second;
+            }
+        };
+
+        const Node &root_node()const { return root; }
+    private:
+        Node root;
+
+        /**Read the value starting with tok, nested in depth objects.*/
+        static void read_node(Parser &parser, const Token &tok, Node *node, size_t depth)
+        {
+            if (tok.type != Token::OBJ_START)
+            {
+                Writer writer;
+                detail::copy_value(writer, parser, tok);
+                node->value = std::move(writer.str());
+                return;
+            }
+            if (depth >= parser.max_depth()) return parser.fail(ParseErrorCode::DEPTH_EXCEEDED);
+            node->obj = true;
+            if (parser.try_next_obj_end()) return;
+            Token next;
+            do
+            {
+                auto key = parser.next_str();
+                parser.next_key_sep();
+                // a repeated key replaces the earlier member
+                auto inserted = node->index.emplace(key, node->members.size());
+                if (inserted.second)
+                {
+                    node->keys.push_back(std::move(key));
+                    node->members.emplace_back();
+                }
+                auto &member = node->members[inserted.first->second];
+                member = Node();
+                read_node(parser, parser.next(), &member, depth + 1);
+                next = parser.next();
+            }
+            while (next.type == Token::ELEMENT_SEP);
+            if (next.type != Token::OBJ_END) parser.fail(ParseErrorCode::EXPECTED_OBJECT_END);
+        }
+    };
+
+    namespace detail
+    {
+        /**Write a patch value that is not an object.*/
+        template<typename WriterT>
+        void write_patch_value(WriterT &writer, const std::string &json)
+        {
+            Parser parser(json.data(), json.data() + json.size());
+            copy(writer, parser);
+        }
+        /**JSON writers copy the text directly.*/
+        template<typename Stats, typename Buffer>
+        void write_patch_value(BasicWriter<Stats, Buffer> &writer, const std::string &json)
+        {
+            writer.raw_value(json);
+        }
+
+        /**Copy a member value the patch does not change.*/
+        template<typename WriterT, typename ParserT>
+        void copy_unpatched(WriterT &writer, ParserT &parser)
+        {
+            copy(writer, parser);
+        }
+        /**From JSON to JSON the input text is skipped over then written as it is, without
+         * decoding or escaping any strings.
+         */
+        template<typename Stats, typename Buffer, typename ParserStats>
+        void copy_unpatched(BasicWriter<Stats, Buffer> &writer, BasicParser<ParserStats> &parser)
+        {
+            auto start = parser.position();
+            skip_value(parser);
+            if (parser.failed()) return;
+            auto end = parser.position();
+            while (start < end && (*start == ' ' || *start == '\t' || *start == '\n' || *start == '\r')) ++start;
+            writer.raw_value_ref(std::string_view(start, (size_t)(end - start)));
+        }
+
+        /**Write the result of applying node to a missing or non-object target, which is node
+         * with any null members removed.
+         */
+        template<typename WriterT>
+        void write_patch_node(WriterT &writer, const MergePatch::Node &node)
+        {
+            if (!node.obj) return write_patch_value(writer, node.value);
+            writer.start_obj();
+            for (size_t i = 0; i < node.members.size(); ++i)
+            {
+                if (node.members[i].is_null()) continue;
+                writer.key(node.keys[i]);
+                write_patch_node(writer, node.members[i]);
+            }
+            writer.end_obj();
+        }
+
+        template<typename WriterT, typename ParserT>
+        void apply_patch_node(WriterT &writer, ParserT &parser, const MergePatch::Node &node)
+        {
+            auto tok = parser.next();
+            if (!node.obj || tok.type != Token::OBJ_START)
+            {
+                // the target is replaced
+                if (tok.type == Token::ARR_START || tok.type == Token::OBJ_START) skip_tokens(parser, tok);
+                else if (tok.type == Token::END || tok.type == Token::ARR_END || tok.type == Token::OBJ_END ||
+                    tok.type == Token::ELEMENT_SEP || tok.type == Token::KEY_SEP)
+                {
+                    return parser.fail(ParseErrorCode::EXPECTED_VALUE);
+                }
+                return write_patch_node(writer, node);
+            }
+
+            writer.start_obj();
+            std::vector<bool> seen(node.members.size(), false);
+            if (!parser.try_next_obj_end())
+            {
+                Token next;
+                do
+                {
+                    auto key = parser.next_str();
+                    parser.next_key_sep();
+                    auto i = node.find(key);
+                    if (i == (size_t)-1)
+                    {
+                        writer.key(key);
+                        copy_unpatched(writer, parser);
+                    }
+                    else
+                    {
+                        seen[i] = true;
+                        if (node.members[i].is_null()) skip_value(parser);
+                        else
+                        {
+                            writer.key(key);
+                            apply_patch_node(writer, parser, node.members[i]);
+                        }
+                    }
+                    next = parser.next();
+                }
+                while (next.type == Token::ELEMENT_SEP);
+                if (next.type != Token::OBJ_END) return parser.fail(ParseErrorCode::EXPECTED_OBJECT_END);
+            }
+            // keys that were not in the target are added at the end
+            for (size_t i = 0; i < node.members.size(); ++i)
+            {
+                if (seen[i] || node.members[i].is_null()) continue;
+                writer.key(node.keys[i]);
+                write_patch_node(writer, node.members[i]);
+            }
+            writer.end_obj();
+        }
+    }
+
+    /**Apply patch to the next value in doc, writing the result to writer.
+     *
+     * The document is streamed through: members the patch does not mention are copied as they
+     * are, only patched members are rewritten, and new members are added at the end of their
+     * object. Only the patch is held in memory.
+     *
+     * From a Parser to a JSON writer, unpatched members are copied as their input text, so keep
+     * any whitespace inside them. With an IovecWriter that text is referenced rather than
+     * copied, so doc must stay valid until the output is written.
+     */
+    template<typename WriterT, typename ParserT>
+    void apply_merge_patch(WriterT &writer, ParserT &doc, const MergePatch &patch)
+    {
+        detail::RawNumberScope<ParserT> raw_numbers(doc);
+        detail::apply_patch_node(writer, doc, patch.root_node());
+    }
+    /**Apply patch to the JSON document doc, and return the result.*/
+    inline std::string apply_merge_patch(const std::string &doc, const MergePatch &patch)
+    {
+        Parser parser(doc.data(), doc.data() + doc.size());
+        Writer writer;
+        apply_merge_patch(writer, parser, patch);
+        if (parser.next().type != Token::END) parser.fail(ParseErrorCode::EXPECTED_END);
+        return std::move(writer.str());
+    }
+}
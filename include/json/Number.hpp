@@ -0,0 +1,216 @@
+#pragma once
+#include "Simd.hpp"
+#include <cerrno>
+#include <cfloat>
+#include <cmath>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <system_error>
+namespace json
+{
+    namespace detail
+    {
+        /**The first byte from p that is not an ASCII digit, or end. Long runs of digits, as in
+         * full precision coordinates, are checked 16 bytes at a time.
+         */
+        inline const char *skip_digits(const char *p, const char *end)
+        {
+#ifdef JSON_HAS_SSE2
+            // digits are the bytes that are not below '0' or above '9' as signed bytes
+            const __m128i below = _mm_set1_epi8('0' - 1);
+            const __m128i above = _mm_set1_epi8('9' + 1);
+            while (end - p >= 16)
+            {
+                auto bytes = _mm_loadu_si128((const __m128i*)p);
+                auto digits = _mm_and_si128(_mm_cmpgt_epi8(bytes, below), _mm_cmplt_epi8(bytes, above));
+                unsigned mask = (unsigned)_mm_movemask_epi8(digits) ^ 0xFFFF;
+                if (mask) return p + count_trailing_zeros(mask);
+                p += 16;
+            }
+#endif
+            while (p < end && (unsigned char)(*p - '0') < 10) ++p;
+            return p;
+        }
+        /**Convert x to the floating point type T. Returns false if x is finite but larger than
+         * T can hold, where the conversion would be undefined.
+         */
+        template<typename T>
+        bool narrow_float(double x, T *out)
+        {
+            if (std::isfinite(x) && std::fabs(x) > (double)std::numeric_limits<T>::max()) return false;
+            *out = (T)x;
+            return true;
+        }
+    }
+
+    /**The unconverted text of a JSON number, as returned by BasicParser::next_raw_number and in
+     * RAW_NUMBER tokens. Points into the parser input, so is only valid while that is.
+     *
+     * The text has already been checked against the JSON number grammar, and is classified so
+     * that callers can pick a conversion without rescanning it. Conversion only happens when
+     * one of the to_ methods is called, so numbers that are skipped or copied cost nothing, and
+     * integers of any size can be passed through exactly.
+     */
+    struct RawNumber
+    {
+        enum Flags
+        {
+            /**Starts with '-'.*/
+            NEGATIVE = 1,
+            /**Has a '.' fraction.*/
+            FRACTION = 2,
+            /**Has an 'e' or 'E' exponent.*/
+            EXPONENT = 4
+        };
+
+        const char *str;
+        unsigned len;
+        unsigned flags;
+
+        bool negative()const { return (flags & NEGATIVE) != 0; }
+        /**True if there is no fraction or exponent. The value may still not fit an integer type.*/
+        bool is_integer()const { return (flags & (FRACTION | EXPONENT)) == 0; }
+
+        /**The number text, e.g. for a decimal type or an ID that is too large for any integer.*/
+        std::string to_string()const { return std::string(str, len); }
+
+        /**Convert an integer to a long long. Returns false if not an integer or it overflows.*/
+        bool to_int(long long *out)const
+        {
+            typedef std::numeric_limits<long long> limits;
+            if (!is_integer()) return false;
+            unsigned long long x;
+            if (!to_magnitude(&x)) return false;
+            if (negative())
+            {
+                if (x > (unsigned long long)limits::max() + 1) return false;
+                *out = x == (unsigned long long)limits::max() + 1 ? limits::min() : -(long long)x;
+            }
+            else
+            {
+                if (x > (unsigned long long)limits::max()) return false;
+                *out = (long long)x;
+            }
+            return true;
+        }
+        /**Convert a non-negative integer to an unsigned long long.
+         * Returns false if not an integer, negative or it overflows.
+         */
+        bool to_uint(unsigned long long *out)const
+        {
+            if (!is_integer() || negative()) return false;
+            return to_magnitude(out);
+        }
+        /**Convert to the nearest double. Returns false if out of range, in which case out is set
+         * to infinity or 0 as by strtod.
+         */
+        bool to_double(double *out)const
+        {
+            if (to_double_exact(out)) return true;
+#ifdef __cpp_lib_to_chars
+            // locale independent and needs no null terminated copy, but leaves out unset if out
+            // of range, so those cases still go to strtod
+            auto result = std::from_chars(str, str + len, *out);
+            if (result.ec == std::errc() && result.ptr == str + len) return true;
+#endif
+            return to_double_strtod(out);
+        }
+    private:
+        /**The common case of at most 15 significant digits and a power of ten up to 22, where
+         * both are exact doubles and so a single multiply or divide is correctly rounded.
+         */
+        bool to_double_exact(double *out)const
+        {
+#if FLT_EVAL_METHOD == 0
+            static const double powers[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+            uint64_t mantissa = 0;
+            int digits = 0, exp = 0;
+            size_t i = negative() ? 1 : 0;
+            for (; i < len && str[i] != '.' && str[i] != 'e' && str[i] != 'E'; ++i)
+            {
+                mantissa = mantissa * 10 + (unsigned)(str[i] - '0');
+                if (mantissa && ++digits > 15) return false;
+            }
+            if (i < len && str[i] == '.')
+            {
+                for (++i; i < len && str[i] != 'e' && str[i] != 'E'; ++i)
+                {
+                    mantissa = mantissa * 10 + (unsigned)(str[i] - '0');
+                    if (mantissa && ++digits > 15) return false;
+                    --exp;
+                }
+            }
+            if (i < len)
+            {
+                ++i; // 'e'
+                bool exp_negative = str[i] == '-';
+                if (str[i] == '-' || str[i] == '+') ++i;
+                int e = 0;
+                for (; i < len; ++i)
+                {
+                    e = e * 10 + (str[i] - '0');
+                    if (e > 1000) return false;
+                }
+                exp += exp_negative ? -e : e;
+            }
+            double x = (double)mantissa;
+            if (mantissa != 0 && exp < 0)
+            {
+                if (exp < -22) return false;
+                x /= powers[-exp];
+            }
+            else if (mantissa != 0)
+            {
+                if (exp > 22) return false;
+                x *= powers[exp];
+            }
+            *out = negative() ? -x : x;
+            return true;
+#else
+            (void)out;
+            return false;
+#endif
+        }
+        bool to_double_strtod(double *out)const
+        {
+            // strtod needs a null terminated string
+            char buffer[64];
+            std::string long_str;
+            const char *cstr;
+            if (len < sizeof(buffer))
+            {
+                for (size_t i = 0; i < len; ++i) buffer[i] = str[i];
+                buffer[len] = '\0';
+                cstr = buffer;
+            }
+            else
+            {
+                long_str.assign(str, len);
+                cstr = long_str.c_str();
+            }
+            errno = 0;
+            *out = std::strtod(cstr, nullptr);
+            return errno != ERANGE;
+        }
+        bool to_magnitude(unsigned long long *out)const
+        {
+            typedef std::numeric_limits<unsigned long long> limits;
+            unsigned long long x = 0;
+            for (size_t i = negative() ? 1 : 0; i < len; ++i)
+            {
+                unsigned digit = (unsigned)(str[i] - '0');
+                if (x > limits::max() / 10 || (x == limits::max() / 10 && digit > limits::max() % 10)) return false;
+                x = x * 10 + digit;
+            }
+            *out = x;
+            return true;
+        }
+    };
+}
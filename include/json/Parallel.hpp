@@ -0,0 +1,149 @@
+#pragma once
+#include "Writer.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+namespace json
+{
+    /**Writes a random access container (such as std::vector or std::deque) as a JSON array,
+     * formatting chunks of chunk_size elements on worker threads.
+     *
+     * sink is called on the calling thread with each chunk of output in order, as a
+     * "std::string&" it may move from. The chunks together are the complete array: the first
+     * starts with '[', the rest with ',', and the last ends with ']'. While the sink writes one
+     * chunk the workers format the following ones, but no more than two per thread are held
+     * at once, so a large array can be streamed to a file or socket in bounded memory.
+     *
+     * threads defaults to std::thread::hardware_concurrency, and chunk_size to enough for
+     * about eight chunks per thread. With one thread or one chunk nothing is started.
+     *
+     * write_json for the elements must be safe to call from several threads at once. If it, or
+     * the sink, throws then the workers are stopped and the exception rethrown.
+     */
+    template<typename Container, typename Sink>
+    void write_json_parallel(const Container &arr, Sink &&sink, unsigned threads = 0, size_t chunk_size = 0)
+    {
+        size_t size = arr.size();
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        if (chunk_size == 0) chunk_size = std::max<size_t>(1, size / (threads * 8));
+        size_t chunk_count = std::max<size_t>(1, (size + chunk_size - 1) / chunk_size);
+
+        auto format = [&](size_t chunk, size_t reserve)
+        {
+            Writer writer;
+            writer.str().reserve(reserve);
+            writer.str() += chunk == 0 ? '[' : ',';
+            auto begin = arr.begin() + (ptrdiff_t)(chunk * chunk_size);
+            auto end = begin + (ptrdiff_t)std::min(chunk_size, size - chunk * chunk_size);
+            for (auto it = begin; it != end; ++it) writer.value(*it);
+            if (chunk + 1 == chunk_count) writer.str() += ']';
+            return std::move(writer.str());
+        };
+        if (threads == 1 || chunk_count == 1)
+        {
+            size_t last_size = 0;
+            for (size_t i = 0; i < chunk_count; ++i)
+            {
+                auto chunk = format(i, last_size);
+                last_size = chunk.size();
+                sink(chunk);
+            }
+            return;
+        }
+
+        size_t max_ahead = threads * 2;
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::vector<std::string> chunks(chunk_count);
+        std::vector<char> ready(chunk_count, 0);
+        size_t next = 0, flushed = 0;
+        bool stop = false;
+        std::exception_ptr error;
+
+        auto worker = [&]()
+        {
+            size_t last_size = 0;
+            while (true)
+            {
+                size_t i;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cond.wait(lock, [&] { return stop || next == chunk_count || next < flushed + max_ahead; });
+                    if (stop || next == chunk_count) return;
+                    i = next++;
+                }
+                std::string out;
+                try
+                {
+                    out = format(i, last_size);
+                    last_size = out.size();
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) error = std::current_exception();
+                    stop = true;
+                    cond.notify_all();
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    chunks[i] = std::move(out);
+                    ready[i] = 1;
+                }
+                cond.notify_all();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        try
+        {
+            for (size_t i = 0; i < std::min<size_t>(threads, chunk_count); ++i) workers.emplace_back(worker);
+            for (size_t i = 0; i < chunk_count; ++i)
+            {
+                std::string chunk;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cond.wait(lock, [&] { return stop || ready[i]; });
+                    if (stop) break;
+                    chunk = std::move(chunks[i]);
+                    flushed = i + 1;
+                }
+                cond.notify_all();
+                sink(chunk);
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cond.notify_all();
+        for (auto &thread : workers) thread.join();
+        if (error) std::rethrow_exception(error);
+    }
+
+    /**Like to_json for a random access container, but formatting it on several threads with
+     * write_json_parallel. The output is the same as to_json.
+     */
+    template<typename Container>
+    std::string to_json_parallel(const Container &arr, unsigned threads = 0, size_t chunk_size = 0)
+    {
+        std::vector<std::string> chunks;
+        write_json_parallel(arr, [&](std::string &chunk) { chunks.push_back(std::move(chunk)); }, threads, chunk_size);
+        size_t total = 0;
+        for (auto &chunk : chunks) total += chunk.size();
+        std::string out = std::move(chunks[0]);
+        out.reserve(total);
+        for (size_t i = 1; i < chunks.size(); ++i) out += chunks[i];
+        return out;
+    }
+}
@@ -1,42 +1,133 @@
 #pragma once
+#include "Error.hpp"
 #include "Token.hpp"
+#include "InternTable.hpp"
+#include "KeyTable.hpp"
+#include "Stats.hpp"
+#include "Time.hpp"
+#include "Utf8.hpp"
+#include <array>
 #include <stdexcept>
-#include <sstream>
 #include <limits>
 #include <cassert>
+#include <cstdint>
 #include <cstring>
+#include <memory_resource>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 namespace json
 {
-    class ParseError : public std::runtime_error
-    {
-    public:
-        static std::string full_msg(int line, int pos, const std::string &msg)
-        {
-            std::stringstream ss;
-            ss << line << ':' << pos << ' ' << msg;
-            return ss.str();
-        }
+    /**Default max_depth of parsers, the same as the default for validate.*/
+    static const size_t DEFAULT_MAX_DEPTH = 1024;
 
-        ParseError(int line, int pos, const std::string &msg)
-            : std::runtime_error(full_msg(line, pos, msg))
-        {}
-        ParseError(const std::string &msg) : std::runtime_error(msg) {}
-    };
     /**Parses JSON input as a sequence of tokens.
      * Does not keep track of previous tokens, so does no error checking involving such things.
+     *
+     * The memory resource is not used by the parser itself, but is passed on to allocator-aware
+     * values (e.g. std::pmr::string) that are created while reading, so that an entire parsed
+     * structure may be placed in a single arena.
+     *
+     * Stats is an instrumentation policy, see NoStats. The number of bytes consumed is reported
+     * when the parser is destroyed.
+     *
+     * By default string contents are copied as raw bytes. If validate_utf8 is enabled, strings
+     * (including skipped ones) that are not valid UTF-8 are rejected with a ParseError.
+     *
+     * Errors throw ParseError unless throw_errors is disabled, in which case the first error is
+     * recorded in result() and every later read fails immediately, returning END tokens and
+     * default values so that read functions unwind without exceptions.
      */
-    class Parser
+    template<typename Stats = NoStats>
+    class BasicParser : private Stats
     {
     public:
-        Parser(const char *begin, const char *end)
-            : begin(begin), p(begin), end(end)
+        typedef Stats StatsType;
+
+        BasicParser(const char *begin, const char *end,
+            std::pmr::memory_resource *resource = std::pmr::get_default_resource(),
+            Stats stats = Stats())
+            : Stats(stats)
+            , begin(begin), p(begin), end(end)
             , line_start(begin), line_num(1)
+            , mem_resource(resource), interns(nullptr)
+            , check_utf8(false), throwing(true), raw_nums(false), depth_limit(DEFAULT_MAX_DEPTH), nesting(0)
         {}
+        ~BasicParser()
+        {
+            if (Stats::enabled) stats().bytes((size_t)((p > end ? end : p) - begin));
+        }
+
+        /**The memory resource for allocator-aware values read from this parser.*/
+        std::pmr::memory_resource *resource()const { return mem_resource; }
+        /**The table for InternedString values read from this parser, which is not owned.*/
+        void intern_table(InternTable *table) { interns = table; }
+        InternTable *intern_table()const { return interns; }
+        /**The instrumentation policy.*/
+        Stats &stats() { return *this; }
+
+        /**Enable or disable rejecting strings that are not valid UTF-8, see find_invalid_utf8.
+         * Unpaired UTF-16 surrogates in escape sequences are always rejected.
+         */
+        void validate_utf8(bool enable) { check_utf8 = enable; }
+        bool validate_utf8()const { return check_utf8; }
+
+        /**Enable or disable returning numbers from next() as RAW_NUMBER tokens, which are not
+         * converted, rather than as INTEGER or NUMBER tokens. See RawNumber.
+         */
+        void raw_numbers(bool enable) { raw_nums = enable; }
+        bool raw_numbers()const { return raw_nums; }
+
+        /**The deepest nesting of arrays and objects that copy, skip_value, the other generic
+         * value readers and nested read_json calls will follow, before failing with
+         * ParseErrorCode::DEPTH_EXCEEDED. The parser itself does not track nesting.
+         */
+        void max_depth(size_t depth) { depth_limit = depth; }
+        size_t max_depth()const { return depth_limit; }
+        /**Count an array or object being read by read_json against max_depth, see
+         * detail::DepthScope. Returns false after failing if the limit is exceeded.
+         */
+        bool enter_nested()
+        {
+            if (nesting >= depth_limit) return fail(ParseErrorCode::DEPTH_EXCEEDED), false;
+            ++nesting;
+            return true;
+        }
+        void exit_nested() { --nesting; }
+
+        /**Enable or disable throwing ParseError on errors, see result().*/
+        void throw_errors(bool enable) { throwing = enable; }
+        bool throw_errors()const { return throwing; }
+        /**The first error if throw_errors is disabled.*/
+        const ParseResult &result()const { return error; }
+        /**True if an error was recorded with throw_errors disabled.*/
+        bool failed()const { return !error.ok(); }
+        /**The next unread input byte, e.g. to take the raw text of a skipped value.*/
+        const char *position()const { return p; }
+
+        /**Report an error at the current position. Throws a ParseError, with detail appended to
+         * the message, or if throw_errors is disabled records the first error and moves to the
+         * end of the input. Custom read_json overloads should use this rather than throwing
+         * ParseError directly, so that they also work without exceptions.
+         */
+        void fail(ParseErrorCode code, const std::string &detail = std::string())
+        {
+            if (throwing) throw ParseError(code, line_num, (int)(p - line_start), (size_t)(p - begin), detail);
+            if (error.ok())
+            {
+                error.code = code;
+                error.line = line_num;
+                error.column = (int)(p - line_start);
+                error.offset = (size_t)((p > end ? end : p) - begin);
+            }
+            p = end + 1;
+        }
 
         /**Parse the next token in the input.*/
         Token next()
         {
-            if (p > end) parse_error("Unexpected end of input");
+            if (p > end) return fail(ParseErrorCode::UNEXPECTED_END), Token::END;
+            stats().token();
             skip_ws();
             if (p == end) return ++p, Token::END;
             switch (*p)
@@ -63,18 +154,32 @@ namespace json
             case '9':
             case '-':
                 return do_next_number();
-            default: parse_error("Unexpected content");
+            default: return fail(ParseErrorCode::UNEXPECTED_CONTENT), Token::END;
             }
         }
 
         /**If the next token would be ARR_END, consume it and return true.*/
         bool try_next_arr_end()
         {
-            if (p > end) parse_error("Unexpected end of input");
+            if (p > end) return fail(ParseErrorCode::UNEXPECTED_END), false;
             skip_ws();
             if (p < end && *p == ']')
             {
                 ++p;
+                stats().token();
+                return true;
+            }
+            else return false;
+        }
+        /**If the next value is null, consume it and return true.*/
+        bool try_next_null()
+        {
+            if (p > end) return fail(ParseErrorCode::UNEXPECTED_END), false;
+            skip_ws();
+            if (p < end && *p == 'n')
+            {
+                consume_str("null");
+                stats().token();
                 return true;
             }
             else return false;
@@ -82,10 +187,12 @@ namespace json
         /**Skip the rest of a quoted string. */
         void skip_remaining_str()
         {
+            auto start = p;
             while (p < end)
             {
                 if (*p == '"')
                 {
+                    if (!check_str_utf8(start)) return;
                     ++p;
                     return;
                 }
@@ -97,13 +204,15 @@ namespace json
                 }
                 else ++p;
             }
-            parse_error("Failed to find end of string");
+            fail(ParseErrorCode::UNEXPECTED_END);
         }
         /**Read the next string, but discard the contents. */
         void skip_next_str()
         {
             skip_ws();
-            if (p >= end || *p != '"') parse_error("Expected string");
+            if (p >= end || *p != '"') return fail(ParseErrorCode::EXPECTED_STRING);
+            stats().token();
+            ++p; // "
             skip_remaining_str();
         }
 
@@ -114,32 +223,194 @@ namespace json
             next_str(&tmp);
             return tmp;
         }
-        void next_str(std::string *out)
+        /**Read the next string, appending it to out.
+         * Str may be any string type with a "+= char" operator, such as std::pmr::string.
+         */
+        template<typename Str> void next_str(Str *out)
         {
             skip_ws();
-            if (p >= end || *p != '"') parse_error("Expected string");
+            if (p >= end || *p != '"') return fail(ParseErrorCode::EXPECTED_STRING);
+            stats().token();
             parse_str(out);
         }
+
+        /**Read the next string without copying it where possible.
+         * Returns the input bytes if there are no escape sequences, else decodes the string into
+         * buffer and returns that. Only valid until the next read.
+         */
+        std::string_view next_str_view(std::string *buffer)
+        {
+            skip_ws();
+            if (p >= end || *p != '"') return fail(ParseErrorCode::EXPECTED_STRING), std::string_view();
+            if (auto raw_end = find_raw_str_end())
+            {
+                auto raw = p + 1;
+                consume_raw_str(raw_end);
+                if (failed()) return std::string_view();
+                return std::string_view(raw, (size_t)(raw_end - raw));
+            }
+            buffer->clear();
+            next_str(buffer);
+            if (failed()) return std::string_view();
+            return *buffer;
+        }
+        /**Read the next string and get its handle from table.
+         * Strings without escape sequences are looked up directly from the input bytes.
+         */
+        InternedString next_interned_str(InternTable &table)
+        {
+            std::string tmp;
+            auto str = next_str_view(&tmp);
+            if (failed()) return InternedString();
+            return table.intern(str);
+        }
+
+        /**If the next object key is key, consume it and the following ':', and return true.
+         * Otherwise nothing is consumed.
+         * Keys without escape sequences are compared directly against the input bytes.
+         */
+        bool try_next_key(const char *key, size_t len)
+        {
+            skip_ws();
+            if (p >= end || *p != '"') return fail(ParseErrorCode::EXPECTED_STRING), false;
+            auto quote = p;
+            if (auto raw_end = find_raw_str_end())
+            {
+                if ((size_t)(raw_end - (quote + 1)) != len || memcmp(quote + 1, key, len) != 0) return false;
+                consume_raw_str(raw_end);
+            }
+            else
+            {
+                std::string tmp;
+                next_str(&tmp);
+                if (failed()) return false;
+                if (tmp.size() != len || memcmp(tmp.data(), key, len) != 0)
+                {
+                    p = quote;
+                    return false;
+                }
+            }
+            next_key_sep();
+            return true;
+        }
+        template<size_t N>
+        bool try_next_key(const char (&key)[N])
+        {
+            return try_next_key(key, N - 1);
+        }
+        /**Read the next object key and the following ':', and return its index in table.
+         * If the key is not in the table returns KeyTable::npos, and if unknown is not null
+         * stores the decoded key in it.
+         * Keys without escape sequences are compared directly against the input bytes.
+         */
+        size_t next_key(const KeyTable &table, std::string *unknown = nullptr)
+        {
+            skip_ws();
+            if (p >= end || *p != '"') return fail(ParseErrorCode::EXPECTED_STRING), KeyTable::npos;
+            size_t index;
+            if (auto raw_end = find_raw_str_end())
+            {
+                auto raw = p + 1;
+                index = table.find(raw, (size_t)(raw_end - raw));
+                consume_raw_str(raw_end);
+                if (index == KeyTable::npos && unknown) unknown->assign(raw, raw_end);
+            }
+            else
+            {
+                std::string tmp;
+                next_str(&tmp);
+                index = table.find(tmp);
+                if (index == KeyTable::npos && unknown) *unknown = std::move(tmp);
+            }
+            next_key_sep();
+            return index;
+        }
+
+        /**Read the next string as an ISO 8601 time, see try_parse_iso_time.
+         * The time is converted directly from the input without creating a string.
+         */
+        time_t next_time()
+        {
+            long long secs;
+            unsigned nanos;
+            next_iso_time<std::chrono::seconds>(&secs, &nanos);
+            return (time_t)secs;
+        }
+        /**Read the next string as an ISO 8601 time, truncated to the precision of Duration.*/
+        template<typename Duration = std::chrono::system_clock::duration>
+        std::chrono::time_point<std::chrono::system_clock, Duration> next_time_point()
+        {
+            long long secs;
+            unsigned nanos;
+            next_iso_time<Duration>(&secs, &nanos);
+            return detail::make_time_point<Duration>(secs, nanos);
+        }
+
         template<typename T> T next_int()
         {
             skip_ws();
-            if (p >= end) parse_error("Expected int");
+            if (p >= end) return fail(ParseErrorCode::EXPECTED_INT), T();
+            stats().token();
+            typename Stats::Timer timer(*this, StatsCategory::NUMBER);
+            stats().number(false);
             return do_next_int<T>();
         }
         template<typename T> T next_uint()
         {
             skip_ws();
-            if (p >= end) parse_error("Expected unsigned int");
+            if (p >= end) return fail(ParseErrorCode::EXPECTED_INT), T();
+            stats().token();
+            typename Stats::Timer timer(*this, StatsCategory::NUMBER);
+            stats().number(false);
             return do_next_positive_int<T>();
         }
 
         double next_double()
         {
             skip_ws();
-            if (p >= end) parse_error("Expected int");
-            auto start = p;
-            if (*p == '-') ++p;
-            return complete_next_float(start);
+            if (p >= end) return fail(ParseErrorCode::EXPECTED_NUMBER), 0.0;
+            stats().token();
+            typename Stats::Timer timer(*this, StatsCategory::NUMBER);
+            return complete_next_float(p);
+        }
+        /**Read an array of numbers, or of fixed size std::array tuples of numbers such as
+         * [[x, y], [x, y]], appending the values to out.
+         * Accepts the same input as read_json_array, but scans the numbers and separators in
+         * one loop rather than a token at a time.
+         */
+        template<typename T, typename Alloc>
+        void next_number_array(std::vector<T, Alloc> *out)
+        {
+            if (!next_number_array_start()) return;
+            typename Stats::Timer timer(*this, StatsCategory::NUMBER);
+            if (try_next_arr_end()) return;
+            for (;;)
+            {
+                T value;
+                if (!next_array_number(&value)) return;
+                out->push_back(value);
+                skip_ws();
+                if (p >= end) return fail(ParseErrorCode::EXPECTED_ARRAY_END);
+                stats().token();
+                if (*p == ',') ++p;
+                else if (*p == ']')
+                {
+                    ++p;
+                    return;
+                }
+                else return fail(ParseErrorCode::EXPECTED_ARRAY_END);
+            }
+        }
+        /**Read the next number without converting it, see RawNumber.*/
+        RawNumber next_raw_number()
+        {
+            skip_ws();
+            if (p >= end) return fail(ParseErrorCode::EXPECTED_NUMBER), RawNumber{ end, 0, 0 };
+            stats().token();
+            typename Stats::Timer timer(*this, StatsCategory::NUMBER);
+            auto raw = scan_number();
+            stats().number(!raw.is_integer());
+            return raw;
         }
 
 
@@ -152,8 +423,9 @@ namespace json
             if (p < end && *p == ':')
             {
                 ++p;
+                stats().token();
             }
-            else parse_error("Expected ':'");
+            else fail(ParseErrorCode::EXPECTED_KEY_SEP);
         }
         /**true if next is ',', false if '}', else error.*/
         bool next_obj_el()
@@ -164,15 +436,17 @@ namespace json
                 if (*p == ',')
                 {
                     ++p;
+                    stats().token();
                     return true;
                 }
                 if (*p == '}')
                 {
                     ++p;
+                    stats().token();
                     return false;
                 }
             }
-            parse_error("Expected ',' or '}' after object value");
+            return fail(ParseErrorCode::EXPECTED_OBJECT_END), false;
         }
         /**If the next token would be OBJ_END, consume it and return true.*/
         bool try_next_obj_end()
@@ -183,20 +457,97 @@ namespace json
                 if (*p == '}')
                 {
                     ++p;
+                    stats().token();
                     return true;
                 }
                 else return false;
             }
-            parse_error("Unexpected end of input");
+            return fail(ParseErrorCode::UNEXPECTED_END), true;
         }
     private:
         const char *begin, *p, *end;
         const char *line_start;
         int line_num;
+        std::pmr::memory_resource *mem_resource;
+        InternTable *interns;
+        bool check_utf8;
+        bool throwing;
+        bool raw_nums;
+        size_t depth_limit;
+        /**Arrays and objects currently open in read_json.*/
+        size_t nesting;
+        ParseResult error;
 
-        [[noreturn]] void parse_error(const std::string &msg)
+        /**If enabled, validate the string contents [start, p) as UTF-8.
+         * Escape sequences are plain ASCII so the raw input can be checked in a single pass,
+         * rather than per character while decoding. Returns false if there was an error.
+         */
+        bool check_str_utf8(const char *start)
         {
-            throw ParseError(line_num, (int)(p - line_start), msg);
+            if (!check_utf8) return true;
+            auto invalid = find_invalid_utf8(start, p);
+            if (invalid == p) return true;
+            p = invalid;
+            fail(ParseErrorCode::INVALID_UTF8);
+            return false;
+        }
+
+        /**Read a time string, failing with INVALID_TIME if it is not valid or Duration cannot
+         * hold it.
+         */
+        template<typename Duration>
+        void next_iso_time(long long *secs, unsigned *nanos)
+        {
+            *secs = 0;
+            *nanos = 0;
+            skip_ws();
+            if (p >= end || *p != '"') return fail(ParseErrorCode::INVALID_TIME);
+            bool valid;
+            if (auto raw_end = find_raw_str_end())
+            {
+                auto raw = p + 1;
+                valid = try_parse_iso_time(raw, (size_t)(raw_end - raw), secs, nanos) &&
+                    detail::time_point_in_range<Duration>(*secs);
+                if (valid) consume_raw_str(raw_end);
+            }
+            else
+            {
+                // escape sequences are never needed, but are valid JSON
+                auto start = p;
+                std::string tmp;
+                next_str(&tmp);
+                if (failed()) return;
+                valid = try_parse_iso_time(tmp.data(), tmp.size(), secs, nanos) &&
+                    detail::time_point_in_range<Duration>(*secs);
+                if (!valid) p = start;
+            }
+            if (!valid)
+            {
+                *secs = 0;
+                *nanos = 0;
+                fail(ParseErrorCode::INVALID_TIME);
+            }
+        }
+
+        /**With p at an opening '"', find the closing '"' if the string has no escape sequences,
+         * else return null.
+         */
+        const char *find_raw_str_end()const
+        {
+            auto q = p + 1;
+            while (q < end && *q != '"' && *q != '\\') ++q;
+            if (q == end) return nullptr; // let parse_str report the error
+            return *q == '"' ? q : nullptr;
+        }
+        /**Consume a string found by find_raw_str_end.*/
+        void consume_raw_str(const char *raw_end)
+        {
+            stats().token();
+            auto start = p + 1;
+            p = raw_end;
+            if (!check_str_utf8(start)) return;
+            ++p; // "
+            stats().string(false);
         }
 
         template<char c>
@@ -206,8 +557,9 @@ namespace json
             if (p < end && *p == c)
             {
                 ++p;
+                stats().token();
             }
-            else parse_error(std::string("Expected ") + c);
+            else fail(c == '{' ? ParseErrorCode::EXPECTED_OBJECT : ParseErrorCode::UNEXPECTED_CONTENT);
         }
 
         template<size_t N>
@@ -218,7 +570,7 @@ namespace json
             {
                 p += N - 1;
             }
-            else parse_error(std::string("Expected ") + str);
+            else fail(ParseErrorCode::UNEXPECTED_CONTENT);
         }
 
         void skip_ws()
@@ -275,7 +627,7 @@ namespace json
             if (*p == '-')
             {
                 ++p;
-                if (p == end) parse_error("Unexpected end");
+                if (p == end) return fail(ParseErrorCode::UNEXPECTED_END), T();
                 return do_next_negative_int<T>();
             }
             else return do_next_positive_int<T>();
@@ -286,13 +638,16 @@ namespace json
         {
             typedef std::numeric_limits<T> limits;
             assert(p < end);
-            if (!is_digit(*p)) parse_error("Expected int");
+            if (!is_digit(*p)) return fail(ParseErrorCode::EXPECTED_INT), T();
+            if (*p == '0' && p + 1 < end && is_digit(p[1])) return fail(ParseErrorCode::INVALID_NUMBER), T();
             T x = 0;
             do
             {
                 int y = *p - '0';
-                if (x > limits::max() / 10) parse_error("Overflow");
-                if (x == limits::max() / 10 && y > (int)(limits::max() % 10)) parse_error("Overflow");
+                if (x > limits::max() / 10 || (x == limits::max() / 10 && y > (int)(limits::max() % 10)))
+                {
+                    return fail(ParseErrorCode::NUMBER_OVERFLOW), T();
+                }
                 x = (T)(x * 10 + y);
                 ++p;
             }
@@ -305,13 +660,16 @@ namespace json
             typedef std::numeric_limits<T> limits;
             typedef typename std::make_unsigned<T>::type ut;
             assert(p < end);
-            if (!is_digit(*p)) parse_error("Expected int");
+            if (!is_digit(*p)) return fail(ParseErrorCode::EXPECTED_INT), T();
+            if (*p == '0' && p + 1 < end && is_digit(p[1])) return fail(ParseErrorCode::INVALID_NUMBER), T();
             T x = 0;
             do
             {
                 int y = *p - '0';
-                if (x < limits::min() / 10) parse_error("Overflow");
-                if (x == limits::min() / 10 && y > (int)(((ut)limits::min()) % 10)) parse_error("Overflow");
+                if (x < limits::min() / 10 || (x == limits::min() / 10 && y > (int)(((ut)limits::min()) % 10)))
+                {
+                    return fail(ParseErrorCode::NUMBER_OVERFLOW), T();
+                }
                 x = (T)(x * 10 - y);
                 ++p;
             }
@@ -319,70 +677,178 @@ namespace json
             return x;
         }
 
-        double complete_next_float(const char *start)
+        /**Consume one or more digits.*/
+        bool scan_digits()
+        {
+            if (p >= end || !is_digit(*p)) return fail(ParseErrorCode::INVALID_NUMBER), false;
+            p = detail::skip_digits(p + 1, end);
+            return true;
+        }
+        /**Consume a number at p, checking the JSON number grammar but not converting it.*/
+        RawNumber scan_number()
         {
-            assert(p < end && start <= p);
-            while(p < end && is_digit(*p)) ++p;
+            auto start = p;
+            unsigned flags = 0;
+            if (p < end && *p == '-')
+            {
+                flags |= RawNumber::NEGATIVE;
+                ++p;
+                if (p == end) return fail(ParseErrorCode::UNEXPECTED_END), RawNumber{ end, 0, 0 };
+            }
+            // no leading zeros, a 0 integer part may only be followed by a fraction or exponent
+            if (p + 1 < end && *p == '0' && is_digit(p[1])) return fail(ParseErrorCode::INVALID_NUMBER), RawNumber{ end, 0, 0 };
+            if (!scan_digits()) return RawNumber{ end, 0, 0 };
             if (p < end && *p == '.')
             {
+                flags |= RawNumber::FRACTION;
                 ++p;
-                while (p < end && is_digit(*p)) ++p;
+                if (!scan_digits()) return RawNumber{ end, 0, 0 };
             }
             if (p < end && (*p == 'e' || *p == 'E'))
             {
+                flags |= RawNumber::EXPONENT;
                 ++p;
-                if (p < end && (*p == '+' || *p == '-'))
-                {
-                    ++p;
-                    while (p < end && is_digit(*p)) ++p;
-                }
+                if (p < end && (*p == '+' || *p == '-')) ++p;
+                if (!scan_digits()) return RawNumber{ end, 0, 0 };
             }
-            //using stod for now
-            std::string str(start, p);
-            size_t count;
-            try
+            return RawNumber{ start, (unsigned)(p - start), flags };
+        }
+
+        bool next_number_array_start()
+        {
+            if (p > end) return fail(ParseErrorCode::UNEXPECTED_END), false;
+            skip_ws();
+            if (p >= end || *p != '[') return fail(ParseErrorCode::EXPECTED_ARRAY), false;
+            ++p;
+            stats().token();
+            return true;
+        }
+        /**An element for next_number_array, returns false on error.*/
+        template<typename T>
+        typename std::enable_if<std::is_floating_point<T>::value, bool>::type next_array_number(T *out)
+        {
+            skip_ws();
+            if (p >= end) return fail(ParseErrorCode::EXPECTED_NUMBER), false;
+            stats().token();
+            auto start = p;
+            double x = complete_next_float(p);
+            if (failed()) return false;
+            if (detail::narrow_float(x, out)) return true;
+            p = start;
+            return fail(ParseErrorCode::NUMBER_OVERFLOW), false;
+        }
+        template<typename T>
+        typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, bool>::type next_array_number(T *out)
+        {
+            skip_ws();
+            if (p >= end) return fail(ParseErrorCode::EXPECTED_INT), false;
+            stats().token();
+            stats().number(false);
+            *out = do_next_int<T>();
+            return !failed();
+        }
+        template<typename T>
+        typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value, bool>::type next_array_number(T *out)
+        {
+            skip_ws();
+            if (p >= end) return fail(ParseErrorCode::EXPECTED_INT), false;
+            stats().token();
+            stats().number(false);
+            *out = do_next_positive_int<T>();
+            return !failed();
+        }
+        /**A tuple of exactly N numbers, with the same errors as read_json for std::array.*/
+        template<typename T, size_t N>
+        bool next_array_number(std::array<T, N> *out)
+        {
+            if (!next_number_array_start()) return false;
+            for (size_t i = 0; i < N; ++i)
             {
-                auto x = std::stod(str, &count);
-                if (count != str.size()) parse_error(str + " is not a valid number");
-                return x;
+                if (i != 0)
+                {
+                    skip_ws();
+                    if (p < end && *p == ',') ++p;
+                    else return fail(p < end && *p == ']' ? ParseErrorCode::EXPECTED_VALUE : ParseErrorCode::EXPECTED_ARRAY_END), false;
+                    stats().token();
+                }
+                if (!next_array_number(&(*out)[i])) return false;
             }
-            catch (const std::exception &)
+            skip_ws();
+            if (p < end && *p == ']')
             {
-                parse_error("Expected number");
+                ++p;
+                stats().token();
+                return true;
             }
+            if (p < end && *p == ',') return fail(ParseErrorCode::CAPACITY_EXCEEDED), false;
+            return fail(ParseErrorCode::EXPECTED_ARRAY_END), false;
+        }
+
+        /**Read and convert the number at start, which may have a fraction or exponent.*/
+        double complete_next_float(const char *start)
+        {
+            p = start;
+            auto raw = scan_number();
+            if (failed()) return 0.0;
+            stats().number(true);
+            double x;
+            if (raw.to_double(&x)) return x;
+            p = start;
+            return fail(ParseErrorCode::INVALID_NUMBER), 0.0;
         }
 
         Token do_next_number()
         {
-            auto start = p;
-            long long x = do_next_int<long long>();
-            if (p >= end || (*p != '.' && *p != 'e' && *p != 'E'))
+            typename Stats::Timer timer(*this, StatsCategory::NUMBER);
+            if (raw_nums)
             {
-                return Token(x);
+                auto raw = scan_number();
+                stats().number(!raw.is_integer());
+                return Token(raw);
             }
-            else
+            // the whole number is scanned first, so integers too large for a long long and
+            // numbers with a fraction or exponent are read as doubles, as by next_double
+            auto start = p;
+            auto raw = scan_number();
+            if (failed()) return Token();
+            long long x;
+            if (raw.to_int(&x))
             {
-                ++p;
-                if (p >= end) parse_error("Unexpected end");
-                return Token(complete_next_float(start));
+                stats().number(false);
+                return Token(x);
             }
+            stats().number(true);
+            double d;
+            if (raw.to_double(&d)) return Token(d);
+            p = start;
+            return fail(ParseErrorCode::INVALID_NUMBER), Token();
         }
 
-        //TODO: Does not handle escape codes, or any illegal bytes, just goes to next "
-        void parse_str(std::string *out)
+        /**Read the string with p at its opening '"', appending it to out with escape sequences
+         * decoded. The raw bytes are checked to be UTF-8 if validate_utf8 is enabled.
+         */
+        template<typename Str>
+        void parse_str(Str *out)
         {
+            typename Stats::Timer timer(*this, StatsCategory::STRING);
+            auto capacity = out->capacity();
+            bool escaped = false;
             assert(*p == '"');
             ++p;
+            auto start = p;
+            unsigned char bits = 0; // OR of the raw bytes, so pure ASCII strings skip the UTF-8 check
             while (p < end && *p != '"')
             {
                 if (*p != '\\')
                 {
+                    bits |= (unsigned char)*p;
                     *out += *p;
                     ++p;
                 }
                 else
                 {
-                    if (++p == end) parse_error("End of string not found");
+                    escaped = true;
+                    if (++p == end) return fail(ParseErrorCode::UNEXPECTED_END);
                     switch (*p)
                     {
                     case 'n': *out += '\n'; ++p; break;
@@ -397,8 +863,11 @@ namespace json
                     }
                 }
             }
-            if (p == end) parse_error("End of string not found");
+            if (p >= end) return fail(ParseErrorCode::UNEXPECTED_END);
+            if ((bits & 0x80) && !check_str_utf8(start)) return;
             ++p; // "
+            stats().string(escaped);
+            if (out->capacity() != capacity) stats().allocation();
         }
         Token parse_str()
         {
@@ -407,49 +876,63 @@ namespace json
             return ret;
         }
 
-        void decode_unicode(std::string *buf)
+        template<typename Str>
+        void decode_unicode(Str *buf)
         {
             assert(*p == 'u');
             ++p;
-            if (p + 4 > end) parse_error("Unexpected end");
+            if (p + 4 > end) return fail(ParseErrorCode::UNEXPECTED_END);
             //this is a slight pain because JSON always uses UTF-16, even in its escape codes
             //so must deal with surrogate pairs to get a code point, then convert to utf-8
-            unsigned high = decode_unicode_utf16_el();
+            unsigned high;
+            if (!decode_unicode_utf16_el(&high)) return;
             if (high <= 0xD7FF || high >= 0xE000) //single element
             {
                 cp_to_utf8(high, buf);
             }
             else //surrogate pair
             {
-                if (high >= 0xDC00) parse_error("Unexpected low surrogate");
-
-                if (p + 6 > end) parse_error("Unexpected end looking for second surrogate");
-                if (p[0] != '\\' || p[1] != 'u') parse_error("Expected \\uxxxx for second surrogate");
+                //high surrogate must be followed by a \\uxxxx low surrogate
+                if (high >= 0xDC00 || p + 6 > end || p[0] != '\\' || p[1] != 'u')
+                {
+                    return fail(ParseErrorCode::INVALID_ESCAPE);
+                }
                 p += 2;
-                unsigned low = decode_unicode_utf16_el();
-                if (low < 0xDC00 || low > 0xDFFF) parse_error("Expected low surrogate");
+                unsigned low;
+                if (!decode_unicode_utf16_el(&low)) return;
+                if (low < 0xDC00 || low > 0xDFFF) return fail(ParseErrorCode::INVALID_ESCAPE);
                 unsigned cp = ((high - 0xD800) << 10) + (low - 0xDC00) + 0x10000;
                 cp_to_utf8(cp, buf);
             }
         }
-        unsigned decode_unicode_utf16_el()
+        bool decode_unicode_utf16_el(unsigned *cp)
         {
-            unsigned cp =
-                (decode_hex(p[0]) << 12) |
-                (decode_hex(p[1]) <<  8) |
-                (decode_hex(p[2]) <<  4) |
-                (decode_hex(p[3]) <<  0);
+            unsigned x = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                unsigned digit = decode_hex(p[i]);
+                if (digit > 15)
+                {
+                    p += i;
+                    fail(ParseErrorCode::INVALID_ESCAPE);
+                    return false;
+                }
+                x = (x << 4) | digit;
+            }
             p += 4;
-            return cp;
+            *cp = x;
+            return true;
         }
-        unsigned decode_hex(char c)
+        /**Value of a hex digit, or 16 if c is not one.*/
+        static unsigned decode_hex(char c)
         {
             if (c >= '0' && c <= '9') return c - '0';
             if (c >= 'a' && c <= 'f') return c - 'a' + 10;
             if (c >= 'A' && c <= 'F') return c - 'A' + 10;
-            parse_error("Invalid hex digit");
+            return 16;
         }
-        void cp_to_utf8(unsigned cp, std::string *buf)
+        template<typename Str>
+        void cp_to_utf8(unsigned cp, Str *buf)
         {
             if (cp < 0x80) //0xxxxxxx
             {
@@ -476,4 +959,113 @@ namespace json
             }
         }
     };
+
+    /**Parser without instrumentation.*/
+    typedef BasicParser<> Parser;
+
+    /**True for types that provide the BasicParser token API, which the generic read_json
+     * overloads accept. Specialised for each parser class, such as CborParser.
+     */
+    template<typename T> struct is_parser : public std::false_type {};
+    template<typename Stats> struct is_parser<BasicParser<Stats>> : public std::true_type {};
+
+    /**R if ParserT is a parser, for constraining read_json overloads that take any parser type.*/
+    template<typename ParserT, typename R = void>
+    using if_parser = typename std::enable_if<is_parser<ParserT>::value, R>::type;
+
+    namespace detail
+    {
+        /**Whether each open container is an object, for walking nested values without recursion.
+         * Unlike the fixed capacity BitStack used by validate, this grows to any max_depth, with
+         * the first 64 levels stored without allocating.
+         */
+        class LevelStack
+        {
+        public:
+            LevelStack() : top_bits(0), count(0), words() {}
+
+            size_t size()const { return count; }
+            bool empty()const { return count == 0; }
+            bool top()const
+            {
+                assert(count > 0);
+                return (top_bits & 1) != 0;
+            }
+            void push(bool bit)
+            {
+                if (count != 0 && count % 64 == 0)
+                {
+                    words.push_back(top_bits);
+                    top_bits = 0;
+                }
+                top_bits = (top_bits << 1) | (bit ? 1 : 0);
+                ++count;
+            }
+            bool pop()
+            {
+                assert(count > 0);
+                bool bit = (top_bits & 1) != 0;
+                top_bits >>= 1;
+                --count;
+                if (count != 0 && count % 64 == 0)
+                {
+                    top_bits = words.back();
+                    words.pop_back();
+                }
+                return bit;
+            }
+        private:
+            /**The newest levels, up to 64, with the top in the lowest bit.*/
+            uint64_t top_bits;
+            size_t count;
+            /**Full words of older levels.*/
+            std::vector<uint64_t> words;
+        };
+
+        /**Counts a read_json array or object against the parser's max_depth for a scope, so
+         * self-referential types fail with ParseErrorCode::DEPTH_EXCEEDED on deep input rather
+         * than overflowing the call stack. False if the limit was exceeded.
+         */
+        template<typename ParserT>
+        class DepthScope
+        {
+        public:
+            explicit DepthScope(ParserT &parser) : parser(parser), entered(parser.enter_nested()) {}
+            ~DepthScope()
+            {
+                if (entered) parser.exit_nested();
+            }
+            explicit operator bool()const { return entered; }
+        private:
+            ParserT &parser;
+            bool entered;
+        };
+
+        /**Enables BasicParser::raw_numbers for a scope, for functions such as copy and skip_value
+         * that only forward or discard numbers. Does nothing for other parser types.
+         */
+        template<typename ParserT>
+        class RawNumberScope
+        {
+        public:
+            explicit RawNumberScope(ParserT &) {}
+        };
+        template<typename Stats>
+        class RawNumberScope<BasicParser<Stats>>
+        {
+        public:
+            explicit RawNumberScope(BasicParser<Stats> &parser)
+                : parser(parser), prev(parser.raw_numbers())
+            {
+                parser.raw_numbers(true);
+            }
+            ~RawNumberScope()
+            {
+                parser.raw_numbers(prev);
+            }
+        private:
+            BasicParser<Stats> &parser;
+            bool prev;
+        };
+    }
 }
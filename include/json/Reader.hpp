@@ -1,268 +1,644 @@
 #pragma once
+#include "Base64.hpp"
 #include "Parser.hpp"
 #include "Time.hpp"
+#include <array>
+#include <cstring>
 #include <unordered_map>
 #include <limits>
+#include <memory_resource>
+#include <stdexcept>
 namespace json
 {
     namespace detail
     {
+        template<typename T> struct is_string : public std::false_type {};
+        template<typename Traits, typename Alloc>
+        struct is_string<std::basic_string<char, Traits, Alloc>> : public std::true_type {};
+
         template<typename T>
         auto has_push_back_impl(int) -> decltype(
             std::declval<T>().push_back(std::declval<typename T::value_type>()),
             std::true_type{});
         template<typename T> std::false_type has_push_back_impl(...);
-        template<typename T> struct has_push_back : public decltype(has_push_back_impl<T>(0)) {};
+        /**T has push_back, and is not a string (which has its own read_json overload).*/
+        template<typename T> struct has_push_back : public std::integral_constant<bool,
+            decltype(has_push_back_impl<T>(0))::value && !is_string<T>::value> {};
+
+        template<typename T>
+        auto has_emplace_back_impl(int) -> decltype(
+            std::declval<T>().emplace_back(),
+            std::true_type{});
+        template<typename T> std::false_type has_emplace_back_impl(...);
+        template<typename T> struct has_emplace_back : public decltype(has_emplace_back_impl<T>(0)) {};
+
+        template<typename T>
+        auto has_back_ref_impl(int) -> std::is_same<decltype(std::declval<T&>().back()), typename T::value_type&>;
+        template<typename T> std::false_type has_back_ref_impl(...);
+        /**T can construct an element with emplace_back and then read it through a reference from
+         * back(). Not std::vector<bool>, where back() returns a proxy.
+         */
+        template<typename T> struct has_emplace_back_ref : public std::integral_constant<bool,
+            has_emplace_back<T>::value && decltype(has_back_ref_impl<T>(0))::value> {};
 
         template<typename T>
         auto has_kv_emplace_impl(int) -> decltype(
-            std::declval<T>().emplace(std::string(), std::declval<typename T::value_type::second_type>()),
+            std::declval<T>().emplace(
+                std::declval<typename T::key_type>(),
+                std::declval<typename T::value_type::second_type>()),
             std::true_type{});
         template<typename T> std::false_type has_kv_emplace_impl(...);
         template<typename T> struct has_kv_emplace : public decltype(has_kv_emplace_impl<T>(0)) {};
+
+        template<typename T>
+        auto has_try_emplace_impl(int) -> decltype(
+            std::declval<T>().try_emplace(std::declval<typename T::key_type>()),
+            std::true_type{});
+        template<typename T> std::false_type has_try_emplace_impl(...);
+        template<typename T> struct has_try_emplace : public decltype(has_try_emplace_impl<T>(0)) {};
+
+        /**True if a container with max_size, such as FixedVector, can not hold another element.*/
+        template<typename T>
+        auto is_full(const T &container, int) -> decltype(container.size() == container.max_size())
+        {
+            return container.size() == container.max_size();
+        }
+        template<typename T> bool is_full(const T &, long)
+        {
+            return false;
+        }
+
+        /**A string Str for next_str that writes into a char array, keeping space for a null
+         * terminator and recording any characters that did not fit.
+         */
+        class CharArrayBuffer
+        {
+        public:
+            CharArrayBuffer(char *buf, size_t size) : buf(buf), cap(size - 1), len(0), overflow(false) {}
+
+            size_t size()const { return len; }
+            size_t capacity()const { return cap; }
+            bool overflowed()const { return overflow; }
+
+            CharArrayBuffer &operator += (char c)
+            {
+                if (len < cap) buf[len++] = c;
+                else overflow = true;
+                return *this;
+            }
+            CharArrayBuffer &append(const char *str, size_t n)
+            {
+                if (n > cap - len)
+                {
+                    n = cap - len;
+                    overflow = true;
+                }
+                std::memcpy(buf + len, str, n);
+                len += n;
+                return *this;
+            }
+            void terminate() { buf[len] = '\0'; }
+        private:
+            char *buf;
+            size_t cap, len;
+            bool overflow;
+        };
+
+        /**T can be constructed from a std::pmr::memory_resource, e.g. std::pmr::string.*/
+        template<typename T> struct uses_resource
+            : public std::uses_allocator<T, std::pmr::polymorphic_allocator<char>> {};
+
+        /**Create a temporary value to be read into. If T is allocator-aware using
+         * std::pmr::polymorphic_allocator, it uses the parsers memory resource.
+         */
+        template<typename T, typename ParserT,
+            typename std::enable_if<uses_resource<T>::value>::type* = nullptr>
+        T make_value(ParserT &parser)
+        {
+            return T(parser.resource());
+        }
+        template<typename T, typename ParserT,
+            typename std::enable_if<!uses_resource<T>::value>::type* = nullptr>
+        T make_value(ParserT &)
+        {
+            return T();
+        }
     }
 
-    template<typename T> void read_json_int(Parser &parser, T *out)
+    template<typename ParserT, typename T> if_parser<ParserT> read_json_int(ParserT &parser, T *out)
     {
-        *out = parser.next_int<T>();
+        *out = parser.template next_int<T>();
     }
-    template<typename T> void read_json_uint(Parser &parser, T *out)
+    template<typename ParserT, typename T> if_parser<ParserT> read_json_uint(ParserT &parser, T *out)
     {
-        *out = parser.next_uint<T>();
+        *out = parser.template next_uint<T>();
     }
 
 
-    inline void read_json(Parser &parser, char *x)
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, char *x)
     {
         read_json_int(parser, x);
     }
-    inline void read_json(Parser &parser, short *x)
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, short *x)
     {
         read_json_int(parser, x);
     }
-    inline void read_json(Parser &parser, int *x)
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, int *x)
     {
         read_json_int(parser, x);
     }
-    inline void read_json(Parser &parser, long *x)
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, long *x)
     {
         read_json_int(parser, x);
     }
-    inline void read_json(Parser &parser, long long *x)
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, long long *x)
     {
         read_json_int(parser, x);
     }
 
-    inline void read_json(Parser &parser, unsigned char *x)
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, unsigned char *x)
     {
         read_json_uint(parser, x);
     }
-    inline void read_json(Parser &parser, unsigned short *x)
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, unsigned short *x)
     {
         read_json_uint(parser, x);
     }
-    inline void read_json(Parser &parser, unsigned int *x)
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, unsigned int *x)
     {
         read_json_uint(parser, x);
     }
-    inline void read_json(Parser &parser, unsigned long *x)
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, unsigned long *x)
     {
         read_json_uint(parser, x);
     }
-    inline void read_json(Parser &parser, unsigned long long *x)
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, unsigned long long *x)
     {
         read_json_uint(parser, x);
     }
 
-    inline void read_json(Parser &parser, float *x)
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, float *x)
     {
-        *x = (float)parser.next_double();
+        double d = parser.next_double();
+        if (!detail::narrow_float(d, x)) parser.fail(ParseErrorCode::NUMBER_OVERFLOW);
     }
-    inline void read_json(Parser &parser, double *x)
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, double *x)
     {
         *x = parser.next_double();
     }
 
-    inline void read_json(Parser &parser, bool *x)
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, bool *x)
     {
         auto tok = parser.next();
         if (tok.type == Token::TRUE_VAL) *x = true;
         else if (tok.type == Token::FALSE_VAL) *x = false;
-        else throw ParseError("Expected boolean");
+        else parser.fail(ParseErrorCode::EXPECTED_BOOL);
     }
 
-    inline void read_json(Parser &parser, std::string *str)
+    /**Read a string of any allocator type, including std::string and std::pmr::string.*/
+    template<typename ParserT, typename Traits, typename Alloc>
+    if_parser<ParserT> read_json(ParserT &parser, std::basic_string<char, Traits, Alloc> *str)
     {
         parser.next_str(str);
     }
 
-    /**Read from JSON string into out. */
+    /**Read a string as a handle from the parsers intern_table, which must have been set.*/
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, InternedString *str)
+    {
+        auto table = parser.intern_table();
+        if (!table) throw std::logic_error("InternedString read without an intern_table");
+        *str = parser.next_interned_str(*table);
+    }
+
+    /**Read a base64 string, appending the decoded bytes to out.
+     * Strings without escape sequences are decoded straight from the input. Padding is optional,
+     * and other invalid text fails with ParseErrorCode::INVALID_BASE64.
+     */
+    template<typename ParserT, typename Alloc>
+    if_parser<ParserT> read_json_base64(ParserT &parser, std::vector<unsigned char, Alloc> *out)
+    {
+        std::string buffer;
+        auto str = parser.next_str_view(&buffer);
+        auto size = out->size();
+        out->resize(size + base64::max_decoded_size(str.size()));
+        auto len = base64::decode(str, out->data() + size);
+        if (len < 0)
+        {
+            out->resize(size);
+            return parser.fail(ParseErrorCode::INVALID_BASE64);
+        }
+        out->resize(size + (size_t)len);
+    }
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, Blob *blob)
+    {
+        blob->bytes.clear();
+        read_json_base64(parser, &blob->bytes);
+    }
+
+    /**Read a string into a fixed size buffer, which is always null terminated, so can hold at
+     * most N - 1 bytes. Longer strings fail with ParseErrorCode::CAPACITY_EXCEEDED.
+     */
+    template<typename ParserT, size_t N>
+    if_parser<ParserT> read_json(ParserT &parser, char (*str)[N])
+    {
+        static_assert(N > 0, "No space for the null terminator");
+        detail::CharArrayBuffer buf(*str, N);
+        parser.next_str(&buf);
+        buf.terminate();
+        if (buf.overflowed()) parser.fail(ParseErrorCode::CAPACITY_EXCEEDED);
+    }
+
+    /**Read from JSON string into out.
+     * resource is passed to the Parser for use by allocator-aware values.
+     */
     template<typename T>
-    void read_json(const std::string &json, T *out)
+    void read_json(const std::string &json, T *out,
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
     {
-        Parser parser(json.data(), json.data() + json.size());
+        Parser parser(json.data(), json.data() + json.size(), resource);
         read_json(parser, out);
         auto end = parser.next();
-        if (end.type != Token::END) throw ParseError("Expected end");
+        if (end.type != Token::END) parser.fail(ParseErrorCode::EXPECTED_END);
     }
 
-    /**Read from JSON string into an instance of type T, and return it. */
-    template<typename T>
-    T read_json(const std::string &json)
+    /**Read from parser into an instance of type T, and return it. */
+    template<typename T, typename ParserT>
+    if_parser<ParserT, T> read_json(ParserT &parser)
     {
-        T tmp;
-        read_json(json, &tmp);
+        T tmp = detail::make_value<T>(parser);
+        read_json(parser, &tmp);
         return tmp;
     }
 
-    /**Read from parser into an instance of type T, and return it. */
+    /**Read from JSON string into an instance of type T, and return it.
+     * If T uses std::pmr::polymorphic_allocator, it and its contents are allocated from resource.
+     */
     template<typename T>
-    T read_json(Parser &parser)
+    T read_json(const std::string &json,
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
     {
-        T tmp;
-        read_json(parser, &tmp);
+        Parser parser(json.data(), json.data() + json.size(), resource);
+        T tmp = read_json<T>(parser);
+        auto end = parser.next();
+        if (end.type != Token::END) parser.fail(ParseErrorCode::EXPECTED_END);
         return tmp;
     }
 
-    /**Read into a container that has push_back.*/
-    template<typename T> void read_json_array(Parser &parser, T *container)
+    /**Read from JSON string into out without throwing ParseError, see BasicParser::throw_errors.
+     * Returns the first error, which converts to true on success. Only the error code and
+     * position are recorded, message() formats the text if needed.
+     * On failure out may have been partially read.
+     */
+    template<typename T>
+    ParseResult try_read_json(const std::string &json, T *out,
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
     {
+        Parser parser(json.data(), json.data() + json.size(), resource);
+        parser.throw_errors(false);
+        try
+        {
+            read_json(parser, out);
+            auto end = parser.next();
+            if (end.type != Token::END) parser.fail(ParseErrorCode::EXPECTED_END);
+        }
+        catch (const ParseError &e)
+        {
+            // from a custom read_json overload that throws rather than using BasicParser::fail
+            ParseResult result;
+            result.code = e.code();
+            result.line = e.line();
+            result.column = e.column();
+            result.offset = e.offset();
+            return result;
+        }
+        return parser.result();
+    }
+
+    namespace detail
+    {
+        /**Removes the last element of a container when destroyed, unless dismissed.*/
+        template<typename T>
+        class PopBackScope
+        {
+        public:
+            explicit PopBackScope(T *container) : container(container) {}
+            ~PopBackScope()
+            {
+                if (container) container->pop_back();
+            }
+            void dismiss() { container = nullptr; }
+        private:
+            T *container;
+        };
+
+        /**Erases an element of a map when destroyed, unless dismissed.*/
+        template<typename T>
+        class EraseScope
+        {
+        public:
+            EraseScope(T *container, typename T::iterator it) : container(container), it(it) {}
+            ~EraseScope()
+            {
+                if (container) container->erase(it);
+            }
+            void dismiss() { container = nullptr; }
+        private:
+            T *container;
+            typename T::iterator it;
+        };
+
+        template<typename ParserT> bool parser_failed(ParserT &) { return false; }
+        template<typename Stats> bool parser_failed(BasicParser<Stats> &parser) { return parser.failed(); }
+
+        /**Read the next array element, constructed by the container with emplace_back so
+         * that allocator-aware elements use the containers allocator. The element is removed
+         * again if reading it fails.
+         */
+        template<typename ParserT, typename T, typename std::enable_if<has_emplace_back_ref<T>::value>::type* = nullptr>
+        void read_array_element(ParserT &parser, T *container)
+        {
+            container->emplace_back();
+            PopBackScope<T> pop(container);
+            read_json(parser, &container->back());
+            if (!parser_failed(parser)) pop.dismiss();
+        }
+        template<typename ParserT, typename T, typename std::enable_if<!has_emplace_back_ref<T>::value>::type* = nullptr>
+        void read_array_element(ParserT &parser, T *container)
+        {
+            auto value = make_value<typename T::value_type>(parser);
+            read_json(parser, &value);
+            container->push_back(std::move(value));
+        }
+
+        /**Read the next map value, constructed in place with try_emplace where possible so that
+         * allocator-aware values use the containers allocator. The entry is removed again if
+         * reading the value fails.
+         * As with emplace, the first value for a duplicate key is kept.
+         */
+        template<typename ParserT, typename T, typename std::enable_if<has_try_emplace<T>::value>::type* = nullptr>
+        void read_map_value(ParserT &parser, T *container, typename T::key_type &&key)
+        {
+            auto inserted = container->try_emplace(std::move(key));
+            if (!inserted.second)
+            {
+                read_json<typename T::mapped_type>(parser);
+                return;
+            }
+            EraseScope<T> erase(container, inserted.first);
+            read_json(parser, &inserted.first->second);
+            if (!parser_failed(parser)) erase.dismiss();
+        }
+        template<typename ParserT, typename T, typename std::enable_if<!has_try_emplace<T>::value>::type* = nullptr>
+        void read_map_value(ParserT &parser, T *container, typename T::key_type &&key)
+        {
+            auto value = read_json<typename T::value_type::second_type>(parser);
+            if (!parser_failed(parser)) container->emplace(std::move(key), std::move(value));
+        }
+    }
+
+    /**Read into a container that has push_back.
+     * If the container has max_size, such as FixedVector, then more elements than that fail with
+     * ParseErrorCode::CAPACITY_EXCEEDED rather than being added.
+     */
+    template<typename ParserT, typename T> if_parser<ParserT> read_json_array(ParserT &parser, T *container)
+    {
+        detail::DepthScope<ParserT> depth(parser);
+        if (!depth) return;
         auto tok = parser.next();
-        if (tok.type != Token::ARR_START) throw ParseError("Expected array");
+        if (tok.type != Token::ARR_START) return parser.fail(ParseErrorCode::EXPECTED_ARRAY);
         if (parser.try_next_arr_end()) return;
 
         do
         {
-            typename T::value_type value;
-            read_json(parser, &value);
-            container->push_back(std::move(value));
+            if (detail::is_full(*container, 0)) return parser.fail(ParseErrorCode::CAPACITY_EXCEEDED);
+            detail::read_array_element(parser, container);
 
             tok = parser.next();
         }
         while (tok.type == Token::ELEMENT_SEP);
-        if (tok.type != Token::ARR_END) throw ParseError("Expected array end");
+        if (tok.type != Token::ARR_END) parser.fail(ParseErrorCode::EXPECTED_ARRAY_END);
     }
 
-    /**Read into a container that has emplace_back(str, val)*/
-    template<typename T> void read_json_map(Parser &parser, T *container)
+    namespace detail
     {
+        /**Numbers, and fixed size tuples of them, which a Parser reads with next_number_array.*/
+        template<typename T> struct is_number_element
+            : public std::integral_constant<bool, std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>
+        {};
+        template<typename T, size_t N> struct is_number_element<std::array<T, N>> : public is_number_element<T> {};
+
+        template<typename ParserT, typename T> void read_number_array(ParserT &parser, T *container)
+        {
+            read_json_array(parser, container);
+        }
+        template<typename Stats, typename T> void read_number_array(BasicParser<Stats> &parser, T *container)
+        {
+            parser.next_number_array(container);
+        }
+    }
+    /**Read a vector of numbers, or of std::array tuples of numbers such as coordinates.*/
+    template<typename ParserT, typename T, typename Alloc,
+        typename std::enable_if<detail::is_number_element<T>::value>::type* = nullptr>
+    if_parser<ParserT> read_json(ParserT &parser, std::vector<T, Alloc> *vec)
+    {
+        detail::read_number_array(parser, vec);
+    }
+
+    /**Read into a container that has emplace(key, val)*/
+    template<typename ParserT, typename T> if_parser<ParserT> read_json_map(ParserT &parser, T *container)
+    {
+        detail::DepthScope<ParserT> depth(parser);
+        if (!depth) return;
         auto tok = parser.next();
-        if (tok.type != Token::OBJ_START) throw ParseError("Expected object");
+        if (tok.type != Token::OBJ_START) return parser.fail(ParseErrorCode::EXPECTED_OBJECT);
         if (parser.try_next_obj_end()) return;
 
         do
         {
-            auto key = read_json<std::string>(parser);
+            auto key = read_json<typename T::key_type>(parser);
             tok = parser.next();
-            if (tok.type != Token::KEY_SEP) throw ParseError("Expected ':' object key-value seperator");
+            if (tok.type != Token::KEY_SEP) return parser.fail(ParseErrorCode::EXPECTED_KEY_SEP);
 
-            typename T::value_type::second_type value;
-            read_json(parser, &value);
-            container->emplace(std::move(key), std::move(value));
+            detail::read_map_value(parser, container, std::move(key));
 
             tok = parser.next();
         } while (tok.type == Token::ELEMENT_SEP);
-        if (tok.type != Token::OBJ_END) throw ParseError("Expected object end");
+        if (tok.type != Token::OBJ_END) parser.fail(ParseErrorCode::EXPECTED_OBJECT_END);
     }
 
-    template<typename T, typename std::enable_if<detail::has_push_back<T>::value>::type* = nullptr>
-    void read_json(Parser &parser, T *arr_container)
+    template<typename ParserT, typename T,
+        typename std::enable_if<detail::has_push_back<T>::value>::type* = nullptr>
+    if_parser<ParserT> read_json(ParserT &parser, T *arr_container)
     {
         read_json_array(parser, arr_container);
     }
-    template<typename T, typename std::enable_if<detail::has_kv_emplace<T>::value>::type* = nullptr>
-    void read_json(Parser &parser, T *map_container)
+    template<typename ParserT, typename T,
+        typename std::enable_if<detail::has_kv_emplace<T>::value>::type* = nullptr>
+    if_parser<ParserT> read_json(ParserT &parser, T *map_container)
     {
         read_json_map(parser, map_container);
     }
+    /**Read an array of exactly N elements. More fail with ParseErrorCode::CAPACITY_EXCEEDED,
+     * and fewer with ParseErrorCode::EXPECTED_VALUE.
+     */
+    template<typename ParserT, typename T, size_t N>
+    if_parser<ParserT> read_json(ParserT &parser, std::array<T, N> *arr)
+    {
+        detail::DepthScope<ParserT> depth(parser);
+        if (!depth) return;
+        auto tok = parser.next();
+        if (tok.type != Token::ARR_START) return parser.fail(ParseErrorCode::EXPECTED_ARRAY);
+        size_t i = 0;
+        if (!parser.try_next_arr_end())
+        {
+            do
+            {
+                if (i == N) return parser.fail(ParseErrorCode::CAPACITY_EXCEEDED);
+                read_json(parser, &(*arr)[i++]);
+
+                tok = parser.next();
+            }
+            while (tok.type == Token::ELEMENT_SEP);
+            if (tok.type != Token::ARR_END) return parser.fail(ParseErrorCode::EXPECTED_ARRAY_END);
+        }
+        if (i != N) parser.fail(ParseErrorCode::EXPECTED_VALUE);
+    }
     /**Read a time_t from a string.
      * This is not a read_json overload because time_t is a typedef for one of the int types.
      */
-    inline void read_json_time(Parser &parser, time_t *t)
+    template<typename ParserT> if_parser<ParserT> read_json_time(ParserT &parser, time_t *t)
     {
-        auto str = read_json<std::string>(parser);
-        *t = parse_iso_time(str);
+        *t = parser.next_time();
+    }
+    /**Read a system_clock time point from a string, see parse_iso_time_point.*/
+    template<typename ParserT, typename Duration>
+    if_parser<ParserT> read_json(ParserT &parser, std::chrono::time_point<std::chrono::system_clock, Duration> *t)
+    {
+        *t = parser.template next_time_point<Duration>();
     }
 
-    /**Skip past the next value. Works for objects and arrays. */
-    inline void skip_value(Parser &parser)
+    namespace detail
     {
-        size_t depth = 0;
-        do
+        /**Read tokens until the value that starts with tok, which has already been read, is
+         * complete. Open containers are tracked on a LevelStack, so mismatched ends are rejected
+         * and nesting is limited by parser.max_depth() rather than the call stack.
+         */
+        template<typename ParserT> void skip_tokens(ParserT &parser, Token tok)
         {
-            auto tok = parser.next();
-            //this is less than ideal as allows for some invalid JSON
-            //but as not tracking if currently in an array or object, this switch
-            //cant tell the legality of various tokens
-            switch (tok.type)
+            LevelStack open; // true for objects
+            while (true)
             {
-            case Token::ARR_START:
-            case Token::OBJ_START:
-                ++depth;
-                break;
-            case Token::ARR_END:
-            case Token::OBJ_END:
-                if (depth == 0) throw ParseError("Expected object or array end");
-                --depth;
-                break;
-            case Token::ELEMENT_SEP:
-            case Token::KEY_SEP:
-                break;
-            case Token::TRUE_VAL:
-            case Token::FALSE_VAL:
-            case Token::NULL_VAL:
-            case Token::STRING:
-            case Token::INTEGER:
-            case Token::NUMBER:
-                break;
-            default: throw ParseError("Expected value");
+                switch (tok.type)
+                {
+                case Token::ARR_START:
+                case Token::OBJ_START:
+                {
+                    bool obj = tok.type == Token::OBJ_START;
+                    if (open.size() >= parser.max_depth()) return parser.fail(ParseErrorCode::DEPTH_EXCEEDED);
+                    if (obj ? parser.try_next_obj_end() : parser.try_next_arr_end()) break;
+                    open.push(obj);
+                    if (obj)
+                    {
+                        parser.skip_next_str();
+                        parser.next_key_sep();
+                    }
+                    tok = parser.next();
+                    continue;
+                }
+                case Token::TRUE_VAL:
+                case Token::FALSE_VAL:
+                case Token::NULL_VAL:
+                case Token::STRING:
+                case Token::INTEGER:
+                case Token::NUMBER:
+                case Token::RAW_NUMBER:
+                    break;
+                default: return parser.fail(ParseErrorCode::EXPECTED_VALUE);
+                }
+                while (true)
+                {
+                    if (open.empty()) return;
+                    tok = parser.next();
+                    if (tok.type == Token::ELEMENT_SEP) break;
+                    if (open.pop())
+                    {
+                        if (tok.type != Token::OBJ_END) return parser.fail(ParseErrorCode::EXPECTED_OBJECT_END);
+                    }
+                    else if (tok.type != Token::ARR_END) return parser.fail(ParseErrorCode::EXPECTED_ARRAY_END);
+                }
+                if (open.top())
+                {
+                    parser.skip_next_str();
+                    parser.next_key_sep();
+                }
+                tok = parser.next();
             }
         }
-        while (depth > 0);
+    }
+    /**Skip past the next value. Works for objects and arrays. */
+    template<typename ParserT> if_parser<ParserT> skip_value(ParserT &parser)
+    {
+        detail::RawNumberScope<ParserT> raw_numbers(parser);
+        detail::skip_tokens(parser, parser.next());
     }
 
 
     namespace detail
     {
-        template<typename T>
+        template<typename T, typename ParserT>
         struct Field
         {
-            typedef void(*ReadField)(Parser &parser, T *obj);
+            typedef void(*ReadField)(ParserT &parser, T *obj);
             ReadField read;
             size_t index;
         };
-        template<typename T>
-        using Fields = std::unordered_map<std::string, Field<T>>;
+        /**Field names, and the read function for each name's index.*/
+        template<typename T, typename ParserT>
+        struct Fields
+        {
+            KeyTable keys;
+            std::vector<typename Field<T, ParserT>::ReadField> reads;
+
+            size_t size()const { return keys.size(); }
+        };
     }
 
     struct ErrorUnknown
     {
-        void operator()(Parser &parser, const std::string &key)
+        template<typename ParserT>
+        void operator()(ParserT &parser, const std::string &key)
         {
-            throw ParseError("Unknown key " + key);
+            parser.fail(ParseErrorCode::UNKNOWN_KEY, key);
         }
     };
     struct IgnoreUnknown
     {
-        void operator()(Parser &parser, const std::string &key)
+        template<typename ParserT>
+        void operator()(ParserT &parser, const std::string &)
         {
+            typename ParserT::StatsType::Timer timer(parser.stats(), StatsCategory::UNKNOWN_KEY);
             skip_value(parser);
         }
     };
 
-    template<typename T, typename ErrorPolicy = ErrorUnknown, size_t N = 0>
+    /**Reads objects with a fixed set of keys into a type T.
+     * ParserT may be an instrumented BasicParser, in which case all read functions used must
+     * accept that type.
+     */
+    template<typename T, typename ErrorPolicy = ErrorUnknown, typename ParserT = Parser, size_t N = 0>
     class ObjectFieldReader
     {
     public:
-        typedef detail::Field<T> Field;
+        typedef detail::Field<T, ParserT> Field;
         typedef typename Field::ReadField ReadField;
-        typedef detail::Fields<T> Fields;
+        typedef detail::Fields<T, ParserT> Fields;
+        typedef ObjectFieldReader<T, ErrorPolicy, ParserT, N + 1> Next;
 
         ObjectFieldReader() : fields()
         {
             assert(N == 0);
         }
-        explicit ObjectFieldReader(detail::Fields<T> &&fields) : fields(std::move(fields))
+        explicit ObjectFieldReader(Fields &&fields) : fields(std::move(fields))
         {
             assert(N == this->fields.size());
         }
@@ -279,73 +655,71 @@ namespace json
          * @endcode
          */
         template<typename U, U T::*ptr>
-        ObjectFieldReader<T, ErrorPolicy, N + 1> add(const std::string &name)
+        Next add(const std::string &name)
         {
             return add(name, do_read_field<U, ptr>);
         }
 
-        /**Adds a property with a specified "void (Parser &parser, U *obj)" function
+        /**Adds a property with a specified "void (ParserT &parser, U *obj)" function
          * to convert the value.
          * e.g: @code
          * static auto const reader = ObjectFieldReader<MyType>().
          *      add<time_t, &MyType::time, read_json_time>("time");
          * @endcode
          */
-        template<typename U, U T::*ptr, void(*read_func)(Parser &parser, U *out)>
-        ObjectFieldReader<T, ErrorPolicy, N + 1> add(const std::string &name)
+        template<typename U, U T::*ptr, void(*read_func)(ParserT &parser, U *out)>
+        Next add(const std::string &name)
         {
             return add(name, do_read_field<U, ptr, read_func>);
         }
-        /**Adds a property with a specified "void (Parser &parser, T *obj)" read function.*/
-        ObjectFieldReader<T, ErrorPolicy, N + 1> add(const std::string &name, ReadField read)
+        /**Adds a property with a specified "void (ParserT &parser, T *obj)" read function.*/
+        Next add(const std::string &name, ReadField read)
         {
-            auto index = fields.size();
-            fields[name] = { read, index };
-            return ObjectFieldReader<T, ErrorPolicy, N + 1>(std::move(fields));
+            fields.keys.add(name);
+            fields.reads.push_back(read);
+            return Next(std::move(fields));
         }
 
         /**Read an object with the specified fields into out.*/
-        void read(Parser &parser, T *out)const
+        void read(ParserT &parser, T *out)const
         {
+            detail::DepthScope<ParserT> depth(parser);
+            if (!depth) return;
             bool visited[N] = { 0 };
             size_t count = 0;
             parser.next_obj_start();
-            if (parser.try_next_obj_end()) throw ParseError("Missing keys, unexpected empty object");
-            std::string key;
+            if (parser.try_next_obj_end()) return parser.fail(ParseErrorCode::MISSING_KEYS);
+            std::string key; // only set for unknown keys
             do
             {
-                //key
-                key.clear();
-                parser.next_str(&key);
-                //find field
-                auto field = fields.find(key);
-                //':' seperator
-                parser.next_key_sep();
+                //key and ':' seperator, matched without decoding where possible
+                auto index = parser.next_key(fields.keys, &key);
                 //read field
-                if (field != fields.end())
+                if (index != KeyTable::npos)
                 {
-                    if (visited[field->second.index]) throw ParseError("Duplicate key " + key);
-                    field->second.read(parser, out);
-                    visited[field->second.index] = true;
+                    if (visited[index]) return parser.fail(ParseErrorCode::DUPLICATE_KEY, fields.keys[index]);
+                    fields.reads[index](parser, out);
+                    visited[index] = true;
                     ++count;
                 }
-                else ErrorPolicy()(parser, key);
+                else
+                {
+                    parser.stats().unknown_key();
+                    ErrorPolicy()(parser, key);
+                }
             }
             while (parser.next_obj_el());
-            if (count != N)
-            {
-                throw ParseError("Missing keys");
-            }
+            if (count != N) parser.fail(ParseErrorCode::MISSING_KEYS);
         }
     private:
         template <typename U, U T::*ptr>
-        static void do_read_field(Parser &parser, T *obj)
+        static void do_read_field(ParserT &parser, T *obj)
         {
             U *field = &(obj->*ptr);
             read_json(parser, field);
         }
-        template <typename U, U T::*ptr, void(*read_func)(Parser &parser, U *out)>
-        static void do_read_field(Parser &parser, T *obj)
+        template <typename U, U T::*ptr, void(*read_func)(ParserT &parser, U *out)>
+        static void do_read_field(ParserT &parser, T *obj)
         {
             U *field = &(obj->*ptr);
             read_func(parser, field);
@@ -0,0 +1,33 @@
+#pragma once
+/**@file Compiler and instruction set detection for the vectorised code paths.
+ * JSON_HAS_SSE2 is defined when SSE2 intrinsics may be used, which is always the case for x86-64.
+ * Other platforms use the scalar implementations.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JSON_HAS_SSE2 1
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+namespace json
+{
+    namespace detail
+    {
+        /**Index of the lowest set bit, x must not be 0.*/
+        inline unsigned count_trailing_zeros(unsigned x)
+        {
+#if defined(__GNUC__)
+            return (unsigned)__builtin_ctz(x);
+#elif defined(_MSC_VER)
+            unsigned long i;
+            _BitScanForward(&i, x);
+            return (unsigned)i;
+#else
+            unsigned n = 0;
+            while (!(x & 1)) x >>= 1, ++n;
+            return n;
+#endif
+        }
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+namespace json
+{
+    /**Categories that time is recorded for by TimedStats.*/
+    enum class StatsCategory
+    {
+        /**Reading or writing strings, including object keys.*/
+        STRING,
+        /**Reading or writing numbers.*/
+        NUMBER,
+        /**Skipping the values of unknown object keys.*/
+        UNKNOWN_KEY,
+
+        COUNT
+    };
+
+    /**Counters collected by CountStats and TimedStats.
+     * Plain data, so may be summed over many parsers or writers, and exported as metrics.
+     */
+    struct StatsData
+    {
+        /**Input bytes consumed by a parser, or output bytes by a writer.*/
+        uint64_t bytes = 0;
+        /**Tokens read, or values, keys and array/object starts written.*/
+        uint64_t tokens = 0;
+        uint64_t strings = 0;
+        /**Strings that contained escape sequences.*/
+        uint64_t escaped_strings = 0;
+        uint64_t integers = 0;
+        /**Non-integer numbers, which use the slower floating point conversions.*/
+        uint64_t floats = 0;
+        /**Object keys skipped by ObjectFieldReader.*/
+        uint64_t unknown_keys = 0;
+        /**Times a string or buffer grew its capacity.*/
+        uint64_t allocations = 0;
+        /**Time spent in each StatsCategory. Only recorded by TimedStats.*/
+        std::chrono::nanoseconds time[(size_t)StatsCategory::COUNT] = {};
+
+        std::chrono::nanoseconds category_time(StatsCategory category)const
+        {
+            return time[(size_t)category];
+        }
+
+        StatsData &operator += (const StatsData &rhs)
+        {
+            bytes += rhs.bytes;
+            tokens += rhs.tokens;
+            strings += rhs.strings;
+            escaped_strings += rhs.escaped_strings;
+            integers += rhs.integers;
+            floats += rhs.floats;
+            unknown_keys += rhs.unknown_keys;
+            allocations += rhs.allocations;
+            for (size_t i = 0; i < (size_t)StatsCategory::COUNT; ++i) time[i] += rhs.time[i];
+            return *this;
+        }
+    };
+
+    /**Default instrumentation policy for BasicParser and BasicWriter. Records nothing, and every
+     * call compiles away.
+     *
+     * A policy provides the member functions below, and a Timer type constructed with the policy
+     * and a StatsCategory that records the time until it is destroyed.
+     */
+    struct NoStats
+    {
+        static constexpr bool enabled = false;
+
+        struct Timer
+        {
+            Timer(NoStats&, StatsCategory) {}
+        };
+
+        void bytes(size_t) {}
+        void token() {}
+        void string(bool escaped) { (void)escaped; }
+        void number(bool is_float) { (void)is_float; }
+        void unknown_key() {}
+        void allocation() {}
+    };
+
+    /**Instrumentation policy that counts events into a StatsData owned by the caller.
+     * Not thread safe, use a StatsData per thread and add them together for reporting.
+     */
+    class CountStats
+    {
+    public:
+        static constexpr bool enabled = true;
+
+        struct Timer
+        {
+            Timer(CountStats&, StatsCategory) {}
+        };
+
+        explicit CountStats(StatsData *data) : data(data) {}
+
+        StatsData &get()const { return *data; }
+
+        void bytes(size_t n) { data->bytes += n; }
+        void token() { ++data->tokens; }
+        void string(bool escaped)
+        {
+            ++data->strings;
+            if (escaped) ++data->escaped_strings;
+        }
+        void number(bool is_float)
+        {
+            if (is_float) ++data->floats;
+            else ++data->integers;
+        }
+        void unknown_key() { ++data->unknown_keys; }
+        void allocation() { ++data->allocations; }
+    protected:
+        StatsData *data;
+    };
+
+    /**CountStats, and also record the time spent in each StatsCategory.
+     * This adds two clock reads to every string and number, so has a significant cost.
+     */
+    class TimedStats : public CountStats
+    {
+    public:
+        class Timer
+        {
+        public:
+            Timer(TimedStats &stats, StatsCategory category)
+                : out(&stats.data->time[(size_t)category]), start(clock::now())
+            {}
+            ~Timer()
+            {
+                *out += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+            }
+            Timer(const Timer&) = delete;
+            Timer& operator = (const Timer&) = delete;
+        private:
+            typedef std::chrono::steady_clock clock;
+            std::chrono::nanoseconds *out;
+            clock::time_point start;
+        };
+
+        explicit TimedStats(StatsData *data) : CountStats(data) {}
+    };
+}
@@ -1,84 +1,268 @@
 #pragma once
+#include <chrono>
+#include <cstddef>
 #include <ctime>
 #include <string>
 #include <stdexcept>
 
 namespace json
 {
-    namespace
+    namespace detail
     {
-        int parse_time_num(char c, const std::string &time_str)
+        /**Days since 1970-01-01 of a proleptic Gregorian calendar date.
+         * See http://howardhinnant.github.io/date_algorithms.html
+         */
+        inline long long days_from_civil(int y, unsigned m, unsigned d)
         {
-            if (c >= '0' && c <= '9') return c - '0';
-            else throw std::runtime_error("Invalid time " + time_str);
+            y -= m <= 2;
+            const int era = (y >= 0 ? y : y - 399) / 400;
+            const unsigned yoe = (unsigned)(y - era * 400);
+            const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+            const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+            return (long long)era * 146097 + (long long)doe - 719468;
         }
-        template<size_t len>
-        int parse_time_num(const char *str, const std::string &time_str)
+        /**Inverse of days_from_civil.*/
+        inline void civil_from_days(long long z, int *y, unsigned *m, unsigned *d)
         {
-            int sum = 0;
-            for (size_t i = 0; i < len; ++i)
+            z += 719468;
+            const long long era = (z >= 0 ? z : z - 146096) / 146097;
+            const unsigned doe = (unsigned)(z - era * 146097);
+            const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            const unsigned mp = (5 * doy + 2) / 153;
+            *d = doy - (153 * mp + 2) / 5 + 1;
+            *m = mp < 10 ? mp + 3 : mp - 9;
+            *y = (int)((long long)yoe + era * 400 + (*m <= 2));
+        }
+        inline unsigned days_in_month(int y, unsigned m)
+        {
+            static const unsigned char days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+            if (m == 2 && y % 4 == 0 && (y % 100 != 0 || y % 400 == 0)) return 29;
+            return days[m - 1];
+        }
+
+        /**Parse exactly N decimal digits.*/
+        template<size_t N>
+        bool parse_time_digits(const char *str, unsigned *out)
+        {
+            unsigned x = 0;
+            for (size_t i = 0; i < N; ++i)
+            {
+                unsigned digit = (unsigned)(str[i] - '0');
+                if (digit > 9) return false;
+                x = x * 10 + digit;
+            }
+            *out = x;
+            return true;
+        }
+        /**Write x as exactly n decimal digits.*/
+        inline void format_time_digits(unsigned x, unsigned n, char *out)
+        {
+            for (unsigned i = n; i > 0; --i)
             {
-                sum *= 10;
-                sum += parse_time_num(str[i], time_str);
+                out[i - 1] = (char)('0' + x % 10);
+                x /= 10;
             }
-            return sum;
+        }
+
+        /**True if secs seconds since the epoch, plus up to a second of nanos, can be held by a
+         * system_clock time point of Duration without overflow.
+         */
+        template<typename Duration>
+        bool time_point_in_range(long long secs)
+        {
+            if (std::chrono::treat_as_floating_point<typename Duration::rep>::value) return true;
+            auto max = std::chrono::duration_cast<std::chrono::seconds>(Duration::max()).count();
+            auto min = std::chrono::duration_cast<std::chrono::seconds>(Duration::min()).count();
+            return secs >= min && secs < max;
+        }
+        /**Time point from try_parse_iso_time output, truncating to the precision of Duration.*/
+        template<typename Duration>
+        std::chrono::time_point<std::chrono::system_clock, Duration> make_time_point(long long secs, unsigned nanos)
+        {
+            return std::chrono::time_point<std::chrono::system_clock, Duration>(
+                std::chrono::duration_cast<Duration>(std::chrono::seconds(secs)) +
+                std::chrono::duration_cast<Duration>(std::chrono::nanoseconds(nanos)));
+        }
+
+        /**Number of fractional second digits needed for Duration, 0, 3, 6 or 9.*/
+        template<typename Duration>
+        constexpr unsigned time_fraction_digits()
+        {
+            typedef typename Duration::period period;
+            return period::num >= period::den ? 0 :
+                period::den / period::num <= 1000 ? 3 :
+                period::den / period::num <= 1000000 ? 6 : 9;
         }
     }
-    /**Parse time. Currently supports only UTC 'YYYY-MM-DDTHH:MM:SS' with optional trailing Z.*/
-    inline time_t parse_iso_time(const std::string &str)
+
+    /**Maximum length of a time written by format_iso_time.*/
+    static const size_t ISO_TIME_MAX_LEN = sizeof("YYYY-MM-DDTHH:MM:SS.nnnnnnnnnZ") - 1;
+
+    /**Parse an ISO 8601 / RFC 3339 time without any allocation or use of the C time functions.
+     *
+     * Supports 'YYYY-MM-DDTHH:MM:SS', optional fractional seconds of any length (only the first
+     * 9 digits are used), then either nothing or 'Z' for UTC, or a '+HH:MM' or '-HH:MM' offset.
+     * Years must be between 1900 and 3000.
+     *
+     * On success sets secs to seconds since the Unix epoch in UTC and nanos to the fraction of a
+     * second, and returns true.
+     */
+    inline bool try_parse_iso_time(const char *str, size_t len, long long *secs, unsigned *nanos)
     {
-        auto strp = str.c_str();
-        auto len = str.size();
-        if (len < sizeof("YYYY-MM-DDTHH:MM:SS") - 1) throw std::runtime_error("Invalid time " + str);
-        if (len > sizeof("YYYY-MM-DDTHH:MM:SSZ") - 1) throw std::runtime_error("Invalid time " + str);
-        //validate static components
-        if (len == sizeof("YYYY-MM-DDTHH:MM:SSZ") - 1 && str[19] != 'Z') throw std::runtime_error("Invalid time " + str);
-        if (strp[4] != '-' || strp[7] != '-' || strp[10] != 'T' || strp[13] != ':' || strp[16] != ':')
-            throw std::runtime_error("Invalid time " + str);
-        //parse numbers
-        tm tm;
+        if (len < sizeof("YYYY-MM-DDTHH:MM:SS") - 1) return false;
+        if (str[4] != '-' || str[7] != '-' || str[10] != 'T' || str[13] != ':' || str[16] != ':') return false;
+        unsigned year, month, day, hour, min, sec;
+        if (!detail::parse_time_digits<4>(str + 0, &year) ||
+            !detail::parse_time_digits<2>(str + 5, &month) ||
+            !detail::parse_time_digits<2>(str + 8, &day) ||
+            !detail::parse_time_digits<2>(str + 11, &hour) ||
+            !detail::parse_time_digits<2>(str + 14, &min) ||
+            !detail::parse_time_digits<2>(str + 17, &sec))
+        {
+            return false;
+        }
+        if (year < 1900 || year > 3000 ||
+            month < 1 || month > 12 ||
+            day < 1 || day > detail::days_in_month((int)year, month) ||
+            hour > 23 || min > 59 || sec > 60)
+        {
+            return false;
+        }
 
-        tm.tm_year = parse_time_num<4>(strp + 0, str);
-        tm.tm_mon = parse_time_num<2>(strp + 5, str);
-        tm.tm_mday = parse_time_num<2>(strp + 8, str);
+        auto p = str + 19, end = str + len;
+        unsigned frac = 0;
+        if (p < end && *p == '.')
+        {
+            ++p;
+            auto digits_start = p;
+            unsigned scale = 1000000000;
+            for (; p < end && *p >= '0' && *p <= '9'; ++p)
+            {
+                if (scale > 1)
+                {
+                    scale /= 10;
+                    frac += (unsigned)(*p - '0') * scale;
+                }
+            }
+            if (p == digits_start) return false;
+        }
 
-        tm.tm_hour = parse_time_num<2>(strp + 11, str);
-        tm.tm_min = parse_time_num<2>(strp + 14, str);
-        tm.tm_sec = parse_time_num<2>(strp + 17, str);
-        //adjust for tm
-        tm.tm_year -= 1900;
-        tm.tm_mon -= 1;
-        tm.tm_isdst = 0;
-        //validate
-        if (tm.tm_year < 0 || tm.tm_year > 1100 ||
-            tm.tm_mon < 0 || tm.tm_mon > 11 ||
-            tm.tm_mday < 1 || tm.tm_mday > 31 ||
-            tm.tm_hour < 0 || tm.tm_hour > 23 ||
-            tm.tm_min < 0 || tm.tm_min > 59 ||
-            tm.tm_sec < 0 || tm.tm_sec > 60)
+        long long offset = 0;
+        if (p < end && *p == 'Z') ++p;
+        else if (p < end && (*p == '+' || *p == '-'))
         {
-            throw std::runtime_error("Invalid time " + str);
+            unsigned off_hour, off_min;
+            if (end - p != 6 || p[3] != ':' ||
+                !detail::parse_time_digits<2>(p + 1, &off_hour) ||
+                !detail::parse_time_digits<2>(p + 4, &off_min) ||
+                off_hour > 23 || off_min > 59)
+            {
+                return false;
+            }
+            offset = (long long)(off_hour * 3600 + off_min * 60);
+            if (*p == '-') offset = -offset;
+            p += 6;
         }
-        //convert to time_t
-#ifdef _MSC_VER
-        return _mkgmtime(&tm);
-#else
-        return timegm(&tm);
-#endif
+        if (p != end) return false;
+
+        *secs = detail::days_from_civil((int)year, month, day) * 86400 +
+            (long long)(hour * 3600 + min * 60 + sec) - offset;
+        *nanos = frac;
+        return true;
+    }
+
+    /**Write a UTC time as 'YYYY-MM-DDTHH:MM:SS[.fff]Z' to out, which must have space for
+     * ISO_TIME_MAX_LEN chars. fraction_digits is the number of fractional second digits to
+     * write, between 0 and 9. Returns the number of chars written.
+     */
+    inline size_t format_iso_time(long long secs, unsigned nanos, unsigned fraction_digits, char *out)
+    {
+        long long days = secs / 86400;
+        long long day_secs = secs % 86400;
+        if (day_secs < 0)
+        {
+            day_secs += 86400;
+            --days;
+        }
+        int year;
+        unsigned month, day;
+        detail::civil_from_days(days, &year, &month, &day);
+        if (year < 0 || year > 9999) throw std::runtime_error("Time out of range for ISO 8601");
+
+        detail::format_time_digits((unsigned)year, 4, out + 0);
+        out[4] = '-';
+        detail::format_time_digits(month, 2, out + 5);
+        out[7] = '-';
+        detail::format_time_digits(day, 2, out + 8);
+        out[10] = 'T';
+        detail::format_time_digits((unsigned)(day_secs / 3600), 2, out + 11);
+        out[13] = ':';
+        detail::format_time_digits((unsigned)(day_secs / 60 % 60), 2, out + 14);
+        out[16] = ':';
+        detail::format_time_digits((unsigned)(day_secs % 60), 2, out + 17);
+        size_t len = 19;
+        if (fraction_digits)
+        {
+            if (fraction_digits > 9) fraction_digits = 9;
+            unsigned frac = nanos;
+            for (unsigned i = fraction_digits; i < 9; ++i) frac /= 10;
+            out[len++] = '.';
+            detail::format_time_digits(frac, fraction_digits, out + len);
+            len += fraction_digits;
+        }
+        out[len++] = 'Z';
+        return len;
+    }
+
+    /**Write a system_clock time point to out, in the format used by time_to_iso_str.*/
+    template<typename Duration>
+    size_t format_iso_time(const std::chrono::time_point<std::chrono::system_clock, Duration> &t, char *out)
+    {
+        auto since_epoch = t.time_since_epoch();
+        auto secs = std::chrono::floor<std::chrono::seconds>(since_epoch);
+        auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - secs);
+        return format_iso_time((long long)secs.count(), (unsigned)nanos.count(),
+            detail::time_fraction_digits<Duration>(), out);
     }
+
+    /**Parse time, see try_parse_iso_time. Any fractional seconds are discarded.*/
+    inline time_t parse_iso_time(const std::string &str)
+    {
+        long long secs;
+        unsigned nanos;
+        if (!try_parse_iso_time(str.data(), str.size(), &secs, &nanos)) throw std::runtime_error("Invalid time " + str);
+        return (time_t)secs;
+    }
+    /**Parse time into a system_clock time point, see try_parse_iso_time.
+     * Fractional seconds are truncated to the precision of Duration. Times that Duration cannot
+     * hold, such as years after 2262 with nanoseconds, are an error.
+     */
+    template<typename Duration = std::chrono::system_clock::duration>
+    std::chrono::time_point<std::chrono::system_clock, Duration> parse_iso_time_point(const std::string &str)
+    {
+        long long secs;
+        unsigned nanos;
+        if (!try_parse_iso_time(str.data(), str.size(), &secs, &nanos)) throw std::runtime_error("Invalid time " + str);
+        if (!detail::time_point_in_range<Duration>(secs)) throw std::runtime_error("Time out of range " + str);
+        return detail::make_time_point<Duration>(secs, nanos);
+    }
+
     /**Serialise UTC time to string in 'YYYY-MM-DDTHH:MM:SSZ' format.*/
     inline std::string time_to_iso_str(time_t t)
     {
-        tm tm;
-#ifdef _MSC_VER
-        gmtime_s(&tm, &t);
-#else
-        gmtime_r(&t, &tm);
-#endif
-        char buffer[sizeof("YYYY-MM-DDTHH:MM:SSZ")];
-        auto len = strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &tm);
-        if (!len) throw std::runtime_error("stftime for json::time_to_iso_str failed");
-
+        char buffer[ISO_TIME_MAX_LEN];
+        auto len = format_iso_time((long long)t, 0, 0, buffer);
+        return{ buffer, len };
+    }
+    /**Serialise a system_clock time point to string in 'YYYY-MM-DDTHH:MM:SS.fffZ' format,
+     * with as many fractional second digits (0, 3, 6 or 9) as needed for Duration.
+     */
+    template<typename Duration>
+    std::string time_to_iso_str(const std::chrono::time_point<std::chrono::system_clock, Duration> &t)
+    {
+        char buffer[ISO_TIME_MAX_LEN];
+        auto len = format_iso_time(t, buffer);
         return{ buffer, len };
     }
 }
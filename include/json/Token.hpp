@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include "Number.hpp"
 namespace json
 {
     /**A token read by json::Parser.*/
@@ -32,7 +33,9 @@ namespace json
             /**Boolean false value.*/
             FALSE_VAL,
             /**Nul value.*/
-            NULL_VAL
+            NULL_VAL,
+            /**Unconverted number stored in val_raw, only if BasicParser::raw_numbers is enabled.*/
+            RAW_NUMBER
         };
 
         Type type;
@@ -41,6 +44,7 @@ namespace json
         {
             long long val_int;
             double val_num;
+            RawNumber val_raw;
         };
 
         Token() : type(END), str() {}
@@ -48,5 +52,6 @@ namespace json
         Token(std::string &&str) : type(STRING), str(std::move(str)) {}
         Token(long long x) : type(INTEGER), val_int(x) {}
         Token(double x) : type(NUMBER), val_num(x) {}
+        Token(const RawNumber &x) : type(RAW_NUMBER), val_raw(x) {}
     };
 }
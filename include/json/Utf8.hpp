@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include "Simd.hpp"
+namespace json
+{
+    namespace detail
+    {
+        inline bool is_utf8_continuation(unsigned char c)
+        {
+            return (c & 0xC0) == 0x80;
+        }
+    }
+
+    /**Find the first byte in [begin, end) that is not part of a valid UTF-8 sequence.
+     * Returns end if all the input is valid.
+     *
+     * Follows RFC 3629, so overlong encodings, encoded UTF-16 surrogates (U+D800 to U+DFFF) and
+     * code points above U+10FFFF are invalid. Runs of ASCII are checked 16 bytes at a time.
+     */
+    inline const char *find_invalid_utf8(const char *begin, const char *end)
+    {
+        auto p = (const unsigned char*)begin;
+        auto e = (const unsigned char*)end;
+        while (p < e)
+        {
+#ifdef JSON_HAS_SSE2
+            if (e - p >= 16)
+            {
+                int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)p));
+                if (!mask)
+                {
+                    p += 16;
+                    continue;
+                }
+                // skip to the first non-ASCII byte
+                while (*p < 0x80) ++p;
+            }
+#endif
+            unsigned char c = *p;
+            if (c < 0x80)
+            {
+                ++p;
+                continue;
+            }
+            size_t len;
+            // valid range of the second byte, which excludes overlong and surrogate encodings
+            unsigned char lo = 0x80, hi = 0xBF;
+            if (c >= 0xC2 && c <= 0xDF) len = 2;
+            else if (c >= 0xE0 && c <= 0xEF)
+            {
+                len = 3;
+                if (c == 0xE0) lo = 0xA0;
+                else if (c == 0xED) hi = 0x9F;
+            }
+            else if (c >= 0xF0 && c <= 0xF4)
+            {
+                len = 4;
+                if (c == 0xF0) lo = 0x90;
+                else if (c == 0xF4) hi = 0x8F;
+            }
+            else return (const char*)p;
+
+            if ((size_t)(e - p) < len) return (const char*)p;
+            if (p[1] < lo || p[1] > hi) return (const char*)p;
+            for (size_t i = 2; i < len; ++i)
+            {
+                if (!detail::is_utf8_continuation(p[i])) return (const char*)p;
+            }
+            p += len;
+        }
+        return end;
+    }
+    /**True if [begin, end) is entirely valid UTF-8, see find_invalid_utf8.*/
+    inline bool is_valid_utf8(const char *begin, const char *end)
+    {
+        return find_invalid_utf8(begin, end) == end;
+    }
+}
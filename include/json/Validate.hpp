@@ -0,0 +1,279 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "Simd.hpp"
+namespace json
+{
+    namespace detail
+    {
+        /**Fixed capacity stack of bools, one bit per element.*/
+        template<size_t N>
+        class BitStack
+        {
+        public:
+            BitStack() : bits(), count(0) {}
+
+            bool empty()const { return count == 0; }
+            size_t size()const { return count; }
+            /**Returns false if already full.*/
+            bool push(bool b)
+            {
+                if (count == N) return false;
+                auto mask = (uint64_t)1 << (count % 64);
+                if (b) bits[count / 64] |= mask;
+                else bits[count / 64] &= ~mask;
+                ++count;
+                return true;
+            }
+            void pop()
+            {
+                --count;
+            }
+            bool top()const
+            {
+                return ((bits[(count - 1) / 64] >> ((count - 1) % 64)) & 1) != 0;
+            }
+        private:
+            uint64_t bits[(N + 63) / 64];
+            size_t count;
+        };
+
+        /**Validates a complete JSON document, see json::validate.*/
+        template<size_t MaxDepth>
+        class Validator
+        {
+        public:
+            Validator(const char *begin, const char *end) : p(begin), end(end), stack() {}
+
+            const char *pos()const { return p; }
+
+            bool run()
+            {
+                for (;;)
+                {
+                    //value
+                    skip_ws();
+                    if (p == end) return false;
+                    char c = *p;
+                    if (c == '{' || c == '[')
+                    {
+                        bool obj = c == '{';
+                        if (stack.size() == MaxDepth) return false; //including empty containers
+                        ++p;
+                        skip_ws();
+                        if (p < end && *p == (obj ? '}' : ']')) ++p;
+                        else
+                        {
+                            if (!stack.push(obj)) return false;
+                            if (obj && !key()) return false;
+                            continue; //first element
+                        }
+                    }
+                    else if (!scalar()) return false;
+                    //end of containers, until a ',' for the next value
+                    for (;;)
+                    {
+                        skip_ws();
+                        if (stack.empty()) return p == end;
+                        if (p == end) return false;
+                        bool obj = stack.top();
+                        if (*p == ',')
+                        {
+                            ++p;
+                            if (obj)
+                            {
+                                skip_ws();
+                                if (!key()) return false;
+                            }
+                            break;
+                        }
+                        else if (*p == (obj ? '}' : ']'))
+                        {
+                            ++p;
+                            stack.pop();
+                        }
+                        else return false;
+                    }
+                }
+            }
+        private:
+            /**true for ' ', '\t', '\n' and '\r'.*/
+            static bool is_ws(char c)
+            {
+                return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+            }
+            static bool is_digit(char c)
+            {
+                return c >= '0' && c <= '9';
+            }
+            static bool is_hex(char c)
+            {
+                return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+            }
+
+            const char *p, *end;
+            BitStack<MaxDepth> stack;
+
+            // The scanning functions below use a local copy of p, since char reads may alias
+            // this->p, which would otherwise be reloaded and stored on every character.
+
+            void skip_ws()
+            {
+                // most tokens are not preceded by whitespace
+                if (p < end && (unsigned char)*p > ' ') return;
+                auto q = p;
+                while (q < end && is_ws(*q)) ++q;
+                p = q;
+            }
+
+            /**Object key and ':'.*/
+            bool key()
+            {
+                if (p == end || *p != '"' || !string()) return false;
+                skip_ws();
+                if (p == end || *p != ':') return false;
+                ++p;
+                return true;
+            }
+
+            /**A string, number, or literal.*/
+            bool scalar()
+            {
+                switch (*p)
+                {
+                case '"': return string();
+                case 't': return literal("true", 4);
+                case 'f': return literal("false", 5);
+                case 'n': return literal("null", 4);
+                default: return number();
+                }
+            }
+
+            bool literal(const char *str, size_t len)
+            {
+                if ((size_t)(end - p) < len || memcmp(p, str, len) != 0) return false;
+                p += len;
+                return true;
+            }
+
+            static bool digits(const char *&q, const char *end)
+            {
+                if (q == end || !is_digit(*q)) return false;
+                do ++q; while (q < end && is_digit(*q));
+                return true;
+            }
+            bool number()
+            {
+                auto q = p;
+                bool valid = number(q, end);
+                p = q;
+                return valid;
+            }
+            static bool number(const char *&q, const char *end)
+            {
+                if (*q == '-') ++q;
+                if (q == end) return false;
+                if (*q == '0') ++q;
+                else if (!digits(q, end)) return false;
+                if (q < end && *q == '.')
+                {
+                    ++q;
+                    if (!digits(q, end)) return false;
+                }
+                if (q < end && (*q == 'e' || *q == 'E'))
+                {
+                    ++q;
+                    if (q < end && (*q == '+' || *q == '-')) ++q;
+                    if (!digits(q, end)) return false;
+                }
+                return true;
+            }
+
+            /**Advance p to the first '"', '\\' or control character.*/
+            void skip_plain_chars()
+            {
+                auto q = p;
+                skip_plain_chars(q, end);
+                p = q;
+            }
+            static void skip_plain_chars(const char *&p, const char *end)
+            {
+#ifdef JSON_HAS_SSE2
+                const __m128i quote = _mm_set1_epi8('"');
+                const __m128i backslash = _mm_set1_epi8('\\');
+                // control characters are <= 0x1F unsigned, which is when max(c, 0x1F) == 0x1F
+                const __m128i control = _mm_set1_epi8(0x1F);
+                while (end - p >= 16)
+                {
+                    __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+                    __m128i special = _mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                        _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+                    int mask = _mm_movemask_epi8(special);
+                    if (mask)
+                    {
+                        p += count_trailing_zeros((unsigned)mask);
+                        return;
+                    }
+                    p += 16;
+                }
+#endif
+                while (p < end && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20) ++p;
+            }
+
+            bool string()
+            {
+                ++p; // "
+                for (;;)
+                {
+                    skip_plain_chars();
+                    if (p == end) return false;
+                    if (*p == '"')
+                    {
+                        ++p;
+                        return true;
+                    }
+                    if (*p != '\\') return false; // control character
+                    ++p;
+                    if (p == end) return false;
+                    switch (*p)
+                    {
+                    case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                        ++p;
+                        break;
+                    case 'u':
+                        if (end - p < 5 || !is_hex(p[1]) || !is_hex(p[2]) || !is_hex(p[3]) || !is_hex(p[4]))
+                            return false;
+                        p += 5;
+                        break;
+                    default: return false;
+                    }
+                }
+            }
+        };
+    }
+
+    /**Check that [begin, end) is exactly one JSON value, with optional surrounding whitespace,
+     * following the full RFC 8259 grammar.
+     *
+     * This does not allocate, and is much faster than reading with Parser, so may be used to
+     * reject malformed input early. Nesting deeper than MaxDepth arrays and objects is rejected.
+     *
+     * If error_pos is not null and the input is invalid, it is set to the position the error
+     * was found.
+     */
+    template<size_t MaxDepth = 1024>
+    bool validate(const char *begin, const char *end, const char **error_pos = nullptr)
+    {
+        detail::Validator<MaxDepth> validator(begin, end);
+        if (validator.run()) return true;
+        if (error_pos) *error_pos = validator.pos();
+        return false;
+    }
+    inline bool validate(const std::string &json, const char **error_pos = nullptr)
+    {
+        return validate(json.data(), json.data() + json.size(), error_pos);
+    }
+}
@@ -1,10 +1,72 @@
 #pragma once
+#include <array>
+#include <charconv>
+#include <cstdio>
 #include <cstring>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "Base64.hpp"
+#include "InternTable.hpp"
+#include "Number.hpp"
 #include "Time.hpp"
+#include "Stats.hpp"
 namespace json
 {
+    namespace detail
+    {
+        /**Buffer size that is enough for any format_number output.*/
+        static const size_t NUMBER_MAX_LEN = 32;
+        /**Write the shortest text that reads back as exactly x, returning the length.*/
+        inline size_t format_number(char *out, double x)
+        {
+#ifdef __cpp_lib_to_chars
+            return (size_t)(std::to_chars(out, out + NUMBER_MAX_LEN, x).ptr - out);
+#else
+            return (size_t)snprintf(out, NUMBER_MAX_LEN, "%.17g", x);
+#endif
+        }
+        inline size_t format_number(char *out, float x)
+        {
+#ifdef __cpp_lib_to_chars
+            return (size_t)(std::to_chars(out, out + NUMBER_MAX_LEN, x).ptr - out);
+#else
+            return (size_t)snprintf(out, NUMBER_MAX_LEN, "%.9g", x);
+#endif
+        }
+        inline size_t format_number(char *out, long long x)
+        {
+            return (size_t)(std::to_chars(out, out + NUMBER_MAX_LEN, x).ptr - out);
+        }
+        inline size_t format_number(char *out, unsigned long long x)
+        {
+            return (size_t)(std::to_chars(out, out + NUMBER_MAX_LEN, x).ptr - out);
+        }
+        /**The format_number argument type for T, e.g. long long for int.*/
+        template<typename T> using number_format_type = typename std::conditional<std::is_floating_point<T>::value, T,
+            typename std::conditional<std::is_signed<T>::value, long long, unsigned long long>::type>::type;
+        /**Number types written as JSON numbers, which BasicWriter::number_array can batch.*/
+        template<typename T> struct is_batch_number : public std::integral_constant<bool,
+            std::is_same<T, float>::value || std::is_same<T, double>::value ||
+            (std::is_integral<T>::value && !std::is_same<T, bool>::value)>
+        {};
+
+        /**Append data that will stay valid until the output is used, which a Buffer with
+         * append_ref (such as IovecBuffer) may reference rather than copy.
+         */
+        template<typename Buffer>
+        auto append_ref(Buffer &buf, const char *str, size_t len, int) -> decltype(buf.append_ref(str, len))
+        {
+            return buf.append_ref(str, len);
+        }
+        template<typename Buffer>
+        void append_ref(Buffer &buf, const char *str, size_t len, long)
+        {
+            buf.append(str, len);
+        }
+    }
+
     /**@brief Writes JSON tokens to a string buffer.
      * 
      * Provides methods to write the basic JSON primitives,
@@ -12,19 +74,30 @@ namespace json
      * 
      * The template method value<T> calls write_json. Users may provide overloads of write_json
      * for custom types, and ADL will be used to call them.
+     *
+     * Stats is an instrumentation policy, see NoStats.
+     *
+     * Buffer is where output is appended, which needs "+= char", append(str, len), size() and
+     * capacity(). SizeBuffer only counts the bytes, see SizeWriter.
      */
-    class Writer
+    template<typename Stats = NoStats, typename Buffer = std::string>
+    class BasicWriter : private Stats
     {
     public:
-        Writer() : buf(), first_el(true) {}
-        Writer(const Writer&) = delete;
-        Writer& operator = (const Writer&) = delete;
+        typedef Stats StatsType;
 
-        std::string& str() { return buf; }
+        explicit BasicWriter(Stats stats = Stats()) : Stats(stats), buf(), first_el(true) {}
+        BasicWriter(const BasicWriter&) = delete;
+        BasicWriter& operator = (const BasicWriter&) = delete;
+
+        Buffer& str() { return buf; }
+        /**The instrumentation policy.*/
+        Stats &stats() { return *this; }
 
         void start_arr()
         {
             check_first();
+            stats().token();
             put('[');
             first_el = true;
         }
@@ -37,6 +110,7 @@ namespace json
         void start_obj()
         {
             check_first();
+            stats().token();
             put('{');
             first_el = true;
         }
@@ -50,7 +124,8 @@ namespace json
         void null()
         {
             check_first();
-            buf += "null";
+            stats().token();
+            append("null", 4);
         }
         /**Write directly to buffer. Assumes the provided string is a valid value, and needs
          * no processing.
@@ -58,35 +133,121 @@ namespace json
         void raw_value(const std::string &str)
         {
             check_first();
-            buf += str;
+            stats().token();
+            append(str.data(), str.size());
+        }
+        /**As raw_value, but a Buffer such as IovecBuffer may reference str instead of copying
+         * it, in which case str must stay valid until the output has been used.
+         */
+        void raw_value_ref(std::string_view str)
+        {
+            check_first();
+            stats().token();
+            append_ref(str.data(), str.size());
+        }
+        /**Write a string value, where runs of characters that need no escaping may be
+         * referenced rather than copied, as with raw_value_ref.
+         */
+        void str_value_ref(std::string_view str)
+        {
+            check_first();
+            stats().token();
+            typename Stats::Timer timer(*this, StatsCategory::STRING);
+            bool escaped = false;
+            put('"');
+            auto run = str.data(), end = str.data() + str.size();
+            for (auto q = run; q != end; ++q)
+            {
+                if (needs_escape(*q))
+                {
+                    append_ref(run, (size_t)(q - run));
+                    escaped |= do_str_chr(*q);
+                    run = q + 1;
+                }
+            }
+            append_ref(run, (size_t)(end - run));
+            put('"');
+            stats().string(escaped);
         }
         void do_value(bool b)
         {
             check_first();
-            buf += b ? "true" : "false";
+            stats().token();
+            if (b) append("true", 4);
+            else append("false", 5);
         }
         void do_value(double x)
         {
-            check_first();
-            std::stringstream ss;
-            ss << x;
-            buf += ss.str();
+            do_number(x);
+        }
+        void do_value(float x)
+        {
+            do_number(x);
         }
         void do_value(long long x)
         {
-            check_first();
-            buf += std::to_string(x);
+            do_number(x);
         }
         void do_value(unsigned long long x)
+        {
+            do_number(x);
+        }
+        /**Write a number from its original text, which is copied exactly.*/
+        void do_value(const RawNumber &x)
         {
             check_first();
-            buf += std::to_string(x);
+            stats().token();
+            typename Stats::Timer timer(*this, StatsCategory::NUMBER);
+            stats().number(!x.is_integer());
+            append(x.str, x.len);
         }
         void do_value(const char *str)
+        {
+            do_value(str, strlen(str));
+        }
+        /**Write a string of len chars, which may contain null characters.*/
+        void do_value(const char *str, size_t len)
+        {
+            check_first();
+            stats().token();
+            typename Stats::Timer timer(*this, StatsCategory::STRING);
+            bool escaped = false;
+            put('"');
+            for (auto end = str + len; str != end; ++str) escaped |= do_str_chr(*str);
+            put('"');
+            stats().string(escaped);
+        }
+
+        /**Write a string value that is known to need no escaping, such as a formatted time.*/
+        void plain_str_value(const char *str, size_t len)
         {
             check_first();
+            stats().token();
+            stats().string(false);
             put('"');
-            for (; *str; ++str) do_str_chr(*str);
+            append(str, len);
+            put('"');
+        }
+
+        /**Write len bytes from data as a base64 string, encoded straight into the output in
+         * large pieces.
+         */
+        void base64_value(const void *data, size_t len)
+        {
+            check_first();
+            stats().token();
+            typename Stats::Timer timer(*this, StatsCategory::STRING);
+            stats().string(false);
+            put('"');
+            char chunk[4096];
+            auto bytes = (const unsigned char*)data;
+            while (len > 0)
+            {
+                size_t n = len < sizeof(chunk) / 4 * 3 ? len : sizeof(chunk) / 4 * 3;
+                append(chunk, base64::encode(bytes, n, chunk));
+                bytes += n;
+                len -= n;
+            }
             put('"');
         }
 
@@ -99,7 +260,9 @@ namespace json
         }
         void key(const std::string &str)
         {
-            key(str.c_str());
+            do_value(str.data(), str.size());
+            put(':');
+            first_el = true;
         }
 
         /**Writes an object property as a string, ':', then using write_json to write the value.*/
@@ -114,45 +277,170 @@ namespace json
             value(std::forward<T>(val));
         }
 
+        /**Write an array of numbers from contiguous storage.
+         * The elements are formatted back to back into a local buffer, which is appended in
+         * large pieces rather than one value at a time.
+         */
+        template<typename T> void number_array(const T *values, size_t count)
+        {
+            static_assert(detail::is_batch_number<T>::value, "T must be a number type");
+            start_arr();
+            typename Stats::Timer timer(*this, StatsCategory::NUMBER);
+            char chunk[4096];
+            size_t len = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (len > sizeof(chunk) - detail::NUMBER_MAX_LEN - 1)
+                {
+                    append(chunk, len);
+                    len = 0;
+                }
+                if (i != 0) chunk[len++] = ',';
+                len += detail::format_number(chunk + len, (detail::number_format_type<T>)values[i]);
+                stats().token();
+                stats().number(std::is_floating_point<T>::value);
+            }
+            append(chunk, len);
+            end_arr();
+        }
+
         /**Writes a value by forwarding to a write_json overload.*/
         template<typename T> void value(const T &v)
         {
             write_json(*this, v);
         }
     private:
-        std::string buf;
+        Buffer buf;
         /**First array or object member.*/
         bool first_el;
 
+        template<typename T> void do_number(T x)
+        {
+            check_first();
+            stats().token();
+            typename Stats::Timer timer(*this, StatsCategory::NUMBER);
+            stats().number(std::is_floating_point<T>::value);
+            char buffer[detail::NUMBER_MAX_LEN];
+            append(buffer, detail::format_number(buffer, x));
+        }
         void check_first()
         {
             if (first_el) first_el = false;
             else put(',');
         }
-        void put(char c) { buf += c; }
-        void do_str_chr(char c)
+        void put(char c)
+        {
+            if (Stats::enabled) record_append(1);
+            buf += c;
+        }
+        void append(const char *str, size_t len)
+        {
+            if (Stats::enabled) record_append(len);
+            buf.append(str, len);
+        }
+        void append(const std::string &str) { append(str.data(), str.size()); }
+        void append_ref(const char *str, size_t len)
+        {
+            if (Stats::enabled) record_append(len);
+            detail::append_ref(buf, str, len, 0);
+        }
+        /**Counts bytes, and an allocation if appending len bytes will grow the buffer.*/
+        void record_append(size_t len)
+        {
+            stats().bytes(len);
+            if (buf.size() + len > buf.capacity()) stats().allocation();
+        }
+        static bool needs_escape(char c)
         {
             switch (c)
             {
-            case '\b': put('\\'); put('b'); break;
-            case '\f': put('\\'); put('f'); break;
-            case '\n': put('\\'); put('n'); break;
-            case '\r': put('\\'); put('r'); break;
-            case '\t': put('\\'); put('t'); break;
-            case '\"': put('\\'); put('\"'); break;
-            case '\\': put('\\'); put('\\'); break;
-            default: put(c); break;
+            case '\b':
+            case '\f':
+            case '\n':
+            case '\r':
+            case '\t':
+            case '\"':
+            case '\\':
+                return true;
+            default:
+                return (unsigned char)c < 0x20;
+            }
+        }
+        /**Write a string character, returns true if it needed escaping.*/
+        bool do_str_chr(char c)
+        {
+            switch (c)
+            {
+            case '\b': put('\\'); put('b'); return true;
+            case '\f': put('\\'); put('f'); return true;
+            case '\n': put('\\'); put('n'); return true;
+            case '\r': put('\\'); put('r'); return true;
+            case '\t': put('\\'); put('t'); return true;
+            case '\"': put('\\'); put('\"'); return true;
+            case '\\': put('\\'); put('\\'); return true;
+            default:
+                if ((unsigned char)c >= 0x20)
+                {
+                    put(c);
+                    return false;
+                }
+                // other control characters, including null, as \u00XX
+                char esc[6] = { '\\', 'u', '0', '0', "0123456789ABCDEF"[(unsigned char)c >> 4], "0123456789ABCDEF"[c & 0xF] };
+                append(esc, sizeof(esc));
+                return true;
             }
         }
     };
 
+    /**Writer without instrumentation.*/
+    typedef BasicWriter<> Writer;
+
+    /**A BasicWriter Buffer that only counts the bytes written.*/
+    class SizeBuffer
+    {
+    public:
+        SizeBuffer() : len(0) {}
+
+        SizeBuffer &operator += (char)
+        {
+            ++len;
+            return *this;
+        }
+        SizeBuffer &append(const char *, size_t n)
+        {
+            len += n;
+            return *this;
+        }
+        size_t size()const { return len; }
+        size_t capacity()const { return (size_t)-1; }
+    private:
+        size_t len;
+    };
+    /**Measures the output size of the same write_json overloads as Writer, without storing it.
+     * Custom write_json overloads must be templates constrained with if_writer to be used.
+     */
+    typedef BasicWriter<NoStats, SizeBuffer> SizeWriter;
+
+    /**True for types that provide the BasicWriter API, which the generic write_json overloads
+     * accept. Specialised for each writer class, such as CborWriter.
+     */
+    template<typename T> struct is_writer : public std::false_type {};
+    template<typename Stats, typename Buffer>
+    struct is_writer<BasicWriter<Stats, Buffer>> : public std::true_type {};
+
+    /**R if WriterT is a writer, for constraining write_json overloads that take any writer type.*/
+    template<typename WriterT, typename R = void>
+    using if_writer = typename std::enable_if<is_writer<WriterT>::value, R>::type;
+
     namespace detail
     {
+        using std::begin;
+        using std::end;
         template<typename T>
         auto is_iterable_impl(int) -> decltype(
             begin(std::declval<T&>()) == end(std::declval<T&>()),
             *begin(std::declval<T&>()),
-            ++begin(std::declval<T&>()),
+            ++std::declval<decltype(begin(std::declval<T&>()))&>(),
             std::true_type{}
         );
         template<typename T>
@@ -179,39 +467,76 @@ namespace json
 
     }
 
-    inline void write_json(Writer &writer, bool b) { writer.do_value(b); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, bool b) { writer.do_value(b); }
 
-    inline void write_json(Writer &writer, float x) { writer.do_value(x); }
-    inline void write_json(Writer &writer, double x) { writer.do_value(x); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, float x) { writer.do_value(x); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, double x) { writer.do_value(x); }
 
-    inline void write_json(Writer &writer, char x) { writer.do_value((long long)x); }
-    inline void write_json(Writer &writer, short x) { writer.do_value((long long)x); }
-    inline void write_json(Writer &writer, int x) { writer.do_value((long long)x); }
-    inline void write_json(Writer &writer, long x) { writer.do_value((long long)x); }
-    inline void write_json(Writer &writer, long long x) { writer.do_value(x); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, char x) { writer.do_value((long long)x); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, short x) { writer.do_value((long long)x); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, int x) { writer.do_value((long long)x); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, long x) { writer.do_value((long long)x); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, long long x) { writer.do_value(x); }
 
-    inline void write_json(Writer &writer, unsigned char x) { writer.do_value((unsigned long long)x); }
-    inline void write_json(Writer &writer, unsigned short x) { writer.do_value((unsigned long long)x); }
-    inline void write_json(Writer &writer, unsigned int x) { writer.do_value((unsigned long long)x); }
-    inline void write_json(Writer &writer, unsigned long x) { writer.do_value((unsigned long long)x); }
-    inline void write_json(Writer &writer, unsigned long long x) { writer.do_value(x); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, unsigned char x) { writer.do_value((unsigned long long)x); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, unsigned short x) { writer.do_value((unsigned long long)x); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, unsigned int x) { writer.do_value((unsigned long long)x); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, unsigned long x) { writer.do_value((unsigned long long)x); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, unsigned long long x) { writer.do_value(x); }
 
-    inline void write_json(Writer &writer, const char *x) { writer.do_value(x); }
-    inline void write_json(Writer &writer, const std::string &x) { writer.do_value(x.c_str()); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const RawNumber &x) { writer.do_value(x); }
+
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const char *x) { writer.do_value(x); }
+    /**Any std::basic_string of char, such as std::pmr::string, written with its length.*/
+    template<typename WriterT, typename Traits, typename Alloc>
+    if_writer<WriterT> write_json(WriterT &writer, const std::basic_string<char, Traits, Alloc> &x) { writer.do_value(x.data(), x.size()); }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const InternedString &x) { writer.do_value(x.c_str(), x.size()); }
+
+    /**Write len bytes from data as a base64 string.*/
+    template<typename WriterT> if_writer<WriterT> write_json_base64(WriterT &writer, const void *data, size_t len)
+    {
+        std::string str(base64::encoded_size(len), '\0');
+        str.resize(base64::encode(data, len, &str[0]));
+        writer.plain_str_value(str.data(), str.size());
+    }
+    /**JSON writers encode straight into the output, see BasicWriter::base64_value.*/
+    template<typename Stats, typename Buffer>
+    void write_json_base64(BasicWriter<Stats, Buffer> &writer, const void *data, size_t len)
+    {
+        writer.base64_value(data, len);
+    }
+    template<typename WriterT, typename Alloc>
+    if_writer<WriterT> write_json_base64(WriterT &writer, const std::vector<unsigned char, Alloc> &bytes)
+    {
+        write_json_base64(writer, bytes.data(), bytes.size());
+    }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const Blob &blob)
+    {
+        write_json_base64(writer, blob.bytes.data(), blob.bytes.size());
+    }
 
     /**Write a time_t as a string.
      * This is not a write_json overload because time_t is a typedef for one of the int types.
      */
-    inline void write_json_time(Writer &writer, time_t t)
+    template<typename WriterT> if_writer<WriterT> write_json_time(WriterT &writer, time_t t)
+    {
+        char buffer[ISO_TIME_MAX_LEN];
+        writer.plain_str_value(buffer, format_iso_time((long long)t, 0, 0, buffer));
+    }
+    /**Write a system_clock time point as a string, see time_to_iso_str.*/
+    template<typename WriterT, typename Duration>
+    if_writer<WriterT> write_json(WriterT &writer, const std::chrono::time_point<std::chrono::system_clock, Duration> &t)
     {
-        writer.do_value(time_to_iso_str(t).c_str());
+        char buffer[ISO_TIME_MAX_LEN];
+        writer.plain_str_value(buffer, format_iso_time(t, buffer));
     }
 
     /**Generic template for arrays. Writes a JSON array, using write_json for each element.
      * 
      * iterable may be any value that can be used with the C++11 range-based for loop.
      */
-    template<typename T> void write_json_array(Writer &writer,  const T &iterable)
+    template<typename WriterT, typename T>
+    if_writer<WriterT> write_json_array(WriterT &writer, const T &iterable)
     {
         writer.start_arr();
         for (auto &i : iterable)
@@ -220,27 +545,56 @@ namespace json
         }
         writer.end_arr();
     }
+    namespace detail
+    {
+        template<typename WriterT, typename T> void write_number_array(WriterT &writer, const T *values, size_t count)
+        {
+            writer.start_arr();
+            for (size_t i = 0; i < count; ++i) writer.value(values[i]);
+            writer.end_arr();
+        }
+        template<typename Stats, typename Buffer, typename T>
+        void write_number_array(BasicWriter<Stats, Buffer> &writer, const T *values, size_t count)
+        {
+            writer.number_array(values, count);
+        }
+    }
+    /**Write a vector of numbers, batched by BasicWriter::number_array.*/
+    template<typename WriterT, typename T, typename Alloc,
+        typename std::enable_if<detail::is_batch_number<T>::value>::type * = nullptr>
+    if_writer<WriterT> write_json(WriterT &writer, const std::vector<T, Alloc> &vec)
+    {
+        detail::write_number_array(writer, vec.data(), vec.size());
+    }
+    template<typename WriterT, typename T, size_t N,
+        typename std::enable_if<detail::is_batch_number<T>::value>::type * = nullptr>
+    if_writer<WriterT> write_json(WriterT &writer, const std::array<T, N> &arr)
+    {
+        detail::write_number_array(writer, arr.data(), N);
+    }
     /**Template write_json for any array type using write_json_array.*/
-    template<typename T, typename std::enable_if<detail::is_iterable<T>::value>::type * = nullptr>
-    void write_json(Writer &writer, const T &iterable)
+    template<typename WriterT, typename T,
+        typename std::enable_if<detail::is_iterable<T>::value>::type * = nullptr>
+    if_writer<WriterT> write_json(WriterT &writer, const T &iterable)
     {
         write_json_array(writer, iterable);
     }
     /**Template overload for pointers.*/
-    template<typename T> void write_json(Writer &writer, const T *val)
+    template<typename WriterT, typename T> if_writer<WriterT> write_json(WriterT &writer, const T *val)
     {
         if (val) write_json(writer, *val);
         else writer.null();
     }
-    template<typename T> void write_json(Writer &writer, T *val)
+    template<typename WriterT, typename T> if_writer<WriterT> write_json(WriterT &writer, T *val)
     {
-        write_json<T>(writer, (const T*)val);
+        write_json(writer, (const T*)val);
     }
     /**Basic template JSON writer. This default template converts the value to a string
       * via to_string, then writes that as a JSON string.
     */
-    template<typename T, typename std::enable_if<detail::has_to_string<T>::value>::type * = nullptr>
-    void write_json(Writer &writer, const T &val)
+    template<typename WriterT, typename T, typename std::enable_if<
+        detail::has_to_string<T>::value && !std::is_arithmetic<T>::value>::type * = nullptr>
+    if_writer<WriterT> write_json(WriterT &writer, const T &val)
     {
         using std::to_string;
         writer.do_value(to_string(val));
@@ -255,4 +609,50 @@ namespace json
         writer.value(obj);
         return std::move(writer.str());
     }
+
+    namespace detail
+    {
+        /**Size of the last to_json_hinted output for T on this thread.*/
+        template<typename T> size_t &last_json_size()
+        {
+            static thread_local size_t size = 0;
+            return size;
+        }
+    }
+
+    /**Like to_json, but first reserves the size of the previous to_json_hinted output for T on
+     * the same thread, so repeated responses of a similar size are normally allocated once.
+     *
+     * If the output is less than half of that size, the spare capacity is released with
+     * shrink_to_fit, so that one large output does not keep later small ones large.
+     */
+    template<typename T> std::string to_json_hinted(const T &obj)
+    {
+        auto &last_size = detail::last_json_size<T>();
+        Writer writer;
+        writer.str().reserve(last_size);
+        writer.value(obj);
+        last_size = writer.str().size();
+        if (last_size * 2 < writer.str().capacity()) writer.str().shrink_to_fit();
+        return std::move(writer.str());
+    }
+
+    /**Number of bytes to_json writes for obj, see SizeWriter.*/
+    template<typename T> size_t json_size(const T &obj)
+    {
+        SizeWriter writer;
+        writer.value(obj);
+        return writer.str().size();
+    }
+    /**Like to_json, but measures the output with json_size first so the string is allocated once
+     * with no spare capacity. The value is formatted twice, so this is mostly worthwhile for
+     * large outputs that vary in size.
+     */
+    template<typename T> std::string to_json_exact(const T &obj)
+    {
+        Writer writer;
+        writer.str().reserve(json_size(obj));
+        writer.value(obj);
+        return std::move(writer.str());
+    }
 }
@@ -0,0 +1,195 @@
+#include <boost/test/unit_test.hpp>
+#include "Base64.hpp"
+#include "Cbor.hpp"
+#include "Copy.hpp"
+#include "Reader.hpp"
+#include "Writer.hpp"
+
+using namespace json;
+
+BOOST_AUTO_TEST_SUITE(TestBase64)
+
+namespace
+{
+    std::string encode(const std::string &str)
+    {
+        std::string out(base64::encoded_size(str.size()), '\0');
+        out.resize(base64::encode(str.data(), str.size(), &out[0]));
+        return out;
+    }
+    std::string decode(const std::string &str)
+    {
+        std::string out(base64::max_decoded_size(str.size()), '\0');
+        auto len = base64::decode(str, (unsigned char*)&out[0]);
+        if (len < 0) return "<invalid>";
+        out.resize((size_t)len);
+        return out;
+    }
+    std::vector<unsigned char> make_bytes(size_t len)
+    {
+        std::vector<unsigned char> bytes;
+        unsigned x = 1;
+        for (size_t i = 0; i < len; ++i)
+        {
+            x = x * 1103515245 + 12345;
+            bytes.push_back((unsigned char)(x >> 16));
+        }
+        return bytes;
+    }
+
+    struct Attachment
+    {
+        std::string name;
+        std::vector<unsigned char> data;
+    };
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, Attachment *val)
+    {
+        static const auto reader = ObjectFieldReader<Attachment, ErrorUnknown, ParserT>().
+            template add<decltype(Attachment::name), &Attachment::name>("name").
+            template add<decltype(Attachment::data), &Attachment::data, read_json_base64>("data");
+        reader.read(parser, val);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(rfc4648)
+{
+    BOOST_CHECK_EQUAL("", encode(""));
+    BOOST_CHECK_EQUAL("Zg==", encode("f"));
+    BOOST_CHECK_EQUAL("Zm8=", encode("fo"));
+    BOOST_CHECK_EQUAL("Zm9v", encode("foo"));
+    BOOST_CHECK_EQUAL("Zm9vYg==", encode("foob"));
+    BOOST_CHECK_EQUAL("Zm9vYmE=", encode("fooba"));
+    BOOST_CHECK_EQUAL("Zm9vYmFy", encode("foobar"));
+    BOOST_CHECK_EQUAL("+/+/", encode("\xfb\xff\xbf"));
+
+    BOOST_CHECK_EQUAL("", decode(""));
+    BOOST_CHECK_EQUAL("f", decode("Zg=="));
+    BOOST_CHECK_EQUAL("fo", decode("Zm8="));
+    BOOST_CHECK_EQUAL("foo", decode("Zm9v"));
+    BOOST_CHECK_EQUAL("foob", decode("Zm9vYg=="));
+    BOOST_CHECK_EQUAL("fooba", decode("Zm9vYmE="));
+    BOOST_CHECK_EQUAL("foobar", decode("Zm9vYmFy"));
+    BOOST_CHECK_EQUAL("\xfb\xff\xbf", decode("+/+/"));
+    // padding is optional
+    BOOST_CHECK_EQUAL("f", decode("Zg"));
+    BOOST_CHECK_EQUAL("fooba", decode("Zm9vYmE"));
+}
+
+BOOST_AUTO_TEST_CASE(invalid)
+{
+    BOOST_CHECK_EQUAL("<invalid>", decode("Z"));
+    BOOST_CHECK_EQUAL("<invalid>", decode("Zm9vY"));
+    BOOST_CHECK_EQUAL("<invalid>", decode("Zm9v!mFy"));
+    BOOST_CHECK_EQUAL("<invalid>", decode("Zm9v YmFy"));
+    BOOST_CHECK_EQUAL("<invalid>", decode("Zm9vYmF\xff"));
+    BOOST_CHECK_EQUAL("<invalid>", decode("Z==="));
+    BOOST_CHECK_EQUAL("<invalid>", decode("===="));
+    BOOST_CHECK_EQUAL("<invalid>", decode("Zg==Zg=="));
+    BOOST_CHECK_EQUAL("<invalid>", decode("Zm9v-_"));
+}
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+    for (size_t len = 0; len < 100; ++len)
+    {
+        auto bytes = make_bytes(len);
+        std::string str((const char*)bytes.data(), bytes.size());
+        auto encoded = encode(str);
+        BOOST_CHECK_EQUAL(base64::encoded_size(len), encoded.size());
+        BOOST_CHECK(decode(encoded) == str);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(read_write)
+{
+    Blob blob = { { 'f', 'o', 'o', 'b', 'a' } };
+    BOOST_CHECK_EQUAL("\"Zm9vYmE=\"", to_json(blob));
+    BOOST_CHECK(blob == json::read_json<Blob>("\"Zm9vYmE=\""));
+    BOOST_CHECK(blob == json::read_json<Blob>("\"Zm9vYmE\""));
+    BOOST_CHECK(json::read_json<Blob>("\"\"").bytes.empty());
+    BOOST_CHECK_EQUAL("[\"\",\"Zg==\"]", to_json(std::vector<Blob>{ Blob(), Blob{ { 'f' } } }));
+
+    // escaped '/' is decoded into a buffer first
+    BOOST_CHECK((Blob{ { 0xfb, 0xff, 0xbf } }) == json::read_json<Blob>("\"+\\/+\\/\""));
+
+    Blob out;
+    BOOST_CHECK(ParseErrorCode::INVALID_BASE64 == try_read_json("\"Zm9v!\"", &out).code);
+    BOOST_CHECK(ParseErrorCode::EXPECTED_STRING == try_read_json("5", &out).code);
+
+    auto attachment = json::read_json<Attachment>("{\"name\": \"a.bin\", \"data\": \"AAEC/w==\"}");
+    BOOST_CHECK((std::vector<unsigned char>{ 0, 1, 2, 255 }) == attachment.data);
+    Writer writer;
+    write_json_base64(writer, attachment.data);
+    BOOST_CHECK_EQUAL("\"AAEC/w==\"", writer.str());
+}
+
+BOOST_AUTO_TEST_CASE(large)
+{
+    // more than one encoding chunk
+    Blob blob = { make_bytes(10000) };
+    auto json = to_json(blob);
+    BOOST_CHECK_EQUAL(base64::encoded_size(10000) + 2, json.size());
+    std::string expected(base64::encoded_size(10000), '\0');
+    base64::encode(blob.bytes.data(), blob.bytes.size(), &expected[0]);
+    BOOST_CHECK_EQUAL('"' + expected + '"', json);
+    BOOST_CHECK(blob == json::read_json<Blob>(json));
+
+    SizeWriter size;
+    size.value(blob);
+    BOOST_CHECK_EQUAL(json.size(), size.str().size());
+}
+
+BOOST_AUTO_TEST_CASE(cbor)
+{
+    // native byte strings rather than base64 text
+    Blob blob = { make_bytes(50) };
+    auto data = to_cbor(blob);
+    BOOST_CHECK_EQUAL(2U + 50U, data.size());
+    BOOST_CHECK_EQUAL(std::string("\x58\x32"), data.substr(0, 2));
+    Blob out;
+    read_cbor(data, &out);
+    BOOST_CHECK(blob == out);
+
+    BOOST_CHECK_EQUAL(std::string("\x43\x00\x01\xff", 4), to_cbor(Blob{ { 0, 1, 255 } }));
+    read_cbor(std::string("\x5f\x41\x00\x42\x01\xff\xff", 7), &out); // indefinite length
+    BOOST_CHECK((std::vector<unsigned char>{ 0, 1, 255 }) == out.bytes);
+    // text strings are base64, as when JSON is copied to CBOR
+    read_cbor(std::string("\x64\x41\x41\x48\x2f"), &out);
+    BOOST_CHECK((std::vector<unsigned char>{ 0, 1, 255 }) == out.bytes);
+    try
+    {
+        read_cbor(std::string("\x64\x41\x21\x41\x3d"), &out);
+        BOOST_FAIL("Expected ParseError");
+    }
+    catch (const ParseError &e)
+    {
+        BOOST_CHECK(ParseErrorCode::INVALID_BASE64 == e.code());
+        BOOST_CHECK_EQUAL(0U, e.offset());
+    }
+    BOOST_CHECK_THROW(read_cbor(std::string("\x01"), &out), ParseError);
+
+    // tokens of byte strings are base64, so converting to JSON keeps them readable as a Blob
+    auto bytes = to_cbor(Blob{ { 0, 1, 255 } });
+    CborParser<> parser(bytes.data(), bytes.data() + bytes.size());
+    Writer json;
+    copy(json, parser);
+    BOOST_CHECK_EQUAL("\"AAH/\"", json.str());
+
+    // and JSON copied to CBOR has base64 text, which is still read as a Blob
+    auto blob_json = to_json(blob);
+    Parser json_parser(blob_json.data(), blob_json.data() + blob_json.size());
+    CborWriter<> converted;
+    copy(converted, json_parser);
+    BOOST_CHECK(blob == read_cbor<Blob>(converted.str()));
+
+    CborWriter<> writer;
+    writer.start_obj();
+    writer.prop("name", "a.bin");
+    writer.key("data");
+    write_json_base64(writer, std::vector<unsigned char>{ 1, 2 });
+    writer.end_obj();
+    auto attachment = read_cbor<Attachment>(writer.str());
+    BOOST_CHECK((std::vector<unsigned char>{ 1, 2 }) == attachment.data);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
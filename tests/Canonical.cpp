@@ -0,0 +1,97 @@
+#include <boost/test/unit_test.hpp>
+#include "Canonical.hpp"
+#include "Cbor.hpp"
+#include "Copy.hpp"
+
+using namespace json;
+
+BOOST_AUTO_TEST_SUITE(TestCanonical)
+
+namespace
+{
+    /**Check equal and canonical_hash agree that a and b are the same.*/
+    void check_same(const std::string &a, const std::string &b)
+    {
+        BOOST_CHECK_MESSAGE(equal(a, b), a << " == " << b);
+        BOOST_CHECK_MESSAGE(equal(b, a), b << " == " << a);
+        BOOST_CHECK_MESSAGE(canonical_hash(a) == canonical_hash(b), "hash " << a << " == " << b);
+    }
+    void check_different(const std::string &a, const std::string &b)
+    {
+        BOOST_CHECK_MESSAGE(!equal(a, b), a << " != " << b);
+        BOOST_CHECK_MESSAGE(!equal(b, a), b << " != " << a);
+        BOOST_CHECK_MESSAGE(canonical_hash(a) != canonical_hash(b), "hash " << a << " != " << b);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(same)
+{
+    check_same("null", " null ");
+    check_same("\"A\\n\"", "\"\\u0041\\u000a\"");
+    check_same("1", "1.0");
+    check_same("100", "1e2");
+    check_same("-0", "0");
+    check_same("0.5", "5e-1");
+    check_same("123456789012345678901234", "1.23456789012345678901234e23");
+    check_same("[1, [2, {}]]", "[1,[2,{ }]]");
+    check_same("{\"a\": 1, \"b\": [true, false]}", "{\"b\": [true, false], \"a\": 1.0}");
+    check_same(
+        "{\"x\": {\"p\": 1, \"q\": {\"r\": null, \"s\": \"t\"}}, \"y\": 2, \"z\": [3]}",
+        "{\"z\": [3], \"x\": {\"q\": {\"s\": \"t\", \"r\": null}, \"p\": 1}, \"y\": 2}");
+}
+
+BOOST_AUTO_TEST_CASE(different)
+{
+    check_different("null", "false");
+    check_different("true", "false");
+    check_different("1", "\"1\"");
+    check_different("1", "1.5");
+    check_different("9007199254740993", "9007199254740992");
+    check_different("\"a\"", "\"b\"");
+    check_different("[1, 2]", "[2, 1]");
+    check_different("[1, 2]", "[1, 2, 3]");
+    check_different("[]", "{}");
+    check_different("{\"a\": 1}", "{\"a\": 2}");
+    check_different("{\"a\": 1}", "{\"b\": 1}");
+    check_different("{\"a\": 1, \"b\": 2}", "{\"b\": 2}");
+    check_different("{\"a\": 1, \"b\": 2}", "{\"b\": 2, \"a\": 1, \"c\": 3}");
+    check_different("{\"a\": 1, \"b\": 2}", "{\"b\": 2, \"a\": 3}");
+    check_different("{\"a\": [1], \"b\": {}}", "{\"b\": {}, \"a\": [2]}");
+    check_different("{\"a\": 1, \"b\": 2}", "{\"a\": 2, \"b\": 1}");
+    check_different("[{\"a\": 1}, {\"b\": 2}]", "[{\"b\": 2}, {\"a\": 1}]");
+
+    // duplicate keys are all hashed, so equal must not ignore one
+    check_different("{\"b\": 2, \"a\": 1}", "{\"a\": 1, \"b\": 2, \"a\": 1}");
+    check_different("{\"b\": 2, \"a\": 1, \"a\": 1}", "{\"a\": 1, \"b\": 2}");
+    check_same("{\"a\": 1, \"a\": 2}", "{\"a\": 1, \"a\": 2}");
+}
+
+BOOST_AUTO_TEST_CASE(formats)
+{
+    // the hash does not depend on the input format
+    const std::string json = "{\"id\": 5, \"price\": 2.5, \"tags\": [\"a\", \"b\"], \"big\": 1e300}";
+    Parser parser(json.data(), json.data() + json.size());
+    CborWriter<> writer;
+    copy(writer, parser);
+    auto cbor = writer.str();
+    CborParser<> cbor_parser(cbor.data(), cbor.data() + cbor.size());
+    BOOST_CHECK_EQUAL(canonical_hash(json), canonical_hash(cbor_parser));
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+    BOOST_CHECK_THROW(canonical_hash("[1, 2"), ParseError);
+    BOOST_CHECK_THROW(canonical_hash("{\"a\" 1}"), ParseError);
+    BOOST_CHECK_THROW(canonical_hash("1 2"), ParseError);
+    BOOST_CHECK_THROW(equal("[1, 2", "[1, 2]"), ParseError);
+    BOOST_CHECK_THROW(equal("{\"a\": 1, \"b\": 2", "{\"b\": 2, \"a\": 1}"), ParseError);
+    BOOST_CHECK_THROW(equal("1", "1 ]"), ParseError);
+    // stops at the first difference, so later errors are not found
+    BOOST_CHECK(!equal("[1, 2", "[2, 2]"));
+
+    std::string deep = std::string(100000, '[') + std::string(100000, ']');
+    BOOST_CHECK_THROW(canonical_hash(deep), ParseError);
+    BOOST_CHECK_THROW(equal(deep, deep), ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
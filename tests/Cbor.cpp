@@ -0,0 +1,272 @@
+#include <boost/test/unit_test.hpp>
+#include "Cbor.hpp"
+#include "Copy.hpp"
+#include <limits>
+#include <map>
+#include <vector>
+
+using namespace json;
+
+namespace
+{
+    struct Item
+    {
+        std::string name;
+        int count;
+        double price;
+        std::vector<std::string> tags;
+    };
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, Item *val)
+    {
+        typedef ObjectFieldReader<Item, IgnoreUnknown, ParserT> Reader;
+        static const auto reader = Reader().
+            template add<decltype(Item::name), &Item::name>("name").
+            template add<decltype(Item::count), &Item::count>("count").
+            template add<decltype(Item::price), &Item::price>("price").
+            template add<decltype(Item::tags), &Item::tags>("tags");
+        reader.read(parser, val);
+    }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const Item &val)
+    {
+        writer.start_obj();
+        writer.prop("name", val.name);
+        writer.prop("count", val.count);
+        writer.prop("price", val.price);
+        writer.prop("tags", val.tags);
+        writer.end_obj();
+    }
+
+    /**Bytes from a hex string.*/
+    std::string hex(const char *str)
+    {
+        std::string out;
+        for (; str[0] && str[1]; str += 2) out += (char)std::stoi(std::string(str, 2), nullptr, 16);
+        return out;
+    }
+    /**Convert CBOR to JSON text with copy.*/
+    std::string cbor_to_json(const std::string &data)
+    {
+        CborParser<> parser(data.data(), data.data() + data.size());
+        Writer writer;
+        copy(writer, parser);
+        if (parser.next().type != Token::END) throw ParseError("Expected end");
+        return std::move(writer.str());
+    }
+    std::string json_to_cbor(const std::string &json)
+    {
+        Parser parser(json.data(), json.data() + json.size());
+        CborWriter<> writer;
+        copy(writer, parser);
+        return std::move(writer.str());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(TestCbor)
+
+BOOST_AUTO_TEST_CASE(write)
+{
+    // RFC 8949 Appendix A examples
+    BOOST_CHECK(hex("00") == to_cbor(0));
+    BOOST_CHECK(hex("17") == to_cbor(23));
+    BOOST_CHECK(hex("1818") == to_cbor(24));
+    BOOST_CHECK(hex("1864") == to_cbor(100));
+    BOOST_CHECK(hex("1903e8") == to_cbor(1000));
+    BOOST_CHECK(hex("1a000f4240") == to_cbor(1000000));
+    BOOST_CHECK(hex("1b000000e8d4a51000") == to_cbor(1000000000000LL));
+    BOOST_CHECK(hex("1bffffffffffffffff") == to_cbor(18446744073709551615ULL));
+    BOOST_CHECK(hex("20") == to_cbor(-1));
+    BOOST_CHECK(hex("29") == to_cbor(-10));
+    BOOST_CHECK(hex("3863") == to_cbor(-100));
+    BOOST_CHECK(hex("3903e7") == to_cbor(-1000));
+    BOOST_CHECK(hex("3b7fffffffffffffff") == to_cbor(std::numeric_limits<long long>::min()));
+    BOOST_CHECK(hex("fa3fc00000") == to_cbor(1.5));
+    BOOST_CHECK(hex("fb3ff199999999999a") == to_cbor(1.1));
+    BOOST_CHECK(hex("fa47c35000") == to_cbor(100000.0));
+    // out of the float range, so never narrowed
+    BOOST_CHECK(hex("fb7e37e43c8800759c") == to_cbor(1e300));
+    BOOST_CHECK_EQUAL(-1e300, read_cbor<double>(to_cbor(-1e300)));
+    BOOST_CHECK_EQUAL(std::numeric_limits<double>::max(), read_cbor<double>(to_cbor(std::numeric_limits<double>::max())));
+    BOOST_CHECK(hex("fa7f800000") == to_cbor(std::numeric_limits<double>::infinity()));
+    BOOST_CHECK(hex("f4") == to_cbor(false));
+    BOOST_CHECK(hex("f5") == to_cbor(true));
+    BOOST_CHECK(hex("f6") == to_cbor((const int*)nullptr));
+    BOOST_CHECK(hex("60") == to_cbor(""));
+    BOOST_CHECK(hex("6449455446") == to_cbor(std::string("IETF")));
+    BOOST_CHECK(hex("62c3bc") == to_cbor(u8"ü"));
+    BOOST_CHECK(hex("9fff") == to_cbor(std::vector<int>()));
+    BOOST_CHECK(hex("9f0102ff") == to_cbor(std::vector<int>{1, 2}));
+    BOOST_CHECK(hex("bf6161016162f5ff") == json_to_cbor("{\"a\": 1, \"b\": true}"));
+    // numbers copied from JSON text keep full unsigned 64 bit range
+    BOOST_CHECK(hex("9f1bffffffffffffffff20fa3fc00000ff") == json_to_cbor("[18446744073709551615, -1, 1.5]"));
+}
+
+BOOST_AUTO_TEST_CASE(read)
+{
+    BOOST_CHECK_EQUAL(0, read_cbor<int>(hex("00")));
+    BOOST_CHECK_EQUAL(1000000000000LL, read_cbor<long long>(hex("1b000000e8d4a51000")));
+    BOOST_CHECK_EQUAL(18446744073709551615ULL, read_cbor<unsigned long long>(hex("1bffffffffffffffff")));
+    BOOST_CHECK_EQUAL(-1000, read_cbor<int>(hex("3903e7")));
+    BOOST_CHECK_EQUAL(std::numeric_limits<long long>::min(), read_cbor<long long>(hex("3b7fffffffffffffff")));
+    BOOST_CHECK_EQUAL(1.5, read_cbor<double>(hex("fa3fc00000")));
+    BOOST_CHECK_EQUAL(1.1, read_cbor<double>(hex("fb3ff199999999999a")));
+    BOOST_CHECK_EQUAL(1.0, read_cbor<double>(hex("f93c00")));
+    BOOST_CHECK_EQUAL(65504.0, read_cbor<double>(hex("f97bff")));
+    BOOST_CHECK_EQUAL(5.960464477539063e-8, read_cbor<double>(hex("f90001")));
+    BOOST_CHECK_EQUAL(-4.0, read_cbor<double>(hex("f9c400")));
+    BOOST_CHECK_EQUAL(10.0, read_cbor<double>(hex("0a")));
+    BOOST_CHECK_EQUAL(true, read_cbor<bool>(hex("f5")));
+    BOOST_CHECK_EQUAL("IETF", read_cbor<std::string>(hex("6449455446")));
+    BOOST_CHECK_EQUAL("streaming", read_cbor<std::string>(hex("7f657374726561646d696e67ff")));
+    BOOST_CHECK_EQUAL(1363896240, read_cbor<int>(hex("c11a514b67b0"))); // tags are ignored
+
+    // definite and indefinite lengths
+    BOOST_CHECK_EQUAL("[1,[2,3],[4,5]]", cbor_to_json(hex("8301820203820405")));
+    BOOST_CHECK_EQUAL("[1,[2,3],[4,5]]", cbor_to_json(hex("9f018202039f0405ffff")));
+    BOOST_CHECK_EQUAL("[[],{}]", cbor_to_json(hex("8280a0")));
+    BOOST_CHECK_EQUAL("[[],{}]", cbor_to_json(hex("9f9fffbfffff")));
+    BOOST_CHECK_EQUAL("{\"a\":1,\"b\":[2,3]}", cbor_to_json(hex("a26161016162820203")));
+    BOOST_CHECK_EQUAL("{\"a\":\"A\",\"b\":\"B\"}", cbor_to_json(hex("bf6161614161626142ff")));
+    BOOST_CHECK_EQUAL("[null,null,false]", cbor_to_json(hex("83f6f7f4")));
+
+    // integers outside the range of long long are copied exactly, and skipped
+    auto wide = to_cbor(std::vector<unsigned long long>{ std::numeric_limits<unsigned long long>::max(), 1 });
+    BOOST_CHECK_EQUAL("[18446744073709551615,1]", cbor_to_json(wide));
+    BOOST_CHECK(wide == json_to_cbor(cbor_to_json(wide)));
+    BOOST_CHECK(std::vector<unsigned long long>({ std::numeric_limits<unsigned long long>::max(), 1 }) ==
+        read_cbor<std::vector<unsigned long long>>(json_to_cbor(cbor_to_json(wide))));
+    BOOST_CHECK_EQUAL("[-18446744073709551616,-9223372036854775809]", cbor_to_json(hex("823bffffffffffffffff3b8000000000000000")));
+    {
+        CborParser<> parser(wide.data(), wide.data() + wide.size());
+        skip_value(parser);
+        BOOST_CHECK_EQUAL(Token::END, parser.next().type);
+    }
+    {
+        // without raw numbers they are read as doubles
+        CborParser<> parser(wide.data(), wide.data() + wide.size());
+        BOOST_CHECK_EQUAL(Token::ARR_START, parser.next().type);
+        auto tok = parser.next();
+        BOOST_CHECK_EQUAL(Token::NUMBER, tok.type);
+        BOOST_CHECK_EQUAL(18446744073709551615.0, tok.val_num);
+    }
+
+    auto time = to_cbor(std::string("2016-06-24T09:47:55.5Z"));
+    {
+        CborParser<> parser(time.data(), time.data() + time.size());
+        BOOST_CHECK_EQUAL(1466761675500LL, parser.next_time_point<std::chrono::milliseconds>().time_since_epoch().count());
+    }
+    {
+        CborParser<> parser(time.data(), time.data() + time.size());
+        BOOST_CHECK_EQUAL(1466761675, parser.next_time());
+        BOOST_CHECK_EQUAL(Token::END, parser.next().type);
+    }
+    BOOST_CHECK_THROW(read_cbor<std::chrono::system_clock::time_point>(to_cbor("2016-06-24")), ParseError);
+    BOOST_CHECK_THROW((read_cbor<std::chrono::time_point<std::chrono::system_clock, std::chrono::nanoseconds>>(
+        to_cbor(std::string("2300-01-01T00:00:00Z")))), ParseError);
+
+    auto map = read_cbor<std::map<std::string, std::vector<int>>>(hex("a26161820102616280"));
+    BOOST_CHECK_EQUAL(2, map.size());
+    BOOST_CHECK_EQUAL(2, map["a"].size());
+    BOOST_CHECK_EQUAL(0, map["b"].size());
+}
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+    Item item = { "widget", -5, 2.75, { "a", "b\n\"c\"" } };
+    auto data = to_cbor(item);
+    auto json = to_json(item);
+    BOOST_CHECK_LT(data.size(), json.size());
+    BOOST_CHECK_EQUAL(json, cbor_to_json(data));
+    BOOST_CHECK(data == json_to_cbor(json));
+
+    auto item2 = read_cbor<Item>(data);
+    BOOST_CHECK_EQUAL(item.name, item2.name);
+    BOOST_CHECK_EQUAL(item.count, item2.count);
+    BOOST_CHECK_EQUAL(item.price, item2.price);
+    BOOST_CHECK_EQUAL_COLLECTIONS(item.tags.begin(), item.tags.end(), item2.tags.begin(), item2.tags.end());
+
+    // the same overloads still read JSON
+    auto item3 = read_json<Item>(json);
+    BOOST_CHECK_EQUAL(item.name, item3.name);
+
+    // unknown keys are skipped, including containers
+    auto items = read_cbor<std::vector<Item>>(json_to_cbor(
+        "[{\"extra\": {\"x\": [1, 2]}, \"tags\": [], \"price\": 1, \"count\": 2, \"name\": \"x\"}]"));
+    BOOST_CHECK_EQUAL(1, items.size());
+    BOOST_CHECK_EQUAL("x", items[0].name);
+    BOOST_CHECK_EQUAL(1.0, items[0].price);
+
+    // strings are written with their length, so embedded nulls are kept
+    std::string nul("a\0b", 3);
+    BOOST_CHECK(hex("63610062") == to_cbor(nul));
+    BOOST_CHECK(nul == read_cbor<std::string>(to_cbor(nul)));
+    BOOST_CHECK_EQUAL("\"a\\u0000b\"", cbor_to_json(to_cbor(nul)));
+}
+
+BOOST_AUTO_TEST_CASE(keys)
+{
+    auto data = hex("a261610161629f02ff");
+    CborParser<> parser(data.data(), data.data() + data.size());
+    parser.next_obj_start();
+    BOOST_CHECK(!parser.try_next_key("b"));
+    BOOST_CHECK(!parser.try_next_key("aa"));
+    BOOST_CHECK(parser.try_next_key("a"));
+    BOOST_CHECK_EQUAL(1, parser.next_int<int>());
+    BOOST_CHECK(parser.next_obj_el());
+    std::string unknown;
+    BOOST_CHECK_EQUAL(KeyTable::npos, parser.next_key(KeyTable{ "a" }, &unknown));
+    BOOST_CHECK_EQUAL("b", unknown);
+    skip_value(parser);
+    BOOST_CHECK(!parser.next_obj_el());
+    BOOST_CHECK_EQUAL(Token::END, parser.next().type);
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+    BOOST_CHECK_THROW(read_cbor<int>(""), ParseError);
+    BOOST_CHECK_THROW(read_cbor<int>(hex("19ff")), ParseError); // truncated
+    BOOST_CHECK_THROW(read_cbor<int>(hex("0000")), ParseError); // trailing
+    BOOST_CHECK_THROW(read_cbor<unsigned char>(hex("190100")), ParseError); // overflow
+    BOOST_CHECK_THROW(read_cbor<int>(hex("3a80000000")), ParseError); // overflow
+    BOOST_CHECK_THROW(read_cbor<unsigned>(hex("20")), ParseError);
+    BOOST_CHECK_THROW(read_cbor<long long>(hex("1b8000000000000000")), ParseError);
+    BOOST_CHECK_THROW(read_cbor<int>(hex("f93c00")), ParseError);
+    BOOST_CHECK_THROW(read_cbor<int>(hex("1c")), ParseError); // reserved
+    BOOST_CHECK_THROW(read_cbor<std::string>(hex("01")), ParseError);
+    BOOST_CHECK_THROW(read_cbor<std::string>(hex("6461")), ParseError); // truncated
+    BOOST_CHECK_THROW(read_cbor<std::string>(hex("7bffffffffffffffff61")), ParseError); // huge length
+    BOOST_CHECK_THROW(read_cbor<std::string>(hex("7f0161ff")), ParseError); // bad chunk
+    BOOST_CHECK_THROW(read_cbor<std::vector<int>>(hex("9f01")), ParseError); // truncated
+    BOOST_CHECK_THROW(read_cbor<std::vector<int>>(hex("9bffffffffffffffff")), ParseError);
+    BOOST_CHECK_THROW(read_cbor<std::vector<int>>(hex("ff")), ParseError);
+    BOOST_CHECK_THROW(cbor_to_json(hex("bf6161ff")), ParseError); // key without value
+    BOOST_CHECK_THROW(read_cbor<Item>(hex("a0")), ParseError); // missing keys
+    BOOST_CHECK_THROW(cbor_to_json(std::string(100000, '\x81') + '\x01'), ParseError); // too deep
+
+    // the same codes as Parser, with the byte offset
+    auto error = [](const std::string &data) -> ParseError
+    {
+        try
+        {
+            read_cbor<std::vector<int>>(data);
+        }
+        catch (const ParseError &e)
+        {
+            return e;
+        }
+        return ParseError(ParseErrorCode::NONE, 0, 0, 0);
+    };
+    BOOST_CHECK(ParseErrorCode::UNEXPECTED_END == error(hex("9f01")).code());
+    BOOST_CHECK_EQUAL(2U, error(hex("9f01")).offset());
+    BOOST_CHECK(ParseErrorCode::NUMBER_OVERFLOW == error(hex("811a80000000")).code());
+    BOOST_CHECK(ParseErrorCode::EXPECTED_INT == error(hex("816161")).code());
+    BOOST_CHECK(ParseErrorCode::EXPECTED_ARRAY == error(hex("a0")).code());
+    BOOST_CHECK(ParseErrorCode::EXPECTED_END == error(hex("8000")).code());
+    BOOST_CHECK(ParseErrorCode::UNEXPECTED_CONTENT == error(hex("81ff")).code());
+
+    auto data = hex("62c328");
+    CborParser<> parser(data.data(), data.data() + data.size());
+    parser.validate_utf8(true);
+    BOOST_CHECK_THROW(parser.next_str(), ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,307 @@
+#include <boost/test/unit_test.hpp>
+#include "Cbor.hpp"
+#include "ColumnarReader.hpp"
+#include "Enum.hpp"
+
+using namespace json;
+
+BOOST_AUTO_TEST_SUITE(TestColumnarReader)
+
+namespace
+{
+    enum class Level { LOW, HIGH };
+    const EnumTable<Level> level_names = {
+        { "low", Level::LOW },
+        { "high", Level::HIGH }
+    };
+    template<typename ParserT> void read_level(ParserT &parser, Level *out)
+    {
+        read_json_enum(parser, out, level_names);
+    }
+
+    struct Events
+    {
+        Column<long long> id;
+        Column<double> value;
+        Column<bool> ok;
+        StringColumn name;
+    };
+    template<typename ParserT, typename ErrorPolicy = ErrorUnknown>
+    void read_events(ParserT &parser, Events *out)
+    {
+        static const auto reader = ColumnarReader<Events, ErrorPolicy, ParserT>().
+            template add<decltype(Events::id), &Events::id>("id").
+            template add<decltype(Events::value), &Events::value>("value").
+            template add<decltype(Events::ok), &Events::ok>("ok").
+            template add<decltype(Events::name), &Events::name>("name");
+        reader.read(parser, out);
+    }
+    Events read_events(const std::string &str)
+    {
+        Events events;
+        Parser parser(str.data(), str.data() + str.size());
+        read_events(parser, &events);
+        if (parser.next().type != Token::END) throw ParseError("Expected end");
+        return events;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(bitmap)
+{
+    Bitmap bits;
+    for (size_t i = 0; i < 130; ++i) bits.push_back(i % 3 == 0);
+    BOOST_CHECK_EQUAL(130U, bits.size());
+    BOOST_CHECK_EQUAL(44U, bits.count());
+    BOOST_CHECK(bits[0]);
+    BOOST_CHECK(!bits[1]);
+    BOOST_CHECK(bits[129]);
+    BOOST_CHECK_EQUAL(0x9249249249249249ULL, bits.data()[0]);
+    bits.resize(67);
+    BOOST_CHECK_EQUAL(23U, bits.count());
+    BOOST_CHECK_EQUAL(4U, bits.data()[1]);
+    bits.resize(65); // unused bits are cleared
+    BOOST_CHECK_EQUAL(65U, bits.size());
+    BOOST_CHECK_EQUAL(22U, bits.count());
+    BOOST_CHECK_EQUAL(0U, bits.data()[1]);
+    bits.resize(100);
+    BOOST_CHECK(!bits[99]);
+    BOOST_CHECK_EQUAL(22U, bits.count());
+    bits.clear();
+    BOOST_CHECK_EQUAL(0U, bits.size());
+    BOOST_CHECK_EQUAL(0U, bits.count());
+}
+
+BOOST_AUTO_TEST_CASE(read)
+{
+    auto events = read_events(
+        "[{\"id\": 1, \"value\": 1.5, \"ok\": true, \"name\": \"first\"},"
+        " {\"name\": \"sec\\\"ond\", \"ok\": false, \"value\": -2, \"id\": 2},"
+        " {\"id\": 3, \"value\": 0.25, \"ok\": true, \"name\": \"\"}]");
+    BOOST_CHECK_EQUAL(3U, events.id.size());
+    BOOST_CHECK_EQUAL(3U, events.value.size());
+    BOOST_CHECK_EQUAL(3U, events.ok.size());
+    BOOST_CHECK_EQUAL(3U, events.name.size());
+
+    BOOST_CHECK_EQUAL(1, events.id.data()[0]);
+    BOOST_CHECK_EQUAL(2, events.id.data()[1]);
+    BOOST_CHECK_EQUAL(3, events.id.data()[2]);
+    BOOST_CHECK_EQUAL(1.5, events.value[0]);
+    BOOST_CHECK_EQUAL(-2.0, events.value[1]);
+    BOOST_CHECK_EQUAL(0.25, events.value[2]);
+    BOOST_CHECK(events.ok[0]);
+    BOOST_CHECK(!events.ok[1]);
+
+    BOOST_CHECK_EQUAL("first", events.name[0]);
+    BOOST_CHECK_EQUAL("sec\"ond", events.name[1]);
+    BOOST_CHECK_EQUAL("", events.name[2]);
+    BOOST_CHECK_EQUAL("firstsec\"ond", events.name.arena());
+    BOOST_CHECK((std::vector<size_t>{ 0, 5, 12, 12 }) == events.name.offsets());
+
+    BOOST_CHECK_EQUAL(0U, events.id.null_count());
+    BOOST_CHECK_EQUAL(0U, events.name.null_count());
+    BOOST_CHECK(events.name.present(2));
+
+    BOOST_CHECK_EQUAL(0U, read_events("[]").id.size());
+}
+
+BOOST_AUTO_TEST_CASE(nulls)
+{
+    auto events = read_events(
+        "[{\"id\": 1, \"value\": null, \"name\": \"a\"},"
+        " {},"
+        " {\"id\": null, \"value\": 5, \"ok\": true, \"name\": null}]");
+    BOOST_CHECK_EQUAL(3U, events.id.size());
+    BOOST_CHECK_EQUAL(3U, events.name.size());
+
+    BOOST_CHECK(events.id.present(0));
+    BOOST_CHECK(!events.id.present(1));
+    BOOST_CHECK(!events.id.present(2));
+    BOOST_CHECK_EQUAL(0, events.id[2]);
+    BOOST_CHECK_EQUAL(2U, events.id.null_count());
+
+    BOOST_CHECK(!events.value.present(0));
+    BOOST_CHECK(events.value.present(2));
+    BOOST_CHECK_EQUAL(5.0, events.value[2]);
+
+    BOOST_CHECK_EQUAL(2U, events.ok.null_count());
+    BOOST_CHECK(events.ok.present(2));
+
+    BOOST_CHECK(events.name.present(0));
+    BOOST_CHECK(!events.name.present(1));
+    BOOST_CHECK(!events.name.present(2));
+    BOOST_CHECK_EQUAL("", events.name[2]);
+    BOOST_CHECK((std::vector<size_t>{ 0, 1, 1, 1 }) == events.name.offsets());
+}
+
+BOOST_AUTO_TEST_CASE(append)
+{
+    Events events;
+    std::string a_json = "[{\"id\": 1}]";
+    Parser a(a_json.data(), a_json.data() + a_json.size());
+    read_events(a, &events);
+    std::string b_json = "[{\"id\": 2, \"name\": \"x\"}, {\"id\": 3}]";
+    Parser b(b_json.data(), b_json.data() + b_json.size());
+    read_events(b, &events);
+    BOOST_CHECK_EQUAL(3U, events.id.size());
+    BOOST_CHECK_EQUAL(3, events.id[2]);
+    BOOST_CHECK_EQUAL("x", events.name[1]);
+    BOOST_CHECK_EQUAL(2U, events.name.null_count());
+
+    events.id.clear();
+    events.name.clear();
+    BOOST_CHECK_EQUAL(0U, events.id.size());
+    BOOST_CHECK_EQUAL(0U, events.name.size());
+    BOOST_CHECK_EQUAL("", events.name.arena());
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+    auto code = [](const std::string &str) -> ParseErrorCode
+    {
+        try
+        {
+            read_events(str);
+        }
+        catch (const ParseError &e)
+        {
+            return e.code();
+        }
+        return ParseErrorCode::NONE;
+    };
+    BOOST_CHECK(code("[{\"id\": 1, \"id\": 2}]") == ParseErrorCode::DUPLICATE_KEY);
+    BOOST_CHECK(code("[{\"id\": 1, \"other\": 2}]") == ParseErrorCode::UNKNOWN_KEY);
+    BOOST_CHECK(code("[{\"id\": \"1\"}]") == ParseErrorCode::EXPECTED_INT);
+    BOOST_CHECK(code("[{\"name\": 5}]") == ParseErrorCode::EXPECTED_STRING);
+    BOOST_CHECK(code("[null]") == ParseErrorCode::EXPECTED_OBJECT);
+    BOOST_CHECK(code("{}") == ParseErrorCode::EXPECTED_ARRAY);
+    BOOST_CHECK(code("[{\"id\": nul}]") == ParseErrorCode::UNEXPECTED_CONTENT);
+
+    Events events;
+    std::string parser_json = "[{\"id\": 1, \"other\": [1, {}], \"name\": \"a\"}]";
+    Parser parser(parser_json.data(), parser_json.data() + parser_json.size());
+    read_events<Parser, IgnoreUnknown>(parser, &events);
+    BOOST_CHECK_EQUAL(1U, events.id.size());
+    BOOST_CHECK_EQUAL("a", events.name[0]);
+}
+
+BOOST_AUTO_TEST_CASE(failed_row)
+{
+    // a row that fails part way is removed from every column
+    auto check_rows = [](const Events &events, size_t rows)
+    {
+        BOOST_CHECK_EQUAL(rows, events.id.size());
+        BOOST_CHECK_EQUAL(rows, events.value.size());
+        BOOST_CHECK_EQUAL(rows, events.ok.size());
+        BOOST_CHECK_EQUAL(rows, events.name.size());
+    };
+    std::string json = "[{\"id\": 1, \"name\": \"a\"}, {\"name\": \"bc\", \"id\": 2, \"value\": \"x\"}]";
+    Events events;
+    Parser parser(json.data(), json.data() + json.size());
+    BOOST_CHECK_THROW(read_events(parser, &events), ParseError);
+    check_rows(events, 1);
+    BOOST_CHECK_EQUAL("a", events.name.arena());
+    BOOST_CHECK((std::vector<size_t>{ 0, 1 }) == events.name.offsets());
+
+    Events unthrown;
+    parser = Parser(json.data(), json.data() + json.size());
+    parser.throw_errors(false);
+    read_events(parser, &unthrown);
+    BOOST_CHECK_EQUAL((int)ParseErrorCode::INVALID_NUMBER, (int)parser.result().code);
+    check_rows(unthrown, 1);
+
+    // a reader without columns
+    struct Empty {};
+    static const auto empty_reader = ColumnarReader<Empty, IgnoreUnknown>();
+    Empty empty;
+    std::string rows = "[{}, {\"a\": 1}]";
+    parser = Parser(rows.data(), rows.data() + rows.size());
+    empty_reader.read(parser, &empty);
+    BOOST_CHECK_EQUAL(Token::END, parser.next().type);
+}
+
+BOOST_AUTO_TEST_CASE(read_func)
+{
+    struct Readings
+    {
+        Column<Level> level;
+        Column<int> count;
+    };
+    static const auto reader = ColumnarReader<Readings>().
+        add<decltype(Readings::level), &Readings::level, read_level<Parser>>("level").
+        add<decltype(Readings::count), &Readings::count>("count");
+    Readings readings;
+    std::string parser_json = "[{\"level\": \"high\", \"count\": 2}, {\"level\": null}, {\"level\": \"low\", \"count\": 1}]";
+    Parser parser(parser_json.data(), parser_json.data() + parser_json.size());
+    reader.read(parser, &readings);
+    BOOST_CHECK_EQUAL(3U, readings.level.size());
+    BOOST_CHECK(readings.level[0] == Level::HIGH);
+    BOOST_CHECK(!readings.level.present(1));
+    BOOST_CHECK(readings.level[2] == Level::LOW);
+    BOOST_CHECK(!readings.count.present(1));
+    BOOST_CHECK_EQUAL(1, readings.count[2]);
+}
+
+BOOST_AUTO_TEST_CASE(cbor)
+{
+    CborWriter<> writer;
+    writer.start_arr();
+    writer.start_obj();
+    writer.prop("id", 7);
+    writer.prop("name", "seven");
+    writer.key("value");
+    writer.null();
+    writer.end_obj();
+    writer.start_obj();
+    writer.prop("ok", true);
+    writer.key("id");
+    writer.null();
+    writer.end_obj();
+    writer.end_arr();
+
+    Events events;
+    auto data = writer.str();
+    CborParser<> parser(data.data(), data.data() + data.size());
+    read_events(parser, &events);
+    BOOST_CHECK_EQUAL(2U, events.id.size());
+    BOOST_CHECK_EQUAL(7, events.id[0]);
+    BOOST_CHECK(!events.id.present(1));
+    BOOST_CHECK_EQUAL("seven", events.name[0]);
+    BOOST_CHECK(!events.name.present(1));
+    BOOST_CHECK(!events.value.present(0));
+    BOOST_CHECK(events.ok[1]);
+    BOOST_CHECK(events.ok.present(1));
+    BOOST_CHECK(!events.ok.present(0));
+    BOOST_CHECK_EQUAL(Token::END, parser.next().type);
+}
+
+BOOST_AUTO_TEST_CASE(try_next_null)
+{
+    std::string parser_json = "[ null , 1]";
+    Parser parser(parser_json.data(), parser_json.data() + parser_json.size());
+    BOOST_CHECK_EQUAL(Token::ARR_START, parser.next().type);
+    BOOST_CHECK(parser.try_next_null());
+    BOOST_CHECK_EQUAL(Token::ELEMENT_SEP, parser.next().type);
+    BOOST_CHECK(!parser.try_next_null());
+    int x = 0;
+    read_json(parser, &x);
+    BOOST_CHECK_EQUAL(1, x);
+    BOOST_CHECK_EQUAL(Token::ARR_END, parser.next().type);
+    BOOST_CHECK_EQUAL(Token::END, parser.next().type);
+
+    CborWriter<> writer;
+    writer.start_arr();
+    writer.null();
+    writer.value(1);
+    writer.end_arr();
+    auto data = writer.str();
+    CborParser<> cbor(data.data(), data.data() + data.size());
+    BOOST_CHECK_EQUAL(Token::ARR_START, cbor.next().type);
+    BOOST_CHECK(cbor.try_next_null());
+    BOOST_CHECK_EQUAL(Token::ELEMENT_SEP, cbor.next().type);
+    BOOST_CHECK(!cbor.try_next_null());
+    read_json(cbor, &x);
+    BOOST_CHECK_EQUAL(1, x);
+    BOOST_CHECK_EQUAL(Token::ARR_END, cbor.next().type);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
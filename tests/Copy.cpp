@@ -51,5 +51,72 @@ BOOST_AUTO_TEST_CASE(primitives)
 
 }
 
+BOOST_AUTO_TEST_CASE(numbers)
+{
+    // numbers are copied from their text, so are exact and never overflow
+    BOOST_CHECK_EQUAL("[12345678901234567890123,-0.1000,1E+5,1.5e-3]",
+        do_copy("[12345678901234567890123, -0.1000, 1E+5, 1.5e-3]"));
+    BOOST_CHECK_THROW(do_copy("1."), ParseError);
+    BOOST_CHECK_THROW(do_copy("1e"), ParseError);
+    BOOST_CHECK_THROW(do_copy("-"), ParseError);
+    BOOST_CHECK_THROW(do_copy("-x"), ParseError);
+    BOOST_CHECK_THROW(do_copy("01"), ParseError);
+    BOOST_CHECK_THROW(do_copy("-01"), ParseError);
+    BOOST_CHECK_THROW(do_copy("[01, -00.5, 007e1]"), ParseError);
+    BOOST_CHECK_EQUAL("[0,-0,0.5,-0.5,0e1]", do_copy("[0, -0, 0.5, -0.5, 0e1]"));
+}
+
+BOOST_AUTO_TEST_CASE(nested)
+{
+    BOOST_CHECK_EQUAL("{\"a\":[1,{\"b\":{}},[]],\"c\":{\"d\":[[true]]}}",
+        do_copy("{\"a\": [1, {\"b\": {}}, []], \"c\": {\"d\": [[true]]}}"));
+    BOOST_CHECK_THROW(do_copy("[}"), ParseError);
+    BOOST_CHECK_THROW(do_copy("{\"a\": [1}"), ParseError);
+    BOOST_CHECK_THROW(do_copy("[{\"a\": 1]"), ParseError);
+    BOOST_CHECK_THROW(do_copy("[{5: 1}]"), ParseError);
+}
+
+BOOST_AUTO_TEST_CASE(depth)
+{
+    auto nested = [](size_t depth) { return std::string(depth, '[') + std::string(depth, ']'); };
+    BOOST_CHECK_EQUAL(nested(DEFAULT_MAX_DEPTH), do_copy(nested(DEFAULT_MAX_DEPTH)));
+    BOOST_CHECK_EQUAL(70U * 2, do_copy(nested(70)).size()); // more than one word of levels
+    try
+    {
+        do_copy(nested(100000));
+        BOOST_FAIL("Expected ParseError");
+    }
+    catch (const ParseError &e)
+    {
+        BOOST_CHECK(ParseErrorCode::DEPTH_EXCEEDED == e.code());
+    }
+
+    std::string src = "[{\"a\": [1]}]";
+    Writer writer;
+    Parser parser(src.data(), src.data() + src.size());
+    parser.max_depth(2);
+    BOOST_CHECK_THROW(copy(writer, parser), ParseError);
+}
+
+BOOST_AUTO_TEST_CASE(no_throw)
+{
+    auto error = [](const std::string &src)
+    {
+        Writer writer;
+        Parser parser(src.data(), src.data() + src.size());
+        parser.throw_errors(false);
+        copy(writer, parser);
+        return parser.result().code;
+    };
+    BOOST_CHECK(ParseErrorCode::NONE == error("{\"a\": [1, 2]}"));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_ARRAY_END == error("[1 2]"));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_OBJECT_END == error("{\"a\": 1 2}"));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_KEY_SEP == error("{\"a\" 1}"));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_STRING == error("{5: 1}"));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_STRING == error("{\"a\": 1, }"));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_VALUE == error("[1,]"));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_VALUE == error("[1,"));
+    BOOST_CHECK(ParseErrorCode::DEPTH_EXCEEDED == error(std::string(100000, '[')));
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,94 @@
+#include <boost/test/unit_test.hpp>
+#include "Cbor.hpp"
+#include "Enum.hpp"
+#include <vector>
+
+using namespace json;
+
+BOOST_AUTO_TEST_SUITE(TestEnum)
+
+namespace
+{
+    enum class Status { ACTIVE, SUSPENDED, CLOSED, UNKNOWN = 1000 };
+    const EnumTable<Status> status_names = {
+        { "active", Status::ACTIVE },
+        { "suspended", Status::SUSPENDED },
+        { "closed", Status::CLOSED },
+        { "unknown", Status::UNKNOWN },
+        { "deleted", Status::CLOSED } // alias, only used for reading
+    };
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, Status *val)
+    {
+        read_json_enum(parser, val, status_names);
+    }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, Status val)
+    {
+        write_json_enum(writer, val, status_names);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(table)
+{
+    Status status;
+    BOOST_CHECK(status_names.find("suspended", &status));
+    BOOST_CHECK(Status::SUSPENDED == status);
+    BOOST_CHECK(status_names.find("deleted", &status));
+    BOOST_CHECK(Status::CLOSED == status);
+    BOOST_CHECK(status_names.find("unknown", &status));
+    BOOST_CHECK(Status::UNKNOWN == status);
+    BOOST_CHECK(!status_names.find("Active", &status));
+    BOOST_CHECK(!status_names.find("", &status));
+    BOOST_CHECK(!status_names.find("activ", &status));
+    BOOST_CHECK_EQUAL("closed", *status_names.name(Status::CLOSED));
+    BOOST_CHECK_EQUAL("\"unknown\"", *status_names.quoted(Status::UNKNOWN));
+    BOOST_CHECK(!status_names.name((Status)5));
+
+    // names that only differ in the middle, which the sampled hash does not see
+    std::vector<std::string> names;
+    for (int i = 0; i < 300; ++i) names.push_back("x" + std::to_string(i * 7919) + "____" + std::to_string(i % 10));
+    EnumTable<int> many = {
+        { names[0].c_str(), 0 }, { names[1].c_str(), 1 }, { names[2].c_str(), 2 }, { names[3].c_str(), 3 },
+        { names[10].c_str(), 10 }, { names[11].c_str(), 11 }, { names[12].c_str(), 12 }, { names[20].c_str(), 20 },
+        { names[100].c_str(), 100 }, { names[110].c_str(), 110 }, { names[120].c_str(), 120 }, { names[200].c_str(), 200 }
+    };
+    int x;
+    for (int i : { 0, 1, 2, 3, 10, 11, 12, 20, 100, 110, 120, 200 })
+    {
+        BOOST_CHECK(many.find(names[(size_t)i], &x));
+        BOOST_CHECK_EQUAL(i, x);
+    }
+    BOOST_CHECK(!many.find(names[4], &x));
+
+    BOOST_CHECK_THROW(EnumTable<int>({ { "a", 1 }, { "a", 2 } }), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(read_write)
+{
+    auto statuses = json::read_json<std::vector<Status>>("[\"active\", \"closed\", \"deleted\", \"sus\\u0070ended\", \"unknown\"]");
+    BOOST_REQUIRE_EQUAL(5U, statuses.size());
+    BOOST_CHECK(Status::CLOSED == statuses[2]);
+    BOOST_CHECK(Status::SUSPENDED == statuses[3]);
+    BOOST_CHECK(Status::UNKNOWN == statuses[4]);
+    BOOST_CHECK_EQUAL("[\"active\",\"closed\",\"closed\",\"suspended\",\"unknown\"]", to_json(statuses));
+
+    auto cbor = to_cbor(statuses);
+    BOOST_CHECK(statuses == read_cbor<std::vector<Status>>(cbor));
+
+    BOOST_CHECK_THROW(to_json((Status)7), std::invalid_argument);
+
+    Status status;
+    auto result = try_read_json("\"open\"", &status);
+    BOOST_CHECK(ParseErrorCode::UNKNOWN_ENUM == result.code);
+    BOOST_CHECK(ParseErrorCode::EXPECTED_STRING == try_read_json("1", &status).code);
+    try
+    {
+        json::read_json<Status>("\"open\"");
+        BOOST_FAIL("Expected ParseError");
+    }
+    catch (const ParseError &e)
+    {
+        BOOST_CHECK_EQUAL("1:6 Unknown enum value open", e.what());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
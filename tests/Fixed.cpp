@@ -0,0 +1,152 @@
+#include <boost/test/unit_test.hpp>
+#include "Fixed.hpp"
+#include "Cbor.hpp"
+
+using namespace json;
+
+BOOST_AUTO_TEST_SUITE(TestFixed)
+
+namespace
+{
+    struct Order
+    {
+        FixedString<8> symbol;
+        char venue[5];
+        std::array<int, 2> range;
+        FixedVector<FixedString<4>, 3> tags;
+    };
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, Order *val)
+    {
+        static const auto reader = ObjectFieldReader<Order, ErrorUnknown, ParserT>().
+            template add<decltype(Order::symbol), &Order::symbol>("symbol").
+            template add<decltype(Order::venue), &Order::venue>("venue").
+            template add<decltype(Order::range), &Order::range>("range").
+            template add<decltype(Order::tags), &Order::tags>("tags");
+        reader.read(parser, val);
+    }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const Order &val)
+    {
+        writer.start_obj();
+        writer.prop("symbol", val.symbol);
+        writer.prop("venue", val.venue);
+        writer.prop("range", val.range);
+        writer.prop("tags", val.tags);
+        writer.end_obj();
+    }
+
+    ParseErrorCode error(const std::string &json)
+    {
+        Order order;
+        return try_read_json(json, &order).code;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(fixed_string)
+{
+    FixedString<4> str;
+    str += 'a';
+    str.append("bc", 2);
+    BOOST_CHECK(str == "abc");
+    BOOST_CHECK(!str.overflowed());
+    str.append("de", 2);
+    BOOST_CHECK(str == "abcd");
+    BOOST_CHECK_EQUAL(4U, str.size());
+    BOOST_CHECK_EQUAL("abcd", str.c_str());
+    BOOST_CHECK(str.overflowed());
+    str.clear();
+    BOOST_CHECK(str.empty());
+    BOOST_CHECK(!str.overflowed());
+    BOOST_CHECK_THROW(FixedString<2>("abc"), std::length_error);
+
+    BOOST_CHECK(json::read_json<FixedString<5>>("\"\\u00e9t\\u00e9\"") == "\xC3\xA9t\xC3\xA9");
+    BOOST_CHECK(ParseErrorCode::CAPACITY_EXCEEDED == try_read_json("\"hello\"", &str).code);
+    BOOST_CHECK_EQUAL("\"a\\nb\"", to_json(FixedString<4>("a\nb")));
+    auto nul = json::read_json<FixedString<4>>("\"a\\u0000b\"");
+    BOOST_CHECK_EQUAL(3U, nul.size());
+    BOOST_CHECK_EQUAL("\"a\\u0000b\"", to_json(nul));
+    BOOST_CHECK(nul == json::read_cbor<FixedString<4>>(to_cbor(nul)).str_view());
+}
+
+BOOST_AUTO_TEST_CASE(fixed_vector)
+{
+    FixedVector<std::string, 2> vec;
+    vec.push_back("a");
+    vec.emplace_back(2, 'b');
+    BOOST_CHECK(vec.full());
+    BOOST_CHECK_THROW(vec.push_back("c"), std::length_error);
+    auto copy = vec;
+    BOOST_CHECK_EQUAL("bb", copy[1]);
+    BOOST_CHECK_EQUAL("[\"a\",\"bb\"]", to_json(copy));
+    copy.pop_back();
+    BOOST_CHECK_EQUAL(1U, copy.size());
+
+    FixedVector<int, 3> ints;
+    BOOST_CHECK(try_read_json("[1, 2, 3]", &ints));
+    BOOST_CHECK_EQUAL(3, ints.back());
+    ints.clear();
+    auto result = try_read_json("[1, 2, 3, 4]", &ints);
+    BOOST_CHECK(ParseErrorCode::CAPACITY_EXCEEDED == result.code);
+    BOOST_CHECK_EQUAL(9U, result.offset);
+    BOOST_CHECK_EQUAL(3U, ints.size());
+}
+
+BOOST_AUTO_TEST_CASE(std_array)
+{
+    auto arr = json::read_json<std::array<int, 3>>("[1, 2, 3]");
+    BOOST_CHECK_EQUAL(2, arr[1]);
+    BOOST_CHECK_EQUAL("[1,2,3]", to_json(arr));
+    BOOST_CHECK(ParseErrorCode::CAPACITY_EXCEEDED == try_read_json("[1, 2, 3, 4]", &arr).code);
+    BOOST_CHECK(ParseErrorCode::EXPECTED_VALUE == try_read_json("[1, 2]", &arr).code);
+    BOOST_CHECK(ParseErrorCode::EXPECTED_VALUE == try_read_json("[]", &arr).code);
+    BOOST_CHECK(ParseErrorCode::EXPECTED_ARRAY_END == try_read_json("[1, 2 3]", &arr).code);
+    std::array<int, 0> empty;
+    BOOST_CHECK(try_read_json("[]", &empty));
+    BOOST_CHECK(ParseErrorCode::CAPACITY_EXCEEDED == try_read_json("[1]", &empty).code);
+}
+
+BOOST_AUTO_TEST_CASE(char_array)
+{
+    char buf[4];
+    BOOST_CHECK(try_read_json("\"abc\"", &buf));
+    BOOST_CHECK_EQUAL("abc", buf);
+    BOOST_CHECK(ParseErrorCode::CAPACITY_EXCEEDED == try_read_json("\"abcd\"", &buf).code);
+    BOOST_CHECK_EQUAL("abc", buf);
+    BOOST_CHECK_EQUAL("\"abc\"", to_json(buf));
+}
+
+BOOST_AUTO_TEST_CASE(object)
+{
+    const std::string json = "{\"symbol\": \"ABC\", \"venue\": \"XLON\", \"range\": [1, 5], \"tags\": [\"a\", \"bc\"]}";
+    Order order;
+    BOOST_REQUIRE(try_read_json(json, &order));
+    BOOST_CHECK(order.symbol == "ABC");
+    BOOST_CHECK_EQUAL("XLON", order.venue);
+    BOOST_CHECK_EQUAL(5, order.range[1]);
+    BOOST_REQUIRE_EQUAL(2U, order.tags.size());
+    BOOST_CHECK(order.tags[1] == "bc");
+    auto written = to_json(order);
+    BOOST_CHECK_EQUAL("{\"symbol\":\"ABC\",\"venue\":\"XLON\",\"range\":[1,5],\"tags\":[\"a\",\"bc\"]}", written);
+
+    // the same from CBOR
+    Order decoded;
+    read_cbor(to_cbor(order), &decoded);
+    BOOST_CHECK(decoded.symbol == "ABC");
+    BOOST_CHECK_EQUAL("XLON", decoded.venue);
+    BOOST_CHECK(decoded.tags[0] == "a");
+
+    BOOST_CHECK(ParseErrorCode::CAPACITY_EXCEEDED == error(
+        "{\"symbol\": \"ABCDEFGHI\", \"venue\": \"XLON\", \"range\": [1, 5], \"tags\": []}"));
+    BOOST_CHECK(ParseErrorCode::CAPACITY_EXCEEDED == error(
+        "{\"symbol\": \"ABC\", \"venue\": \"XLONX\", \"range\": [1, 5], \"tags\": []}"));
+    BOOST_CHECK(ParseErrorCode::CAPACITY_EXCEEDED == error(
+        "{\"symbol\": \"ABC\", \"venue\": \"XLON\", \"range\": [1, 5], \"tags\": [\"a\", \"b\", \"c\", \"d\"]}"));
+    BOOST_CHECK(ParseErrorCode::CAPACITY_EXCEEDED == error(
+        "{\"symbol\": \"ABC\", \"venue\": \"XLON\", \"range\": [1, 5], \"tags\": [\"abcde\"]}"));
+    CborWriter<> long_symbol;
+    long_symbol.start_obj();
+    long_symbol.prop("symbol", "ABCDEFGHI");
+    long_symbol.end_obj();
+    BOOST_CHECK_THROW(read_cbor<Order>(long_symbol.str()), ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
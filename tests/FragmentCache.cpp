@@ -0,0 +1,103 @@
+#include <boost/test/unit_test.hpp>
+#include "FragmentCache.hpp"
+
+using namespace json;
+
+BOOST_AUTO_TEST_SUITE(TestFragmentCache)
+
+namespace
+{
+    struct Profile
+    {
+        std::string name;
+        int age;
+    };
+    template<class Writer> if_writer<Writer> write_json(Writer &writer, const Profile &profile)
+    {
+        writer.start_obj();
+        writer.prop("name", profile.name);
+        writer.prop("age", profile.age);
+        writer.end_obj();
+    }
+    struct Wrapper
+    {
+        Profile profile;
+    };
+    template<class Writer> if_writer<Writer> write_json(Writer &writer, const Wrapper &wrapper)
+    {
+        writer.start_obj();
+        writer.key("wrapped");
+        write_json(writer, wrapper.profile);
+        writer.end_obj();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(write)
+{
+    FragmentCache cache;
+    Profile a = { "Alice", 30 }, b = { "Bob", 40 };
+
+    Writer writer;
+    writer.start_arr();
+    cache.write(writer, a, 1);
+    cache.write(writer, b, 1);
+    cache.write(writer, a, 1);
+    writer.end_arr();
+    BOOST_CHECK_EQUAL(
+        "[{\"name\":\"Alice\",\"age\":30},{\"name\":\"Bob\",\"age\":40},{\"name\":\"Alice\",\"age\":30}]",
+        writer.str());
+    BOOST_CHECK_EQUAL(2U, cache.misses());
+    BOOST_CHECK_EQUAL(1U, cache.hits());
+    BOOST_CHECK_EQUAL(2U, cache.size());
+    BOOST_CHECK_EQUAL(48U, cache.bytes());
+
+    // stale until the version changes
+    a.age = 31;
+    BOOST_CHECK_EQUAL("{\"name\":\"Alice\",\"age\":30}", cache.get(a, 1));
+    BOOST_CHECK_EQUAL("{\"name\":\"Alice\",\"age\":31}", cache.get(a, 2));
+    BOOST_CHECK_EQUAL(2U, cache.size());
+
+    a.age = 32;
+    cache.invalidate(a);
+    BOOST_CHECK_EQUAL(1U, cache.size());
+    BOOST_CHECK_EQUAL("{\"name\":\"Alice\",\"age\":32}", cache.get(a, 2));
+
+    // same address, different type
+    Wrapper wrapper = { a };
+    BOOST_CHECK_EQUAL("{\"wrapped\":{\"name\":\"Alice\",\"age\":32}}", cache.get(wrapper, 2));
+    BOOST_CHECK_EQUAL("{\"name\":\"Alice\",\"age\":32}", cache.get(wrapper.profile, 2));
+
+    cache.clear();
+    BOOST_CHECK_EQUAL(0U, cache.size());
+    BOOST_CHECK_EQUAL(0U, cache.bytes());
+}
+
+BOOST_AUTO_TEST_CASE(max_bytes)
+{
+    Profile profiles[4] = { { "A", 1 }, { "B", 2 }, { "C", 3 }, { "D", 4 } };
+    // each is 20 bytes
+    FragmentCache cache(50);
+    cache.get(profiles[0], 0);
+    cache.get(profiles[1], 0);
+    cache.get(profiles[0], 0); // B is now least recently used
+    cache.get(profiles[2], 0);
+    BOOST_CHECK_EQUAL(2U, cache.size());
+    BOOST_CHECK_EQUAL(40U, cache.bytes());
+
+    cache.get(profiles[0], 0);
+    cache.get(profiles[2], 0);
+    BOOST_CHECK_EQUAL(3U, cache.hits());
+    cache.get(profiles[1], 0);
+    BOOST_CHECK_EQUAL(4U, cache.misses());
+
+    // an entry larger than the limit is still returned, but then evicted by the next
+    cache.max_bytes(10);
+    BOOST_CHECK_EQUAL(0U, cache.size());
+    BOOST_CHECK_EQUAL("{\"name\":\"D\",\"age\":4}", cache.get(profiles[3], 0));
+    BOOST_CHECK_EQUAL(1U, cache.size());
+    cache.get(profiles[2], 0);
+    BOOST_CHECK_EQUAL(1U, cache.size());
+    BOOST_CHECK_EQUAL(20U, cache.bytes());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,117 @@
+#include <boost/test/unit_test.hpp>
+#include "Cbor.hpp"
+#include "InternTable.hpp"
+#include <vector>
+
+using namespace json;
+
+BOOST_AUTO_TEST_SUITE(TestInternTable)
+
+namespace
+{
+    struct Record
+    {
+        int id;
+        InternedString country;
+    };
+    template<typename ParserT> if_parser<ParserT> read_json(ParserT &parser, Record *val)
+    {
+        static const auto reader = ObjectFieldReader<Record, ErrorUnknown, ParserT>().
+            template add<decltype(Record::id), &Record::id>("id").
+            template add<decltype(Record::country), &Record::country>("country");
+        reader.read(parser, val);
+    }
+    template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const Record &val)
+    {
+        writer.start_obj();
+        writer.prop("id", val.id);
+        writer.prop("country", val.country);
+        writer.end_obj();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(intern)
+{
+    InternTable table;
+    auto a = table.intern("GB");
+    auto b = table.intern(std::string("GB"));
+    auto c = table.intern("US", 2);
+    BOOST_CHECK(a == b);
+    BOOST_CHECK(&a.str() == &b.str());
+    BOOST_CHECK(a != c);
+    BOOST_CHECK(a == "GB");
+    BOOST_CHECK_EQUAL("US", c.str());
+    BOOST_CHECK_EQUAL(2U, table.size());
+    BOOST_CHECK_EQUAL(4U, table.bytes());
+
+    BOOST_CHECK(table.intern("") == InternedString());
+    BOOST_CHECK_EQUAL(2U, table.size());
+
+    // written with the stored length, so null characters are kept
+    InternTable nul_table;
+    BOOST_CHECK_EQUAL("\"a\\u0000b\"", to_json(nul_table.intern("a\0b", 3)));
+
+    bool found;
+    BOOST_CHECK(table.find("US", &found) == c);
+    BOOST_CHECK(found);
+    table.find("FR", &found);
+    BOOST_CHECK(!found);
+    BOOST_CHECK_EQUAL(2U, table.size());
+
+    // strings stay in place as more are added
+    auto first = &a.str();
+    for (int i = 0; i < 1000; ++i) table.intern(std::to_string(i));
+    BOOST_CHECK(first == &table.intern("GB").str());
+
+    table.clear();
+    BOOST_CHECK_EQUAL(0U, table.size());
+    BOOST_CHECK_EQUAL(0U, table.bytes());
+}
+
+BOOST_AUTO_TEST_CASE(read)
+{
+    const std::string json =
+        "[{\"id\": 1, \"country\": \"GB\"}, {\"id\": 2, \"country\": \"US\"},"
+        " {\"id\": 3, \"country\": \"G\\u0042\"}, {\"id\": 4, \"country\": \"\"}]";
+    InternTable table;
+    Parser parser(json.data(), json.data() + json.size());
+    parser.intern_table(&table);
+    std::vector<Record> records;
+    json::read_json(parser, &records);
+    BOOST_REQUIRE_EQUAL(4U, records.size());
+    BOOST_CHECK(records[0].country == "GB");
+    BOOST_CHECK(records[0].country == records[2].country);
+    BOOST_CHECK(records[1].country == "US");
+    BOOST_CHECK(records[3].country.empty());
+    BOOST_CHECK_EQUAL(2U, table.size());
+
+    Writer writer;
+    writer.value(records);
+    BOOST_CHECK_EQUAL(
+        "[{\"id\":1,\"country\":\"GB\"},{\"id\":2,\"country\":\"US\"},"
+        "{\"id\":3,\"country\":\"GB\"},{\"id\":4,\"country\":\"\"}]",
+        writer.str());
+
+    // CBOR gets the same handles
+    auto cbor = to_cbor(records);
+    CborParser<> cbor_parser(cbor.data(), cbor.data() + cbor.size());
+    cbor_parser.intern_table(&table);
+    std::vector<Record> decoded;
+    json::read_json(cbor_parser, &decoded);
+    BOOST_REQUIRE_EQUAL(4U, decoded.size());
+    BOOST_CHECK(decoded[2].country == records[0].country);
+    BOOST_CHECK_EQUAL(2U, table.size());
+
+    // errors
+    Parser no_table(json.data(), json.data() + json.size());
+    BOOST_CHECK_THROW(json::read_json(no_table, &records), std::logic_error);
+    const std::string invalid = "{\"id\": 1, \"country\": 5}";
+    Parser invalid_parser(invalid.data(), invalid.data() + invalid.size());
+    invalid_parser.intern_table(&table);
+    invalid_parser.throw_errors(false);
+    Record record;
+    read_json(invalid_parser, &record);
+    BOOST_CHECK(ParseErrorCode::EXPECTED_STRING == invalid_parser.result().code);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
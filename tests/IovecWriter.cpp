@@ -0,0 +1,104 @@
+#include <boost/test/unit_test.hpp>
+#include "IovecWriter.hpp"
+#include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace json;
+
+BOOST_AUTO_TEST_SUITE(TestIovecWriter)
+
+BOOST_AUTO_TEST_CASE(segments)
+{
+    std::string blob(5000, 'x');
+    blob[2000] = '"';
+    std::string fragment = "{\"cached\":[" + std::string(1500, '1') + "]}";
+
+    IovecWriter writer;
+    writer.start_obj();
+    writer.key("blob");
+    writer.str_value_ref(blob);
+    writer.key("fragment");
+    writer.raw_value_ref(fragment);
+    writer.key("small");
+    writer.str_value_ref("a\nb");
+    writer.end_obj();
+
+    Writer expected;
+    expected.start_obj();
+    expected.prop("blob", blob);
+    expected.key("fragment");
+    expected.raw_value(fragment);
+    expected.prop("small", "a\nb");
+    expected.end_obj();
+
+    auto &buf = writer.str();
+    BOOST_CHECK_EQUAL(expected.str(), buf.str());
+    BOOST_CHECK_EQUAL(expected.str().size(), buf.size());
+
+    // the long runs of the blob either side of the escaped '"', and the fragment, are referenced
+    auto segs = buf.segments();
+    std::vector<const char*> refs;
+    for (auto &seg : segs)
+    {
+        if (seg.data >= blob.data() && seg.data < blob.data() + blob.size()) refs.push_back(seg.data);
+        if (seg.data == fragment.data()) refs.push_back(seg.data);
+    }
+    BOOST_CHECK_EQUAL(3, refs.size());
+
+    // everything is copied into a normal Writer
+    Writer copied;
+    copied.str_value_ref(blob);
+    BOOST_CHECK_EQUAL(to_json(blob), copied.str());
+}
+
+BOOST_AUTO_TEST_CASE(min_ref_size)
+{
+    std::string fragment = "[1,2,3]";
+    IovecWriter writer;
+    writer.str().min_ref_size(4);
+    writer.start_arr();
+    writer.raw_value_ref(fragment);
+    writer.raw_value_ref("[]");
+    writer.end_arr();
+    BOOST_CHECK_EQUAL("[[1,2,3],[]]", writer.str().str());
+    auto segs = writer.str().segments();
+    BOOST_CHECK_EQUAL(3, segs.size());
+    if (segs.size() == 3) BOOST_CHECK(segs[1].data == fragment.data());
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(write_to)
+{
+    std::string blob(100000, 'b');
+    IovecWriter writer;
+    writer.start_arr();
+    for (int i = 0; i < 3; ++i) writer.str_value_ref(blob);
+    writer.end_arr();
+    auto expected = writer.str().str();
+
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(0, pipe(fds));
+    std::string received;
+    // the output is larger than a pipe buffer, so read it while writing to test partial writes
+    pid_t pid = fork();
+    BOOST_REQUIRE(pid >= 0);
+    if (pid == 0)
+    {
+        close(fds[0]);
+        writer.str().write_to(fds[1]);
+        _exit(0);
+    }
+    close(fds[1]);
+    char buffer[4096];
+    ssize_t len;
+    while ((len = read(fds[0], buffer, sizeof(buffer))) > 0) received.append(buffer, (size_t)len);
+    close(fds[0]);
+    BOOST_CHECK(expected == received);
+
+    BOOST_CHECK_THROW(writer.str().write_to(-1), std::system_error);
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,80 @@
+#include <boost/test/unit_test.hpp>
+#include "Cbor.hpp"
+#include "MergePatch.hpp"
+
+using namespace json;
+
+BOOST_AUTO_TEST_SUITE(TestMergePatch)
+
+namespace
+{
+    std::string patch(const std::string &doc, const std::string &patch)
+    {
+        return apply_merge_patch(doc, MergePatch(patch));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(rfc7386_examples)
+{
+    // RFC 7386 Appendix A
+    BOOST_CHECK_EQUAL("{\"a\":\"c\"}", patch("{\"a\":\"b\"}", "{\"a\":\"c\"}"));
+    BOOST_CHECK_EQUAL("{\"a\":\"b\",\"b\":\"c\"}", patch("{\"a\":\"b\"}", "{\"b\":\"c\"}"));
+    BOOST_CHECK_EQUAL("{}", patch("{\"a\":\"b\"}", "{\"a\":null}"));
+    BOOST_CHECK_EQUAL("{\"b\":\"c\"}", patch("{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":null}"));
+    BOOST_CHECK_EQUAL("{\"a\":\"c\"}", patch("{\"a\":[\"b\"]}", "{\"a\":\"c\"}"));
+    BOOST_CHECK_EQUAL("{\"a\":[\"b\"]}", patch("{\"a\":\"c\"}", "{\"a\":[\"b\"]}"));
+    BOOST_CHECK_EQUAL("{\"a\":{\"b\":\"d\"}}",
+        patch("{\"a\": {\"b\": \"c\"}}", "{\"a\": {\"b\": \"d\", \"c\": null}}"));
+    BOOST_CHECK_EQUAL("{\"a\":[1]}", patch("{\"a\": [{\"b\":\"c\"}]}", "{\"a\": [1]}"));
+    BOOST_CHECK_EQUAL("[\"c\",\"d\"]", patch("[\"a\",\"b\"]", "[\"c\",\"d\"]"));
+    BOOST_CHECK_EQUAL("[\"c\"]", patch("{\"a\":\"b\"}", "[\"c\"]"));
+    BOOST_CHECK_EQUAL("null", patch("{\"a\":\"foo\"}", "null"));
+    BOOST_CHECK_EQUAL("\"bar\"", patch("{\"a\":\"foo\"}", "\"bar\""));
+    BOOST_CHECK_EQUAL("{\"e\":null,\"a\":1}", patch("{\"e\":null}", "{\"a\":1}"));
+    BOOST_CHECK_EQUAL("{\"a\":{\"bb\":{}}}", patch("[1,2]", "{\"a\":{\"bb\":{\"ccc\":null}}}"));
+    BOOST_CHECK_EQUAL("{\"a\":{\"bb\":{}}}", patch("{}", "{\"a\":{\"bb\":{\"ccc\":null}}}"));
+}
+
+BOOST_AUTO_TEST_CASE(streaming)
+{
+    // untouched members are copied as their input text, new ones are appended
+    const std::string doc =
+        "{\"id\": 12345678901234567890, \"tags\": [\"a\", {\"b\": 1.50}], "
+        "\"profile\": {\"name\": \"Ben\", \"age\": 30, \"email\": \"ben@example.com\"}, \"x\": null}";
+    BOOST_CHECK_EQUAL(
+        "{\"id\":12345678901234567890,\"tags\":[\"a\", {\"b\": 1.50}],"
+        "\"profile\":{\"name\":\"Ben\",\"age\":31,\"phone\":\"555\\n\"},\"x\":null,\"added\":[1.0e3]}",
+        patch(doc, "{\"profile\": {\"age\": 31, \"email\": null, \"phone\": \"555\\n\"}, \"added\": [1.0e3], \"gone\": null}"));
+
+    // empty patch copies the document
+    BOOST_CHECK_EQUAL("{\"a\":[1, 2, {}]}", patch("{\"a\": [1, 2, {}]}", "{}"));
+
+    // JSON to CBOR
+    MergePatch p("{\"b\": 2, \"c\": {\"d\": true}}");
+    std::string json = "{\"a\": 1, \"b\": [1]}";
+    Parser parser(json.data(), json.data() + json.size());
+    CborWriter<> writer;
+    apply_merge_patch(writer, parser, p);
+    auto cbor = writer.str();
+    CborParser<> cbor_parser(cbor.data(), cbor.data() + cbor.size());
+    Writer json_writer;
+    copy(json_writer, cbor_parser);
+    BOOST_CHECK_EQUAL("{\"a\":1,\"b\":2,\"c\":{\"d\":true}}", json_writer.str());
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+    BOOST_CHECK_THROW(MergePatch("{\"a\": }"), ParseError);
+    BOOST_CHECK_THROW(MergePatch("{} 1"), ParseError);
+    BOOST_CHECK_THROW(patch("{\"a\": 1", "{\"b\": 1}"), ParseError);
+    BOOST_CHECK_THROW(patch("{\"a\": 1} 5", "{\"b\": 1}"), ParseError);
+    BOOST_CHECK_THROW(patch("", "{\"b\": 1}"), ParseError);
+    BOOST_CHECK_THROW(patch("[1, 2", "{\"b\": 1}"), ParseError);
+
+    std::string deep;
+    for (int i = 0; i < 100000; ++i) deep += "{\"a\":";
+    deep += "1" + std::string(100000, '}');
+    BOOST_CHECK_THROW(MergePatch{ deep }, ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
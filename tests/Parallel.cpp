@@ -0,0 +1,77 @@
+#include <boost/test/unit_test.hpp>
+#include "Parallel.hpp"
+#include <deque>
+#include <stdexcept>
+
+using namespace json;
+
+BOOST_AUTO_TEST_SUITE(TestParallel)
+
+namespace
+{
+    struct Item
+    {
+        int id;
+    };
+    template<class Writer> if_writer<Writer> write_json(Writer &writer, const Item &item)
+    {
+        if (item.id < 0) throw std::runtime_error("bad item");
+        writer.start_obj();
+        writer.prop("id", item.id);
+        writer.end_obj();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(to_json)
+{
+    for (size_t size : { 0, 1, 2, 7, 100, 1001 })
+    {
+        std::vector<Item> items;
+        for (size_t i = 0; i < size; ++i) items.push_back({ (int)i });
+        auto expected = json::to_json(items);
+        BOOST_CHECK_EQUAL(expected, to_json_parallel(items));
+        BOOST_CHECK_EQUAL(expected, to_json_parallel(items, 1));
+        BOOST_CHECK_EQUAL(expected, to_json_parallel(items, 4));
+        BOOST_CHECK_EQUAL(expected, to_json_parallel(items, 3, 1));
+        BOOST_CHECK_EQUAL(expected, to_json_parallel(items, 2, 64));
+    }
+
+    std::deque<std::string> strs = { "a", "b\n", "c" };
+    BOOST_CHECK_EQUAL("[\"a\",\"b\\n\",\"c\"]", to_json_parallel(strs, 2, 1));
+}
+
+BOOST_AUTO_TEST_CASE(sink)
+{
+    std::vector<int> values;
+    for (int i = 0; i < 10; ++i) values.push_back(i);
+
+    std::vector<std::string> chunks;
+    write_json_parallel(values, [&](const std::string &chunk) { chunks.push_back(chunk); }, 2, 4);
+    BOOST_REQUIRE_EQUAL(3U, chunks.size());
+    BOOST_CHECK_EQUAL("[0,1,2,3", chunks[0]);
+    BOOST_CHECK_EQUAL(",4,5,6,7", chunks[1]);
+    BOOST_CHECK_EQUAL(",8,9]", chunks[2]);
+
+    chunks.clear();
+    write_json_parallel(std::vector<int>(), [&](const std::string &chunk) { chunks.push_back(chunk); }, 2, 4);
+    BOOST_REQUIRE_EQUAL(1U, chunks.size());
+    BOOST_CHECK_EQUAL("[]", chunks[0]);
+
+    // an exception from the sink stops the workers
+    size_t calls = 0;
+    BOOST_CHECK_THROW(write_json_parallel(values, [&](const std::string &)
+    {
+        if (++calls == 2) throw std::runtime_error("sink failed");
+    }, 4, 1), std::runtime_error);
+    BOOST_CHECK_EQUAL(2U, calls);
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+    std::vector<Item> items;
+    for (int i = 0; i < 100; ++i) items.push_back({ i == 57 ? -1 : i });
+    BOOST_CHECK_THROW(to_json_parallel(items, 4, 5), std::runtime_error);
+    BOOST_CHECK_THROW(to_json_parallel(items, 1, 5), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -99,4 +99,332 @@ BOOST_AUTO_TEST_CASE(strings)
 
 }
 
+BOOST_AUTO_TEST_CASE(utf8)
+{
+    auto parse_utf8 = [](const std::string &str)
+    {
+        Parser parser(str.data(), str.data() + str.size());
+        parser.validate_utf8(true);
+        return parser.next();
+    };
+    auto skip_utf8 = [](const std::string &str)
+    {
+        Parser parser(str.data(), str.data() + str.size());
+        parser.validate_utf8(true);
+        parser.skip_next_str();
+    };
+    CHECK_BYTES_EQUAL(u8"\u00A3 \u2211 \U0010FFFF", parse_utf8(u8"\"\u00A3 \u2211 \U0010FFFF\"").str);
+    std::string ascii(100, 'x');
+    BOOST_CHECK_EQUAL(ascii, parse_utf8('"' + ascii + '"').str);
+    CHECK_BYTES_EQUAL(u8"\u00A3\n", parse_utf8("\"\\u00a3\\n\"").str);
+
+    // accepted as raw bytes unless enabled
+    BOOST_CHECK_NO_THROW(parse_single("\"\xC0\x80\""));
+    BOOST_CHECK_THROW(parse_utf8("\"\xC0\x80\""), ParseError); // overlong
+    BOOST_CHECK_THROW(parse_utf8("\"\xE0\x80\x80\""), ParseError); // overlong
+    BOOST_CHECK_THROW(parse_utf8("\"\xED\xA0\x80\""), ParseError); // surrogate
+    BOOST_CHECK_THROW(parse_utf8("\"\xF4\x90\x80\x80\""), ParseError); // > U+10FFFF
+    BOOST_CHECK_THROW(parse_utf8("\"\xE2\x88\""), ParseError); // truncated
+    BOOST_CHECK_THROW(parse_utf8("\"x\x80\""), ParseError); // continuation
+    BOOST_CHECK_THROW(parse_utf8('"' + ascii + "\xFF" + ascii + '"'), ParseError);
+    BOOST_CHECK_THROW(skip_utf8("\"\xC0\x80\""), ParseError);
+    BOOST_CHECK_NO_THROW(skip_utf8(u8"\"\u00A3\""));
+
+    try
+    {
+        parse_utf8("\"abc\xFF\"");
+        BOOST_FAIL("Expected ParseError");
+    }
+    catch (const ParseError &e)
+    {
+        BOOST_CHECK_EQUAL("1:4 Invalid UTF-8 in string", e.what());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(keys)
+{
+    {
+        std::string str = "{\"x\": 1, \"xy\" : 2, \"\\u0079\": 3, \"z\" 4}";
+        Parser parser(str.data(), str.data() + str.size());
+        parser.next_obj_start();
+        BOOST_CHECK(!parser.try_next_key("y"));
+        BOOST_CHECK(!parser.try_next_key("xy"));
+        BOOST_CHECK(!parser.try_next_key(""));
+        BOOST_CHECK(parser.try_next_key("x"));
+        BOOST_CHECK_EQUAL(1, parser.next_int<int>());
+        BOOST_CHECK(parser.next_obj_el());
+        BOOST_CHECK(!parser.try_next_key("x"));
+        BOOST_CHECK(parser.try_next_key("xy"));
+        BOOST_CHECK_EQUAL(2, parser.next_int<int>());
+        BOOST_CHECK(parser.next_obj_el());
+        // escaped keys are decoded
+        BOOST_CHECK(!parser.try_next_key("x"));
+        BOOST_CHECK(parser.try_next_key("y"));
+        BOOST_CHECK_EQUAL(3, parser.next_int<int>());
+        BOOST_CHECK(parser.next_obj_el());
+        BOOST_CHECK_THROW(parser.try_next_key("z"), ParseError); // no ':'
+    }
+    {
+        const KeyTable table = { "a", "bb", "c\"d", "" };
+        std::string str = "{\"bb\":1,\"a\":2,\"c\\\"d\":3,\"\":4,\"\\u0061\":5,\"unknown\\n\":6,\"b\":7}";
+        Parser parser(str.data(), str.data() + str.size());
+        parser.next_obj_start();
+        std::string unknown;
+        std::vector<size_t> indices;
+        do
+        {
+            indices.push_back(parser.next_key(table, &unknown));
+            parser.next_int<int>();
+        }
+        while (parser.next_obj_el());
+        std::vector<size_t> expected = { 1, 0, 2, 3, 0, KeyTable::npos, KeyTable::npos };
+        BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), indices.begin(), indices.end());
+        BOOST_CHECK_EQUAL("b", unknown);
+    }
+    {
+        const KeyTable table = { "a" };
+        std::string str = "{\"unknown\\n\": 1}";
+        Parser parser(str.data(), str.data() + str.size());
+        parser.next_obj_start();
+        std::string unknown;
+        BOOST_CHECK_EQUAL(KeyTable::npos, parser.next_key(table, &unknown));
+        BOOST_CHECK_EQUAL("unknown\n", unknown);
+    }
+    {
+        std::string str = "{\"a\xFF\": 1}";
+        Parser parser(str.data(), str.data() + str.size());
+        parser.validate_utf8(true);
+        parser.next_obj_start();
+        BOOST_CHECK_THROW(parser.next_key(KeyTable{ "a" }), ParseError);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(times)
+{
+    std::string str = "[\"2016-06-24T09:47:55Z\", \"2016-06-24T09:47:55.25+00:00\", \"2016\\u002d06-24T09:47:55Z\", \"2016-06-24\"]";
+    Parser parser(str.data(), str.data() + str.size());
+    parser.next();
+    BOOST_CHECK_EQUAL(1466761675, parser.next_time());
+    parser.next();
+    auto t = parser.next_time_point<std::chrono::milliseconds>();
+    BOOST_CHECK_EQUAL(1466761675250LL, t.time_since_epoch().count());
+    parser.next();
+    BOOST_CHECK_EQUAL(1466761675, parser.next_time()); // escaped
+    parser.next();
+    try
+    {
+        parser.next_time();
+        BOOST_FAIL("Expected ParseError");
+    }
+    catch (const ParseError &e)
+    {
+        BOOST_CHECK_EQUAL("1:86 Invalid time", e.what());
+    }
+
+    {
+        std::string num = "5";
+        Parser parser2(num.data(), num.data() + num.size());
+        BOOST_CHECK_THROW(parser2.next_time(), ParseError);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+    {
+        std::string str = "[1,\n  x]";
+        Parser parser(str.data(), str.data() + str.size());
+        parser.next();
+        parser.next();
+        parser.next();
+        try
+        {
+            parser.next();
+            BOOST_FAIL("Expected ParseError");
+        }
+        catch (const ParseError &e)
+        {
+            BOOST_CHECK(ParseErrorCode::UNEXPECTED_CONTENT == e.code());
+            BOOST_CHECK_EQUAL(2, e.line());
+            BOOST_CHECK_EQUAL(2, e.column());
+            BOOST_CHECK_EQUAL(6, e.offset());
+            BOOST_CHECK_EQUAL("2:2 Unexpected content", e.what());
+        }
+    }
+    {
+        // with throwing disabled the first error is kept, and the parser then acts as if at the end
+        std::string str = "[1,\n  x, \"a\", 5]";
+        Parser parser(str.data(), str.data() + str.size());
+        parser.throw_errors(false);
+        BOOST_CHECK_EQUAL(Token::ARR_START, parser.next().type);
+        BOOST_CHECK_EQUAL(Token::INTEGER, parser.next().type);
+        BOOST_CHECK_EQUAL(Token::ELEMENT_SEP, parser.next().type);
+        BOOST_CHECK(!parser.failed());
+        BOOST_CHECK_EQUAL(Token::END, parser.next().type);
+        BOOST_CHECK(parser.failed());
+        BOOST_CHECK_EQUAL(Token::END, parser.next().type);
+        BOOST_CHECK_EQUAL("", parser.next_str());
+        BOOST_CHECK_EQUAL(0, parser.next_int<int>());
+        BOOST_CHECK(!parser.next_obj_el());
+        BOOST_CHECK(parser.try_next_obj_end());
+
+        auto &result = parser.result();
+        BOOST_CHECK(!result);
+        BOOST_CHECK(ParseErrorCode::UNEXPECTED_CONTENT == result.code);
+        BOOST_CHECK_EQUAL(2, result.line);
+        BOOST_CHECK_EQUAL(2, result.column);
+        BOOST_CHECK_EQUAL(6, result.offset);
+        BOOST_CHECK_EQUAL("2:2 Unexpected content", result.message());
+    }
+
+    auto first_error = [](const std::string &str)
+    {
+        Parser parser(str.data(), str.data() + str.size());
+        parser.throw_errors(false);
+        while (parser.next().type != Token::END);
+        return parser.result().code;
+    };
+    BOOST_CHECK(ParseErrorCode::NONE == first_error("[1, \"a\", true]"));
+    BOOST_CHECK(ParseErrorCode::UNEXPECTED_CONTENT == first_error("[trux]"));
+    BOOST_CHECK(ParseErrorCode::UNEXPECTED_END == first_error("\"abc"));
+    BOOST_CHECK(ParseErrorCode::UNEXPECTED_END == first_error("\"abc\\"));
+    BOOST_CHECK(ParseErrorCode::INVALID_ESCAPE == first_error("\"\\u00x0\""));
+    BOOST_CHECK(ParseErrorCode::INVALID_ESCAPE == first_error("\"\\uDBFF\""));
+    BOOST_CHECK(ParseErrorCode::NONE == first_error("99999999999999999999"));
+    BOOST_CHECK(ParseErrorCode::INVALID_NUMBER == first_error("1e999"));
+    BOOST_CHECK(ParseErrorCode::UNEXPECTED_END == first_error("-"));
+}
+
+BOOST_AUTO_TEST_CASE(wide_numbers)
+{
+    // integers too large for a long long, with or without a fraction, are read as doubles
+    std::string str = "[12345678901234567890.5, 99999999999999999999, -9223372036854775808, 1e2]";
+    Parser parser(str.data(), str.data() + str.size());
+    BOOST_CHECK_EQUAL(Token::ARR_START, parser.next().type);
+    auto tok = parser.next();
+    BOOST_CHECK_EQUAL(Token::NUMBER, tok.type);
+    BOOST_CHECK_EQUAL(12345678901234567890.5, tok.val_num);
+    BOOST_CHECK_EQUAL(Token::ELEMENT_SEP, parser.next().type);
+    tok = parser.next();
+    BOOST_CHECK_EQUAL(Token::NUMBER, tok.type);
+    BOOST_CHECK_EQUAL(1e20, tok.val_num);
+    BOOST_CHECK_EQUAL(Token::ELEMENT_SEP, parser.next().type);
+    tok = parser.next();
+    BOOST_CHECK_EQUAL(Token::INTEGER, tok.type);
+    BOOST_CHECK_EQUAL(std::numeric_limits<long long>::min(), tok.val_int);
+    BOOST_CHECK_EQUAL(Token::ELEMENT_SEP, parser.next().type);
+    tok = parser.next();
+    BOOST_CHECK_EQUAL(Token::NUMBER, tok.type);
+    BOOST_CHECK_EQUAL(100.0, tok.val_num);
+    BOOST_CHECK_EQUAL(Token::ARR_END, parser.next().type);
+    BOOST_CHECK_EQUAL(Token::END, parser.next().type);
+}
+
+BOOST_AUTO_TEST_CASE(raw_numbers)
+{
+    std::string str = "[0, -12, 18446744073709551615, 18446744073709551616, -9223372036854775808, 1.5e3]";
+    Parser parser(str.data(), str.data() + str.size());
+    parser.raw_numbers(true);
+    long long i;
+    unsigned long long u;
+    double d;
+
+    parser.next();
+    auto tok = parser.next();
+    BOOST_CHECK_EQUAL(Token::RAW_NUMBER, tok.type);
+    BOOST_CHECK(tok.val_raw.is_integer());
+    BOOST_CHECK(!tok.val_raw.negative());
+    BOOST_CHECK(tok.val_raw.to_int(&i));
+    BOOST_CHECK_EQUAL(0, i);
+
+    parser.next();
+    auto raw = parser.next().val_raw;
+    BOOST_CHECK_EQUAL("-12", raw.to_string());
+    BOOST_CHECK(raw.negative());
+    BOOST_CHECK(raw.to_int(&i));
+    BOOST_CHECK_EQUAL(-12, i);
+    BOOST_CHECK(!raw.to_uint(&u));
+
+    parser.next();
+    raw = parser.next().val_raw;
+    BOOST_CHECK(!raw.to_int(&i));
+    BOOST_CHECK(raw.to_uint(&u));
+    BOOST_CHECK_EQUAL(18446744073709551615ULL, u);
+
+    parser.next();
+    raw = parser.next().val_raw;
+    BOOST_CHECK(!raw.to_uint(&u));
+    BOOST_CHECK(raw.to_double(&d));
+    BOOST_CHECK_EQUAL(18446744073709551616.0, d);
+    BOOST_CHECK_EQUAL("18446744073709551616", raw.to_string());
+
+    parser.next();
+    raw = parser.next().val_raw;
+    BOOST_CHECK(raw.to_int(&i));
+    BOOST_CHECK_EQUAL(std::numeric_limits<long long>::min(), i);
+
+    parser.next();
+    raw = parser.next_raw_number();
+    BOOST_CHECK(!raw.is_integer());
+    BOOST_CHECK(!raw.to_int(&i));
+    BOOST_CHECK(raw.to_double(&d));
+    BOOST_CHECK_EQUAL(1500.0, d);
+    BOOST_CHECK_EQUAL(Token::ARR_END, parser.next().type);
+
+    // converted numbers use the same grammar
+    BOOST_CHECK_EQUAL(1.5e3, parse_single("1.5e3").val_num);
+    BOOST_CHECK_EQUAL(1e5, parse_single("1E+5").val_num);
+    BOOST_CHECK_EQUAL(-0.25, parse_single("-25e-2").val_num);
+    BOOST_CHECK_THROW(parse_single("1.e5"), ParseError);
+    BOOST_CHECK_THROW(parse_single("1e+"), ParseError);
+    BOOST_CHECK_THROW(parse_single("01"), ParseError);
+    BOOST_CHECK_THROW(parse_single("-00.5"), ParseError);
+    BOOST_CHECK_EQUAL(0.5, parse_single("0.5").val_num);
+    BOOST_CHECK_EQUAL(0, parse_single("-0").val_int);
+}
+
+BOOST_AUTO_TEST_CASE(double_conversion)
+{
+    // every conversion path must give the same result as strtod
+    const char *values[] = {
+        "0", "-0", "0.0", "1", "-1", "0.1", "0.3", "123.456", "-122.41941550000001", "37.7749295",
+        "1e22", "1e23", "1e-22", "1e-23", "123456789012345", "1234567890123456", "9007199254740993",
+        "0.000001234", "4.9e-324", "2.2250738585072014e-308", "1.7976931348623157e308",
+        "3.141592653589793238462643383279", "100000000000000000000000", "0.1e1", "10e-1"
+    };
+    for (auto str : values)
+    {
+        RawNumber raw = { str, (unsigned)strlen(str), str[0] == '-' ? (unsigned)RawNumber::NEGATIVE : 0U };
+        for (auto c = str; *c; ++c)
+        {
+            if (*c == '.') raw.flags |= RawNumber::FRACTION;
+            else if (*c == 'e') raw.flags |= RawNumber::EXPONENT;
+        }
+        double d;
+        BOOST_CHECK(raw.to_double(&d));
+        double expected = std::strtod(str, nullptr);
+        BOOST_CHECK_MESSAGE(memcmp(&d, &expected, sizeof(d)) == 0, str);
+    }
+    std::stringstream ss;
+    ss << std::setprecision(17);
+    unsigned long long seed = 1;
+    for (int i = 0; i < 1000; ++i)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        double x = (double)(seed >> 11) / (double)(1ULL << (seed % 40));
+        ss.str("");
+        ss << x;
+        auto str = ss.str();
+        auto tok = parse_single(str);
+        BOOST_CHECK_EQUAL(x, tok.type == Token::NUMBER ? tok.val_num : (double)tok.val_int);
+    }
+
+    double d;
+    RawNumber big = { "1e400", 5, RawNumber::EXPONENT };
+    BOOST_CHECK(!big.to_double(&d));
+    BOOST_CHECK_EQUAL(std::numeric_limits<double>::infinity(), d);
+    RawNumber small = { "1e-400", 6, RawNumber::EXPONENT };
+    BOOST_CHECK(!small.to_double(&d));
+    BOOST_CHECK_EQUAL(0.0, d);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,8 +1,12 @@
 #include <boost/test/unit_test.hpp>
 #include "Reader.hpp"
+#include "Writer.hpp"
+#include <array>
 #include <unordered_map>
 #include <vector>
 #include <limits>
+#include <map>
+#include <memory_resource>
 
 using namespace json;
 struct MyType
@@ -53,6 +57,29 @@ inline void read_json(Parser &parser, Comment *val)
     reader.read(parser, val);
 }
 
+struct PmrType
+{
+    typedef std::pmr::polymorphic_allocator<char> allocator_type;
+    explicit PmrType(const allocator_type &alloc = {}) : name(alloc), tags(alloc) {}
+
+    std::pmr::string name;
+    std::pmr::vector<std::pmr::string> tags;
+};
+inline void read_json(Parser &parser, PmrType *val)
+{
+    static const auto reader = ObjectFieldReader<PmrType>().
+        add<decltype(PmrType::name), &PmrType::name>("name").
+        add<decltype(PmrType::tags), &PmrType::tags>("tags");
+    reader.read(parser, val);
+}
+template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const PmrType &val)
+{
+    writer.start_obj();
+    writer.prop("name", val.name);
+    writer.prop("tags", val.tags);
+    writer.end_obj();
+}
+
 BOOST_AUTO_TEST_SUITE(TestReader)
 
 BOOST_AUTO_TEST_CASE(integers)
@@ -102,6 +129,9 @@ BOOST_AUTO_TEST_CASE(primitives)
 
     BOOST_CHECK_EQUAL(100.5, read_json<float>("100.5"));
     BOOST_CHECK_THROW(read_json<float>("true"), ParseError);
+    BOOST_CHECK_THROW(read_json<float>("1e300"), ParseError);
+    BOOST_CHECK_THROW(read_json<float>("-1e39"), ParseError);
+    BOOST_CHECK_EQUAL(std::numeric_limits<float>::max(), read_json<float>("3.4028234663852886e38"));
     
     BOOST_CHECK_EQUAL(100.5, read_json<double>("100.5"));
     BOOST_CHECK_THROW(read_json<double>("true"), ParseError);
@@ -140,6 +170,77 @@ BOOST_AUTO_TEST_CASE(arr)
     BOOST_CHECK_THROW(read_json("[5,]", &parsed), ParseError);
     BOOST_CHECK_THROW(read_json("[5}", &parsed), ParseError);
 
+    // back() is a proxy, so elements are read then pushed
+    auto bools = read_json<std::vector<bool>>("[true, false, true]");
+    BOOST_CHECK((std::vector<bool>{ true, false, true }) == bools);
+
+    // an element that fails to read is not left in the container
+    std::vector<std::string> strs;
+    BOOST_CHECK(!try_read_json("[\"a\", 5]", &strs));
+    BOOST_CHECK_EQUAL(1U, strs.size());
+    strs.clear();
+    BOOST_CHECK_THROW(read_json("[\"a\", \"b]", &strs), ParseError);
+    BOOST_CHECK_EQUAL(1U, strs.size());
+
+    // nor is a map entry whose value fails to read
+    std::map<std::string, int> map;
+    BOOST_CHECK(!try_read_json("{\"a\": 1, \"b\": \"x\"}", &map));
+    BOOST_CHECK_EQUAL(1U, map.size());
+    BOOST_CHECK_EQUAL(1U, map.count("a"));
+    map.clear();
+    BOOST_CHECK_THROW(read_json("{\"a\": 1, \"b\": [}", &map), ParseError);
+    BOOST_CHECK_EQUAL(1U, map.size());
+}
+
+BOOST_AUTO_TEST_CASE(number_arrays)
+{
+    auto doubles = json::read_json<std::vector<double>>("[ 1.5, -2 ,3e2,0.1, 1234567.890123456789 ]");
+    BOOST_CHECK((std::vector<double>{ 1.5, -2, 300, 0.1, 1234567.890123456789 }) == doubles);
+    BOOST_CHECK(json::read_json<std::vector<double>>("[]").empty());
+    BOOST_CHECK(json::read_json<std::vector<float>>("[0.5, 2]") == (std::vector<float>{ 0.5f, 2.0f }));
+    BOOST_CHECK(json::read_json<std::vector<long long>>("[1,-9223372036854775808, 9223372036854775807]") ==
+        (std::vector<long long>{ 1, std::numeric_limits<long long>::min(), std::numeric_limits<long long>::max() }));
+    BOOST_CHECK(json::read_json<std::vector<unsigned>>("[0, 4294967295]") == (std::vector<unsigned>{ 0, 4294967295U }));
+
+    auto points = json::read_json<std::vector<std::array<double, 2>>>("[[1, 2], [ -3.5 , 4 ],[5,6]]");
+    BOOST_CHECK_EQUAL(3U, points.size());
+    BOOST_CHECK_EQUAL(-3.5, points[1][0]);
+    BOOST_CHECK_EQUAL(6, points[2][1]);
+    auto nested = json::read_json<std::vector<std::vector<double>>>("[[1, 2], [], [3]]");
+    BOOST_CHECK((std::vector<std::vector<double>>{ { 1, 2 }, {}, { 3 } }) == nested);
+
+    std::pmr::monotonic_buffer_resource resource;
+    std::pmr::vector<double> pmr_doubles(&resource);
+    read_json("[1, 2, 3]", &pmr_doubles);
+    BOOST_CHECK_EQUAL(3U, pmr_doubles.size());
+
+    auto error = [](const std::string &json, auto *out)
+    {
+        return try_read_json(json, out).code;
+    };
+    std::vector<double> d;
+    std::vector<float> f;
+    std::vector<int> i;
+    std::vector<unsigned> u;
+    std::vector<std::array<int, 2>> pairs;
+    BOOST_CHECK(ParseErrorCode::EXPECTED_ARRAY == error("5", &d));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_ARRAY == error("", &d));
+    BOOST_CHECK(ParseErrorCode::INVALID_NUMBER == error("[1,]", &d));
+    BOOST_CHECK(ParseErrorCode::INVALID_NUMBER == error("[true]", &d));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_ARRAY_END == error("[1 2]", &d));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_ARRAY_END == error("[1", &d));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_NUMBER == error("[1,", &d));
+    BOOST_CHECK(ParseErrorCode::INVALID_NUMBER == error("[1e]", &d));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_ARRAY_END == error("[1.5]", &i));
+    BOOST_CHECK(ParseErrorCode::NUMBER_OVERFLOW == error("[2147483648]", &i));
+    BOOST_CHECK(ParseErrorCode::NUMBER_OVERFLOW == error("[1e300]", &f));
+    BOOST_CHECK(ParseErrorCode::NUMBER_OVERFLOW == error("[1, -1e300]", &f));
+    BOOST_CHECK_EQUAL(4U, try_read_json("[1, -1e300]", &f).offset);
+    BOOST_CHECK(ParseErrorCode::EXPECTED_INT == error("[-1]", &u));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_VALUE == error("[[1]]", &pairs));
+    BOOST_CHECK(ParseErrorCode::CAPACITY_EXCEEDED == error("[[1, 2, 3]]", &pairs));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_ARRAY == error("[1]", &pairs));
+    BOOST_CHECK(ParseErrorCode::EXPECTED_ARRAY_END == error("[[1 2]]", &pairs));
 }
 
 BOOST_AUTO_TEST_CASE(map)
@@ -227,6 +328,45 @@ BOOST_AUTO_TEST_CASE(obj_complex)
     }
 }
 
+BOOST_AUTO_TEST_CASE(memory_resource)
+{
+    char buffer[4096];
+    std::pmr::monotonic_buffer_resource pool(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    const std::string long_str = "a string too long for the small string optimisation";
+
+    auto map = read_json<std::pmr::map<std::pmr::string, std::pmr::vector<std::pmr::string>>>(
+        "{\"" + long_str + "\": [\"" + long_str + "\", \"b\"], \"empty\": []}", &pool);
+    BOOST_CHECK(map.get_allocator().resource() == &pool);
+    BOOST_CHECK_EQUAL(2, map.size());
+    auto &arr = map[std::pmr::string(long_str, &pool)];
+    BOOST_CHECK(arr.get_allocator().resource() == &pool);
+    BOOST_CHECK_EQUAL(2, arr.size());
+    if (arr.size() == 2)
+    {
+        BOOST_CHECK_EQUAL(long_str, arr[0].c_str());
+        BOOST_CHECK(arr[0].get_allocator().resource() == &pool);
+        BOOST_CHECK_EQUAL("b", arr[1].c_str());
+    }
+    BOOST_CHECK(map.begin()->first.get_allocator().resource() == &pool);
+
+    std::string json = "{\"name\": \"" + long_str + "\", \"tags\": [\"" + long_str + "\"]}";
+    Parser parser(json.data(), json.data() + json.size(), &pool);
+    auto obj = read_json<PmrType>(parser);
+    BOOST_CHECK_EQUAL(long_str, obj.name.c_str());
+    BOOST_CHECK(obj.name.get_allocator().resource() == &pool);
+    BOOST_CHECK_EQUAL(1, obj.tags.size());
+    BOOST_CHECK(obj.tags.get_allocator().resource() == &pool);
+    if (obj.tags.size() == 1) BOOST_CHECK(obj.tags[0].get_allocator().resource() == &pool);
+
+    // pmr strings are written as strings, not arrays of chars
+    BOOST_CHECK_EQUAL("\"abc\"", to_json(std::pmr::string("abc")));
+    auto written = to_json(obj);
+    BOOST_CHECK_EQUAL("{\"name\":\"" + long_str + "\",\"tags\":[\"" + long_str + "\"]}", written);
+    auto obj2 = read_json<PmrType>(written);
+    BOOST_CHECK_EQUAL(long_str, obj2.name.c_str());
+    BOOST_CHECK_EQUAL(written, to_json(obj2));
+}
+
 int parse_skip_first(const std::string &json)
 {
     Parser parser(json.data(), json.data() + json.size());
@@ -242,7 +382,123 @@ BOOST_AUTO_TEST_CASE(skip)
     BOOST_CHECK_EQUAL(5, parse_skip_first("[1, 2, 3], 5"));
     BOOST_CHECK_EQUAL(5, parse_skip_first("[1, [2, 3]], 5"));
     BOOST_CHECK_EQUAL(5, parse_skip_first("{}, 5"));
+    BOOST_CHECK_EQUAL(5, parse_skip_first("{\"a\": [{\"b\": []}, 1], \"c\": {}}, 5"));
     BOOST_CHECK_THROW(parse_skip_first(""), ParseError);
+    BOOST_CHECK_THROW(parse_skip_first("]"), ParseError);
+    BOOST_CHECK_THROW(parse_skip_first("[}, 5"), ParseError);
+    BOOST_CHECK_THROW(parse_skip_first("{\"a\": 1], 5"), ParseError);
+    BOOST_CHECK_THROW(parse_skip_first("{1: 1}, 5"), ParseError);
+    BOOST_CHECK_THROW(parse_skip_first("[1 2], 5"), ParseError);
+
+    std::string deep = std::string(100000, '[') + std::string(100000, ']');
+    Parser parser(deep.data(), deep.data() + deep.size());
+    parser.throw_errors(false);
+    skip_value(parser);
+    BOOST_CHECK(ParseErrorCode::DEPTH_EXCEEDED == parser.result().code);
+}
+
+namespace recursive
+{
+    struct Tree
+    {
+        std::vector<Tree> children;
+    };
+    void read_json(Parser &parser, Tree *tree)
+    {
+        read_json(parser, &tree->children);
+    }
+    struct Branch
+    {
+        std::map<std::string, Branch> named;
+    };
+    void read_json(Parser &parser, Branch *branch)
+    {
+        static const auto reader = ObjectFieldReader<Branch>().
+            add<decltype(Branch::named), &Branch::named>("named");
+        reader.read(parser, branch);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(depth)
+{
+    using recursive::Tree;
+    using recursive::Branch;
+    // self-referential types recurse as deep as the input
+    Tree tree;
+    BOOST_CHECK(try_read_json("[[], [[]]]", &tree));
+    BOOST_CHECK_EQUAL(2U, tree.children.size());
+    std::string deep(2000000, '[');
+    BOOST_CHECK(ParseErrorCode::DEPTH_EXCEEDED == try_read_json(deep, &tree).code);
+    BOOST_CHECK_THROW(read_json<Tree>(deep), ParseError);
+
+    Branch branch;
+    BOOST_CHECK(try_read_json("{\"named\": {\"a\": {\"named\": {}}}}", &branch));
+    std::string named;
+    for (int i = 0; i < 1000000; ++i) named += "{\"named\": {\"a\": ";
+    BOOST_CHECK(ParseErrorCode::DEPTH_EXCEEDED == try_read_json(named, &branch).code);
+
+    std::vector<std::vector<std::array<std::string, 1>>> arrays;
+    std::string json = "[[[\"a\"]], []]";
+    Parser parser(json.data(), json.data() + json.size());
+    parser.max_depth(2);
+    BOOST_CHECK_THROW(read_json(parser, &arrays), ParseError);
+    arrays.clear();
+    parser = Parser(json.data(), json.data() + json.size());
+    parser.max_depth(3);
+    read_json(parser, &arrays);
+    BOOST_CHECK_EQUAL(2U, arrays.size());
+}
+
+BOOST_AUTO_TEST_CASE(try_read)
+{
+    MyType obj;
+    auto result = try_read_json("{\"x\": 0, \"y\": 10, \"z\": -5}", &obj);
+    BOOST_CHECK(result);
+    BOOST_CHECK_EQUAL(-5, obj.z);
+
+    auto error = [](const std::string &json)
+    {
+        MyType obj;
+        return try_read_json(json, &obj);
+    };
+    BOOST_CHECK(ParseErrorCode::EXPECTED_OBJECT == error("5").code);
+    BOOST_CHECK(ParseErrorCode::MISSING_KEYS == error("{}").code);
+    BOOST_CHECK(ParseErrorCode::MISSING_KEYS == error("{\"x\": 0, \"y\": 10}").code);
+    BOOST_CHECK(ParseErrorCode::EXPECTED_INT == error("{\"x\": 0, \"y\": true, \"z\": -5}").code);
+    BOOST_CHECK(ParseErrorCode::DUPLICATE_KEY == error("{\"x\": 0, \"y\": 10, \"x\": 15}").code);
+    BOOST_CHECK(ParseErrorCode::EXPECTED_STRING == error("{\"x\": 0, 7: 15}").code);
+    BOOST_CHECK(ParseErrorCode::EXPECTED_END == error("{\"x\": 0, \"y\": 10, \"z\": -5} 5").code);
+    result = error("{\"x\": 0, \"y\": 10, \"w\": 1}");
+    BOOST_CHECK(ParseErrorCode::UNKNOWN_KEY == result.code);
+    BOOST_CHECK_EQUAL(22, result.offset);
+    BOOST_CHECK_EQUAL("1:22 Unknown key", result.message());
+
+    try
+    {
+        read_json<MyType>("{\"x\": 0, \"y\": 10, \"w\": 1}");
+        BOOST_FAIL("Expected ParseError");
+    }
+    catch (const ParseError &e)
+    {
+        BOOST_CHECK(ParseErrorCode::UNKNOWN_KEY == e.code());
+        BOOST_CHECK_EQUAL("1:22 Unknown key w", e.what());
+    }
+
+    std::vector<int> arr;
+    BOOST_CHECK(ParseErrorCode::EXPECTED_ARRAY_END == try_read_json("[1, 2 3]", &arr).code);
+
+    // every truncation of a valid document fails without throwing
+    std::string json =
+        "{\"total\": 102, \"first\": 100, \"data\": [{\"author\": \"Ben\", \"time\": \"2016-06-24T09:47:55Z\","
+        " \"text\": \"Hi \\u00e9\"}, {\"author\": \"Tim\", \"time\": \"2016-06-24T09:47:55Z\", \"text\": \"\","
+        " \"admin\": [true, {\"a\": [1.5]}]}]}";
+    ResponsePage<Comment> page;
+    BOOST_CHECK(try_read_json(json, &page));
+    for (size_t len = 0; len < json.size(); ++len)
+    {
+        ResponsePage<Comment> page;
+        BOOST_CHECK(!try_read_json(json.substr(0, len), &page));
+    }
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,101 @@
+#include <boost/test/unit_test.hpp>
+#include "Copy.hpp"
+#include "Reader.hpp"
+#include "Writer.hpp"
+#include <vector>
+
+using namespace json;
+
+namespace
+{
+    struct Point
+    {
+        int x, y;
+    };
+    template<typename Stats> void read_json(BasicParser<Stats> &parser, Point *val)
+    {
+        typedef ObjectFieldReader<Point, IgnoreUnknown, BasicParser<Stats>> Reader;
+        static const auto reader = Reader().
+            template add<decltype(Point::x), &Point::x>("x").
+            template add<decltype(Point::y), &Point::y>("y");
+        reader.read(parser, val);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(TestStats)
+
+BOOST_AUTO_TEST_CASE(parser)
+{
+    StatsData data;
+    std::string json = "[\"a\", \"b\\n\", 5, -2.5, true]";
+    {
+        BasicParser<CountStats> parser(json.data(), json.data() + json.size(),
+            std::pmr::get_default_resource(), CountStats(&data));
+        while (parser.next().type != Token::END);
+        BOOST_CHECK_EQUAL(0, data.bytes); // reported by destructor
+    }
+    BOOST_CHECK_EQUAL(json.size(), data.bytes);
+    BOOST_CHECK_EQUAL(12, data.tokens);
+    BOOST_CHECK_EQUAL(2, data.strings);
+    BOOST_CHECK_EQUAL(1, data.escaped_strings);
+    BOOST_CHECK_EQUAL(1, data.integers);
+    BOOST_CHECK_EQUAL(1, data.floats);
+    BOOST_CHECK_EQUAL(0, data.unknown_keys);
+}
+
+BOOST_AUTO_TEST_CASE(reader)
+{
+    StatsData data;
+    {
+        std::string json = "[{\"x\": 1, \"y\": 2}, {\"x\": 3, \"z\": \"unknown\", \"y\": 4}]";
+        BasicParser<TimedStats> parser(json.data(), json.data() + json.size(),
+            std::pmr::get_default_resource(), TimedStats(&data));
+        auto points = read_json<std::vector<Point>>(parser);
+        BOOST_CHECK_EQUAL(2, points.size());
+        BOOST_CHECK_EQUAL(Token::END, parser.next().type);
+    }
+    BOOST_CHECK_EQUAL(1, data.unknown_keys);
+    BOOST_CHECK_EQUAL(4, data.integers);
+    BOOST_CHECK_EQUAL(6, data.strings);
+    BOOST_CHECK(data.category_time(StatsCategory::STRING).count() >= 0);
+
+    StatsData total;
+    total += data;
+    total += data;
+    BOOST_CHECK_EQUAL(2, total.unknown_keys);
+}
+
+BOOST_AUTO_TEST_CASE(writer)
+{
+    StatsData data;
+    BasicWriter<CountStats> writer((CountStats(&data)));
+    writer.start_obj();
+    writer.prop("a", std::vector<int>{1, 2});
+    writer.prop("b", "x\ty");
+    writer.prop("c", 0.5);
+    writer.end_obj();
+    BOOST_CHECK_EQUAL("{\"a\":[1,2],\"b\":\"x\\ty\",\"c\":0.5}", writer.str());
+    BOOST_CHECK_EQUAL(writer.str().size(), data.bytes);
+    BOOST_CHECK_EQUAL(9, data.tokens);
+    BOOST_CHECK_EQUAL(4, data.strings);
+    BOOST_CHECK_EQUAL(1, data.escaped_strings);
+    BOOST_CHECK_EQUAL(2, data.integers);
+    BOOST_CHECK_EQUAL(1, data.floats);
+    BOOST_CHECK(data.allocations > 0);
+}
+
+BOOST_AUTO_TEST_CASE(copy)
+{
+    StatsData in, out;
+    std::string json = "{\"a\": [1, \"b\"]}";
+    BasicParser<CountStats> parser(json.data(), json.data() + json.size(),
+        std::pmr::get_default_resource(), CountStats(&in));
+    BasicWriter<CountStats> writer((CountStats(&out)));
+    json::copy(writer, parser);
+    BOOST_CHECK_EQUAL("{\"a\":[1,\"b\"]}", writer.str());
+    BOOST_CHECK_EQUAL(2, in.strings);
+    BOOST_CHECK_EQUAL(2, out.strings);
+    BOOST_CHECK_EQUAL(writer.str().size(), out.bytes);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,5 +1,7 @@
 #include <boost/test/unit_test.hpp>
 #include "Time.hpp"
+#include "Reader.hpp"
+#include "Writer.hpp"
 
 using namespace json;
 
@@ -8,11 +10,36 @@ BOOST_AUTO_TEST_SUITE(TestTime)
 BOOST_AUTO_TEST_CASE(to_string)
 {
     BOOST_CHECK_EQUAL("2016-06-24T09:47:55Z", time_to_iso_str(1466761675));
+    BOOST_CHECK_EQUAL("1970-01-01T00:00:00Z", time_to_iso_str(0));
+    BOOST_CHECK_EQUAL("1969-12-31T23:59:59Z", time_to_iso_str(-1));
+    BOOST_CHECK_EQUAL("1900-01-01T00:00:00Z", time_to_iso_str(-2208988800LL));
+    BOOST_CHECK_EQUAL("2000-02-29T12:00:00Z", time_to_iso_str(951825600));
+    BOOST_CHECK_EQUAL("3000-12-31T23:59:59Z", time_to_iso_str(32535215999LL));
+
+    using namespace std::chrono;
+    auto t = system_clock::time_point(duration_cast<system_clock::duration>(seconds(1466761675)));
+    BOOST_CHECK_EQUAL("2016-06-24T09:47:55Z", time_to_iso_str(time_point_cast<seconds>(t)));
+    BOOST_CHECK_EQUAL("2016-06-24T09:47:55.000Z", time_to_iso_str(time_point_cast<milliseconds>(t)));
+    auto t2 = time_point_cast<nanoseconds>(t) + nanoseconds(123456789);
+    BOOST_CHECK_EQUAL("2016-06-24T09:47:55.123Z", time_to_iso_str(time_point_cast<milliseconds>(t2)));
+    BOOST_CHECK_EQUAL("2016-06-24T09:47:55.123456Z", time_to_iso_str(time_point_cast<microseconds>(t2)));
+    BOOST_CHECK_EQUAL("2016-06-24T09:47:55.123456789Z", time_to_iso_str(t2));
+    auto before_epoch = time_point<system_clock, milliseconds>(milliseconds(-1));
+    BOOST_CHECK_EQUAL("1969-12-31T23:59:59.999Z", time_to_iso_str(before_epoch));
 }
 
 BOOST_AUTO_TEST_CASE(parse)
 {
     BOOST_CHECK_EQUAL(1466761675, parse_iso_time("2016-06-24T09:47:55Z"));
+    BOOST_CHECK_EQUAL(1466761675, parse_iso_time("2016-06-24T09:47:55"));
+    BOOST_CHECK_EQUAL(1466761675, parse_iso_time("2016-06-24T09:47:55.999Z"));
+    BOOST_CHECK_EQUAL(1466761675, parse_iso_time("2016-06-24T11:17:55+01:30"));
+    BOOST_CHECK_EQUAL(1466761675, parse_iso_time("2016-06-24T08:47:55-01:00"));
+    BOOST_CHECK_EQUAL(1466761675, parse_iso_time("2016-06-24T09:47:55.5+00:00"));
+    BOOST_CHECK_EQUAL(-2208988800LL, parse_iso_time("1900-01-01T00:00:00Z"));
+    BOOST_CHECK_EQUAL(951825600, parse_iso_time("2000-02-29T12:00:00Z"));
+    BOOST_CHECK_EQUAL(1466761676, parse_iso_time("2016-06-24T09:47:56Z"));
+    BOOST_CHECK_EQUAL(1466761680, parse_iso_time("2016-06-24T09:47:60Z")); // leap second, as 09:48:00
 
     BOOST_CHECK_THROW(parse_iso_time(""), std::runtime_error);
     BOOST_CHECK_THROW(parse_iso_time("2016-06-24"), std::runtime_error);
@@ -33,9 +60,65 @@ BOOST_AUTO_TEST_CASE(parse)
     BOOST_CHECK_THROW(parse_iso_time("2016-06-24T09:47:-1Z"), std::runtime_error);
 
     BOOST_CHECK_THROW(parse_iso_time("2016-06-24T09:47:55+01"), std::runtime_error);
-    BOOST_CHECK_THROW(parse_iso_time("2016-06-24T09:47:55+01:30"), std::runtime_error);
+    BOOST_CHECK_THROW(parse_iso_time("2016-06-24T09:47:55+1:30"), std::runtime_error);
+    BOOST_CHECK_THROW(parse_iso_time("2016-06-24T09:47:55+24:00"), std::runtime_error);
+    BOOST_CHECK_THROW(parse_iso_time("2016-06-24T09:47:55+01:30Z"), std::runtime_error);
+    BOOST_CHECK_THROW(parse_iso_time("2016-06-24T09:47:55Z "), std::runtime_error);
+    BOOST_CHECK_THROW(parse_iso_time("2016-06-24T09:47:55.Z"), std::runtime_error);
+    BOOST_CHECK_THROW(parse_iso_time("2016-06-24T09:47:55,5Z"), std::runtime_error);
+    BOOST_CHECK_THROW(parse_iso_time("2015-02-29T09:47:55Z"), std::runtime_error);
+    BOOST_CHECK_THROW(parse_iso_time("2016-04-31T09:47:55Z"), std::runtime_error);
+    BOOST_CHECK_THROW(parse_iso_time("2016-06-24 09:47:55Z"), std::runtime_error);
     BOOST_CHECK_THROW(parse_iso_time("2016-06-24T09:47:55+0130"), std::runtime_error);
     BOOST_CHECK_THROW(parse_iso_time("2016-06-24T09:47:55-01"), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(parse_time_point)
+{
+    using namespace std::chrono;
+    auto t = parse_iso_time_point<nanoseconds>("2016-06-24T09:47:55.123456789Z");
+    BOOST_CHECK_EQUAL(1466761675123456789LL, t.time_since_epoch().count());
+    BOOST_CHECK_EQUAL(1466761675123LL, parse_iso_time_point<milliseconds>("2016-06-24T09:47:55.1239Z").time_since_epoch().count());
+    BOOST_CHECK_EQUAL(1466761675100000LL, parse_iso_time_point<microseconds>("2016-06-24T09:47:55.1Z").time_since_epoch().count());
+    BOOST_CHECK_EQUAL(1466761675123456789LL,
+        parse_iso_time_point<nanoseconds>("2016-06-24T09:47:55.1234567891234Z").time_since_epoch().count());
+    BOOST_CHECK_THROW(parse_iso_time_point<milliseconds>("2016-06-24T09:47:55.12a"), std::runtime_error);
+
+    for (auto str : { "1969-12-31T23:59:59.999Z", "2016-06-24T09:47:55.001Z", "2999-01-01T00:00:00.000Z" })
+    {
+        BOOST_CHECK_EQUAL(str, time_to_iso_str(parse_iso_time_point<milliseconds>(str)));
+    }
+
+    // nanoseconds in a 64 bit count only reach 2262-04-11
+    BOOST_CHECK_THROW(parse_iso_time_point<nanoseconds>("2300-01-01T00:00:00Z"), std::runtime_error);
+    BOOST_CHECK_EQUAL("2300-01-01T00:00:00.000Z", time_to_iso_str(parse_iso_time_point<milliseconds>("2300-01-01T00:00:00Z")));
+}
+
+BOOST_AUTO_TEST_CASE(read_write)
+{
+    using namespace std::chrono;
+    typedef time_point<system_clock, milliseconds> Time;
+    auto times = read_json<std::vector<Time>>("[\"2016-06-24T09:47:55.5Z\", \"2016-06-24T10:47:55+01:00\"]");
+    BOOST_CHECK_EQUAL(2, times.size());
+    BOOST_CHECK_EQUAL(1466761675500LL, times[0].time_since_epoch().count());
+    BOOST_CHECK_EQUAL(1466761675000LL, times[1].time_since_epoch().count());
+    BOOST_CHECK_EQUAL("[\"2016-06-24T09:47:55.500Z\",\"2016-06-24T09:47:55.000Z\"]", to_json(times));
+
+    typedef time_point<system_clock, nanoseconds> NanoTime;
+    try
+    {
+        read_json<NanoTime>("\"2300-01-01T00:00:00Z\"");
+        BOOST_FAIL("Expected ParseError");
+    }
+    catch (const ParseError &e)
+    {
+        BOOST_CHECK(e.code() == ParseErrorCode::INVALID_TIME);
+    }
+    BOOST_CHECK_EQUAL(1, read_json<std::vector<NanoTime>>("[\"2262-04-11T00:00:00Z\"]").size());
+
+    Writer writer;
+    write_json_time(writer, 1466761675);
+    BOOST_CHECK_EQUAL("\"2016-06-24T09:47:55Z\"", writer.str());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
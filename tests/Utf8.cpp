@@ -0,0 +1,62 @@
+#include <boost/test/unit_test.hpp>
+#include "Utf8.hpp"
+#include <string>
+
+using namespace json;
+
+BOOST_AUTO_TEST_SUITE(TestUtf8)
+
+namespace
+{
+    bool valid(const std::string &str)
+    {
+        return is_valid_utf8(str.data(), str.data() + str.size());
+    }
+    /**Offset of the first invalid byte, or size if none.*/
+    size_t invalid_at(const std::string &str)
+    {
+        return (size_t)(find_invalid_utf8(str.data(), str.data() + str.size()) - str.data());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(valid_sequences)
+{
+    BOOST_CHECK(valid(""));
+    BOOST_CHECK(valid("Hello World"));
+    BOOST_CHECK(valid(std::string(1000, 'x')));
+    BOOST_CHECK(valid("\x7F"));
+    BOOST_CHECK(valid("\xC2\x80"));
+    BOOST_CHECK(valid("\xDF\xBF"));
+    BOOST_CHECK(valid("\xE0\xA0\x80"));
+    BOOST_CHECK(valid("\xED\x9F\xBF"));
+    BOOST_CHECK(valid("\xEE\x80\x80"));
+    BOOST_CHECK(valid("\xEF\xBF\xBF"));
+    BOOST_CHECK(valid("\xF0\x90\x80\x80"));
+    BOOST_CHECK(valid("\xF4\x8F\xBF\xBF"));
+    BOOST_CHECK(valid(std::string(20, 'x') + "\xE2\x82\xAC" + std::string(20, 'x') + "\xF0\x9F\x98\x80"));
+}
+
+BOOST_AUTO_TEST_CASE(invalid_sequences)
+{
+    BOOST_CHECK_EQUAL(0U, invalid_at("\x80"));
+    BOOST_CHECK_EQUAL(0U, invalid_at("\xBF"));
+    BOOST_CHECK_EQUAL(0U, invalid_at("\xC0\x80")); // overlong
+    BOOST_CHECK_EQUAL(0U, invalid_at("\xC1\xBF")); // overlong
+    BOOST_CHECK_EQUAL(0U, invalid_at("\xE0\x9F\xBF")); // overlong
+    BOOST_CHECK_EQUAL(0U, invalid_at("\xF0\x8F\xBF\xBF")); // overlong
+    BOOST_CHECK_EQUAL(0U, invalid_at("\xED\xA0\x80")); // high surrogate
+    BOOST_CHECK_EQUAL(0U, invalid_at("\xED\xBF\xBF")); // low surrogate
+    BOOST_CHECK_EQUAL(0U, invalid_at("\xF4\x90\x80\x80")); // > U+10FFFF
+    BOOST_CHECK_EQUAL(0U, invalid_at("\xF5\x80\x80\x80"));
+    BOOST_CHECK_EQUAL(0U, invalid_at("\xFF"));
+    BOOST_CHECK_EQUAL(1U, invalid_at("x\xC2")); // truncated
+    BOOST_CHECK_EQUAL(1U, invalid_at("x\xE2\x82"));
+    BOOST_CHECK_EQUAL(1U, invalid_at("x\xE2\x82x"));
+    BOOST_CHECK_EQUAL(1U, invalid_at("x\xF0\x9F\x98x"));
+    // found after and within the ASCII fast path
+    BOOST_CHECK_EQUAL(32U, invalid_at(std::string(32, 'x') + "\xFF"));
+    BOOST_CHECK_EQUAL(21U, invalid_at(std::string(21, 'x') + "\x80" + std::string(40, 'x')));
+    BOOST_CHECK_EQUAL(18U, invalid_at(std::string(15, 'x') + "\xC2\xA3x\xC2" + std::string(40, 'x')));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,96 @@
+#include <boost/test/unit_test.hpp>
+#include "Validate.hpp"
+
+using namespace json;
+
+BOOST_AUTO_TEST_SUITE(TestValidate)
+
+BOOST_AUTO_TEST_CASE(valid)
+{
+    BOOST_CHECK(validate("0"));
+    BOOST_CHECK(validate(" -0.5e+10 "));
+    BOOST_CHECK(validate("12.25E-3"));
+    BOOST_CHECK(validate("true"));
+    BOOST_CHECK(validate("false"));
+    BOOST_CHECK(validate("\r\n\tnull\n"));
+    BOOST_CHECK(validate("\"\""));
+    BOOST_CHECK(validate("\"Hello World, a string long enough for several SIMD blocks\""));
+    BOOST_CHECK(validate("\"\\\" \\\\ \\/ \\b \\f \\n \\r \\t \\u00aF\""));
+    BOOST_CHECK(validate("\"\xC2\xA3\""));
+    BOOST_CHECK(validate("[]"));
+    BOOST_CHECK(validate("{}"));
+    BOOST_CHECK(validate("[ ]"));
+    BOOST_CHECK(validate("{ }"));
+    BOOST_CHECK(validate("[1, \"a\", true, null, [], {}, [[]]]"));
+    BOOST_CHECK(validate("{\"a\": 1, \"b\": {\"c\": [1, {\"d\": {}}]}, \"e\": []}"));
+    BOOST_CHECK(validate(std::string(1000, '[') + std::string(1000, ']')));
+}
+
+BOOST_AUTO_TEST_CASE(invalid)
+{
+    BOOST_CHECK(!validate(""));
+    BOOST_CHECK(!validate("  "));
+    BOOST_CHECK(!validate("1 2"));
+    BOOST_CHECK(!validate("[] []"));
+    BOOST_CHECK(!validate("x"));
+    BOOST_CHECK(!validate("tru"));
+    BOOST_CHECK(!validate("nul"));
+    BOOST_CHECK(!validate("True"));
+    //numbers
+    BOOST_CHECK(!validate("-"));
+    BOOST_CHECK(!validate("01"));
+    BOOST_CHECK(!validate("+1"));
+    BOOST_CHECK(!validate(".5"));
+    BOOST_CHECK(!validate("1."));
+    BOOST_CHECK(!validate("1.e5"));
+    BOOST_CHECK(!validate("1e"));
+    BOOST_CHECK(!validate("1e+"));
+    //strings
+    BOOST_CHECK(!validate("\""));
+    BOOST_CHECK(!validate("\"abc"));
+    BOOST_CHECK(!validate("\"\\\""));
+    BOOST_CHECK(!validate("\"\\'\""));
+    BOOST_CHECK(!validate("\"\\x\""));
+    BOOST_CHECK(!validate("\"\\u00\""));
+    BOOST_CHECK(!validate("\"\\u00G0\""));
+    BOOST_CHECK(!validate("\"tab\tinside\""));
+    BOOST_CHECK(!validate("\"a long string with a newline\n inside, past the first block\""));
+    BOOST_CHECK(!validate(std::string("\"\0\"", 3)));
+    //arrays
+    BOOST_CHECK(!validate("["));
+    BOOST_CHECK(!validate("]"));
+    BOOST_CHECK(!validate("[1"));
+    BOOST_CHECK(!validate("[1,"));
+    BOOST_CHECK(!validate("[,1]"));
+    BOOST_CHECK(!validate("[1,]"));
+    BOOST_CHECK(!validate("[1 2]"));
+    BOOST_CHECK(!validate("[1:2]"));
+    BOOST_CHECK(!validate("[1}"));
+    //objects
+    BOOST_CHECK(!validate("{"));
+    BOOST_CHECK(!validate("}"));
+    BOOST_CHECK(!validate("{1: 2}"));
+    BOOST_CHECK(!validate("{\"a\"}"));
+    BOOST_CHECK(!validate("{\"a\" 1}"));
+    BOOST_CHECK(!validate("{\"a\":}"));
+    BOOST_CHECK(!validate("{\"a\": 1,}"));
+    BOOST_CHECK(!validate("{\"a\": 1 \"b\": 2}"));
+    BOOST_CHECK(!validate("{\"a\": 1]"));
+    BOOST_CHECK(!validate("{\"a\", 1}"));
+    BOOST_CHECK(!validate("[\"a\": 1]"));
+    //depth
+    BOOST_CHECK(!validate(std::string(1025, '[') + std::string(1025, ']')));
+    std::string deep = std::string(100, '[') + std::string(100, ']');
+    BOOST_CHECK(!validate<64>(deep.data(), deep.data() + deep.size()));
+    BOOST_CHECK(validate<100>(deep.data(), deep.data() + deep.size()));
+}
+
+BOOST_AUTO_TEST_CASE(error_pos)
+{
+    std::string json = "{\"a\": [1, 2,, 3]}";
+    const char *pos = nullptr;
+    BOOST_CHECK(!validate(json.data(), json.data() + json.size(), &pos));
+    BOOST_CHECK_EQUAL(12, pos - json.data());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
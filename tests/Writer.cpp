@@ -1,5 +1,7 @@
 #include <boost/test/unit_test.hpp>
 #include "Writer.hpp"
+#include <array>
+#include <limits>
 #include <unordered_map>
 #include <vector>
 
@@ -29,6 +31,9 @@ BOOST_AUTO_TEST_CASE(single)
 
 
     BOOST_CHECK_EQUAL("\"Escaped \\b\\f\\r\\n\\t\\\"\\\\n\"", write_single("Escaped \b\f\r\n\t\"\\n"));
+    // other control characters, and nulls within a std::string
+    BOOST_CHECK_EQUAL("\"a\\u0000b\\u001F\"", write_single(std::string("a\0b\x1f", 4)));
+    BOOST_CHECK_EQUAL(10U, json_size(std::string("a\0b", 3)));
 }
 
 BOOST_AUTO_TEST_CASE(arr)
@@ -49,6 +54,50 @@ BOOST_AUTO_TEST_CASE(arr_helper)
     BOOST_CHECK_EQUAL("[1,3,5]", writer.str());
 }
 
+BOOST_AUTO_TEST_CASE(numbers)
+{
+    // shortest text that reads back exactly
+    BOOST_CHECK_EQUAL("0.1", write_single(0.1));
+    BOOST_CHECK_EQUAL("-0", write_single(-0.0));
+    BOOST_CHECK_EQUAL("1234567.891", write_single(1234567.891));
+    BOOST_CHECK_EQUAL("0.30000000000000004", write_single(0.1 + 0.2));
+    BOOST_CHECK_EQUAL("1e+300", write_single(1e300));
+    BOOST_CHECK_EQUAL("0.1", write_single(0.1f));
+    BOOST_CHECK_EQUAL("-9223372036854775808", write_single(std::numeric_limits<long long>::min()));
+    BOOST_CHECK_EQUAL("18446744073709551615", write_single(std::numeric_limits<unsigned long long>::max()));
+}
+
+BOOST_AUTO_TEST_CASE(number_arrays)
+{
+    BOOST_CHECK_EQUAL("[]", write_single(std::vector<double>()));
+    BOOST_CHECK_EQUAL("[1.5,-2,0.1]", write_single(std::vector<double>{ 1.5, -2, 0.1 }));
+    BOOST_CHECK_EQUAL("[0.5,0.25]", write_single(std::vector<float>{ 0.5f, 0.25f }));
+    BOOST_CHECK_EQUAL("[-1,2,3]", write_single(std::vector<int>{ -1, 2, 3 }));
+    BOOST_CHECK_EQUAL("[4294967295]", write_single(std::vector<unsigned>{ 4294967295U }));
+    BOOST_CHECK_EQUAL("[[1,2],[3,4]]", write_single(std::vector<std::array<double, 2>>{ { 1, 2 }, { 3, 4 } }));
+
+    // more than one chunk, inside other values
+    std::vector<double> values;
+    for (int i = 0; i < 1000; ++i) values.push_back(i * -1.0 / 7);
+    Writer batched;
+    batched.start_obj();
+    batched.prop("a", values);
+    batched.prop("b", 1);
+    batched.end_obj();
+    Writer single;
+    single.start_obj();
+    single.key("a");
+    write_json_array(single, values);
+    single.prop("b", 1);
+    single.end_obj();
+    BOOST_CHECK_EQUAL(single.str(), batched.str());
+    BOOST_CHECK_GT(batched.str().size(), 10000U);
+
+    SizeWriter size;
+    size.value(values);
+    BOOST_CHECK_EQUAL(single.str().size() - 12, size.str().size());
+}
+
 BOOST_AUTO_TEST_CASE(obj)
 {
     Writer writer;
@@ -128,4 +177,65 @@ BOOST_AUTO_TEST_CASE(obj_complex)
         to_json(page));
 }
 
+struct Point
+{
+    double x, y;
+    std::string label;
+};
+template<typename WriterT> if_writer<WriterT> write_json(WriterT &writer, const Point &point)
+{
+    writer.start_obj();
+    writer.prop("x", point.x);
+    writer.prop("y", point.y);
+    writer.prop("label", point.label);
+    writer.end_obj();
+}
+
+BOOST_AUTO_TEST_CASE(size)
+{
+    BOOST_CHECK_EQUAL(4, json_size(true));
+    BOOST_CHECK_EQUAL(5, json_size(12345));
+    BOOST_CHECK_EQUAL(9, json_size("a\"b\nc"));
+    BOOST_CHECK_EQUAL(2, json_size(std::vector<int>()));
+
+    std::vector<Point> points = {
+        { 1.5, -2.25, "first \"point\"" },
+        { 1e100, 0, "tab\tseparated\\" },
+        { 3, 4, std::string(100, 'x') }
+    };
+    auto json = to_json(points);
+    BOOST_CHECK_EQUAL(json.size(), json_size(points));
+
+    auto exact = to_json_exact(points);
+    BOOST_CHECK_EQUAL(json, exact);
+
+    // reserving json_size, as to_json_exact does, means the buffer never grows while writing
+    StatsData data;
+    BasicWriter<CountStats> writer((CountStats(&data)));
+    writer.str().reserve(json_size(points));
+    writer.value(points);
+    BOOST_CHECK_EQUAL(json, writer.str());
+    BOOST_CHECK_EQUAL(0U, data.allocations);
+
+    // to_json_hinted reserves the size of the last output for the type, standard libraries may round up
+    BOOST_CHECK_EQUAL(json, to_json_hinted(points));
+    BOOST_CHECK(to_json_hinted(points).capacity() >= json.size());
+}
+
+BOOST_AUTO_TEST_CASE(size_hint_small_after_large)
+{
+    std::vector<int> large(200000, 12345);
+    auto large_json = to_json_hinted(large);
+    BOOST_CHECK_EQUAL(large_json.size(), json_size(large));
+
+    // a small output after a large one must not keep the large capacity
+    auto small = to_json_hinted(std::vector<int>{1});
+    BOOST_CHECK_EQUAL("[1]", small);
+    BOOST_CHECK(small.capacity() < 1000);
+
+    BOOST_CHECK(to_json(large).size() == large_json.size());
+    small = to_json(std::vector<int>{1});
+    BOOST_CHECK(small.capacity() < 1000);
+}
+
 BOOST_AUTO_TEST_SUITE_END()